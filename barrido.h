@@ -0,0 +1,599 @@
+// barrido.h
+// Barridos de parametros: una grilla o lista de conjuntos de parametros que se
+// resuelven en paralelo sobre un pool de hilos con robo de trabajo
+
+#ifndef BARRIDO_H
+#define BARRIDO_H
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "validacion.h"
+#include "benchmark.h"
+
+// ============================================================================
+// USO
+// ============================================================================
+// Grilla (producto cartesiano; a:b:n son n valores equiespaciados de a a b):
+//   BARRIDO="PASO_H=0.1,0.05,0.025 Y_INICIAL=0:2:5" ./ecuacion1
+// Lista (primera linea con los nombres, luego un conjunto por linea):
+//   BARRIDO_ARCHIVO=conjuntos.txt ./ecuacion1
+// Los parametros que no aparecen toman el valor de su macro. BARRIDO_HILOS
+// fija el numero de hilos (por defecto, los de OpenMP; sin -fopenmp el
+// barrido es secuencial). La tabla sale en pantalla y en BARRIDO_CSV.
+//
+// Cada programa aporta una funcion que resuelve un conjunto sin estado
+// global compartido: VALIDAR queda apagado durante el barrido y un NaN o
+// infinito marca el trabajo como invalido en lugar de terminar el proceso.
+//
+// El barrido pasa dos veces por el pool. En BARRIDO_FASE_METODO la funcion
+// solo integra (pasos, evaluaciones, estado); esa pasada es la que da el
+// tiempo por conjunto, la ocupacion por hilo y la aceleracion. En
+// BARRIDO_FASE_ERROR, para los conjuntos no rechazados, repite la integracion
+// junto a la referencia y llena los errores; su tiempo se informa aparte,
+// porque la referencia de paso h/BARRIDO_REFINAMIENTO cuesta mucho mas que
+// el metodo medido.
+// ============================================================================
+#define BARRIDO_MAX_PARAMETROS  8
+#define BARRIDO_MAX_VALORES     4096    // Valores por parametro en la grilla
+#define BARRIDO_MAX_TRABAJOS    1000000
+#define BARRIDO_MAX_PASOS       1e12    // Pasos por conjunto; con mas se rechaza
+#define BARRIDO_MAX_HILOS       256
+#define BARRIDO_LARGO_NOMBRE    32
+#define BARRIDO_REFINAMIENTO    16      // Subpasos de la solucion de referencia
+#define BARRIDO_CSV             "barrido.csv"
+#define BARRIDO_FILAS_PANTALLA  200     // Filas de la tabla en pantalla (todas en el CSV)
+
+#define BARRIDO_FASE_METODO     0
+#define BARRIDO_FASE_ERROR      1
+
+#define BARRIDO_OK              0
+#define BARRIDO_INVALIDO        1       // NaN, infinito o |valor| > 1e100 en algun paso
+#define BARRIDO_RECHAZADO       2       // Parametros sin sentido (h <= 0, horizonte vacio, demasiados pasos)
+
+typedef struct {
+    int n_parametros;
+    char nombres[BARRIDO_MAX_PARAMETROS][BARRIDO_LARGO_NOMBRE];
+    long n_trabajos;
+    double *valores;                    // n_trabajos x n_parametros, por filas
+} Barrido;
+
+typedef struct {
+    double error_maximo, error_final;
+    long pasos, evaluaciones;
+    double segundos;                    // Solo el metodo (BARRIDO_FASE_METODO)
+    double segundos_referencia;         // Pasada de error con la referencia
+    int hilo;
+    int estado;
+    int con_exacta;                     // 0: error contra la referencia de paso h/BARRIDO_REFINAMIENTO
+} ResultadoBarrido;
+
+// Resuelve un conjunto en la fase indicada. parametros[] sigue el orden de los
+// nombres del programa
+typedef void (*TrabajoBarrido)(const double *parametros, int fase, ResultadoBarrido *r);
+
+typedef struct {
+    int hilos;
+    long robos;
+    double segundos;                    // Tiempo de pared de la fase del metodo
+    double segundos_referencia;         // Tiempo de pared de la fase de error
+    double ocupado_min, ocupado_max;    // Segundos de trabajo por hilo (metodo)
+} EstadisticasBarrido;
+
+// Activa el barrido si BARRIDO o BARRIDO_ARCHIVO estan definidas
+int barrido_solicitado() {
+    const char *grilla = getenv("BARRIDO");
+    const char *archivo = getenv("BARRIDO_ARCHIVO");
+    return (grilla != NULL && grilla[0] != '\0') || (archivo != NULL && archivo[0] != '\0');
+}
+
+// ============================================================================
+// CONJUNTOS DE PARAMETROS
+// ============================================================================
+int barrido_indice(const Barrido *b, const char *nombre) {
+    for (int k = 0; k < b->n_parametros; k++) {
+        if (strcmp(b->nombres[k], nombre) == 0) return k;
+    }
+    printf("ERROR: Parametro de barrido '%s' desconocido (validos:", nombre);
+    for (int k = 0; k < b->n_parametros; k++) printf(" %s", b->nombres[k]);
+    printf(")\n");
+    exit(EXIT_FAILURE);
+}
+
+double barrido_numero(const char *texto, const char *contexto) {
+    char *fin;
+    double v = strtod(texto, &fin);
+    if (fin == texto || *fin != '\0' || !isfinite(v)) {
+        printf("ERROR: Valor '%s' invalido en %s\n", texto, contexto);
+        exit(EXIT_FAILURE);
+    }
+    return v;
+}
+
+// "v1,v2,..." o "a:b:n". Devuelve la cantidad de valores
+int barrido_valores(char *texto, const char *nombre, double *valores) {
+    char *dos_puntos = strchr(texto, ':');
+    if (dos_puntos != NULL) {
+        char *segundo = strchr(dos_puntos + 1, ':');
+        if (segundo == NULL) {
+            printf("ERROR: Rango '%s' de %s: se espera inicio:fin:n\n", texto, nombre);
+            exit(EXIT_FAILURE);
+        }
+        *dos_puntos = '\0';
+        *segundo = '\0';
+        double a = barrido_numero(texto, nombre);
+        double b = barrido_numero(dos_puntos + 1, nombre);
+        double n = barrido_numero(segundo + 1, nombre);
+        if (n < 1 || n > BARRIDO_MAX_VALORES || n != floor(n)) {
+            printf("ERROR: %s: n = %g debe ser entero entre 1 y %d\n", nombre, n, BARRIDO_MAX_VALORES);
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < (int)n; i++) {
+            valores[i] = (n > 1) ? a + (b - a) * i / (n - 1) : a;
+        }
+        return (int)n;
+    }
+
+    int n = 0;
+    for (char *tok = strtok(texto, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        if (n >= BARRIDO_MAX_VALORES) {
+            printf("ERROR: Mas de %d valores para %s\n", BARRIDO_MAX_VALORES, nombre);
+            exit(EXIT_FAILURE);
+        }
+        valores[n++] = barrido_numero(tok, nombre);
+    }
+    if (n == 0) {
+        printf("ERROR: %s sin valores\n", nombre);
+        exit(EXIT_FAILURE);
+    }
+    return n;
+}
+
+void barrido_reservar(Barrido *b, long n_trabajos) {
+    if (n_trabajos < 1 || n_trabajos > BARRIDO_MAX_TRABAJOS) {
+        printf("ERROR: El barrido tiene %ld conjuntos (maximo %d)\n", n_trabajos, BARRIDO_MAX_TRABAJOS);
+        exit(EXIT_FAILURE);
+    }
+    b->n_trabajos = n_trabajos;
+    b->valores = malloc((size_t)n_trabajos * b->n_parametros * sizeof(double));
+    if (b->valores == NULL) {
+        printf("ERROR: Memoria insuficiente para %ld conjuntos\n", n_trabajos);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Producto cartesiano de BARRIDO; el primer parametro varia mas lento
+void barrido_grilla(Barrido *b, const char *especificacion, const double *por_defecto) {
+    static double valores[BARRIDO_MAX_PARAMETROS][BARRIDO_MAX_VALORES];
+    int cantidad[BARRIDO_MAX_PARAMETROS];
+    char *copia = strdup(especificacion);
+
+    for (int k = 0; k < b->n_parametros; k++) {
+        valores[k][0] = por_defecto[k];
+        cantidad[k] = 1;
+    }
+
+    char *resto = copia;
+    for (char *item = strsep(&resto, " ;\t"); item != NULL; item = strsep(&resto, " ;\t")) {
+        if (item[0] == '\0') continue;
+        char *igual = strchr(item, '=');
+        if (igual == NULL) {
+            printf("ERROR: '%s' en BARRIDO: se espera NOMBRE=valores\n", item);
+            exit(EXIT_FAILURE);
+        }
+        *igual = '\0';
+        int k = barrido_indice(b, item);
+        cantidad[k] = barrido_valores(igual + 1, item, valores[k]);
+    }
+    free(copia);
+
+    long total = 1;
+    for (int k = 0; k < b->n_parametros; k++) {
+        total *= cantidad[k];
+        if (total > BARRIDO_MAX_TRABAJOS) break;
+    }
+    barrido_reservar(b, total);
+
+    int indice[BARRIDO_MAX_PARAMETROS] = {0};
+    for (long t = 0; t < total; t++) {
+        for (int k = 0; k < b->n_parametros; k++) {
+            b->valores[t * b->n_parametros + k] = valores[k][indice[k]];
+        }
+        for (int k = b->n_parametros - 1; k >= 0; k--) {
+            if (++indice[k] < cantidad[k]) break;
+            indice[k] = 0;
+        }
+    }
+}
+
+// Lista de BARRIDO_ARCHIVO: nombres en la primera linea (puede empezar con
+// '#', como los .dat), un conjunto por linea, '#' para comentarios
+void barrido_lista(Barrido *b, const char *nombre_archivo, const double *por_defecto) {
+    FILE *archivo = fopen(nombre_archivo, "r");
+    if (archivo == NULL) {
+        printf("ERROR: No se pudo abrir '%s'\n", nombre_archivo);
+        exit(EXIT_FAILURE);
+    }
+
+    char linea[1024];
+    int columnas[BARRIDO_MAX_PARAMETROS], n_columnas = 0;
+    long n_filas = 0, capacidad = 0;
+    double *filas = NULL;
+
+    while (fgets(linea, sizeof(linea), archivo) != NULL) {
+        char *c = linea;
+        while (*c == ' ' || *c == '\t') c++;
+
+        if (n_columnas == 0) {
+            if (*c == '#') c++;
+            for (char *tok = strtok(c, " \t,\r\n"); tok != NULL; tok = strtok(NULL, " \t,\r\n")) {
+                if (n_columnas >= BARRIDO_MAX_PARAMETROS) {
+                    printf("ERROR: Demasiadas columnas en '%s'\n", nombre_archivo);
+                    exit(EXIT_FAILURE);
+                }
+                columnas[n_columnas++] = barrido_indice(b, tok);
+            }
+            continue;
+        }
+        if (*c == '#' || *c == '\r' || *c == '\n' || *c == '\0') continue;
+
+        if (n_filas == capacidad) {
+            capacidad = capacidad ? 2 * capacidad : 64;
+            filas = realloc(filas, (size_t)capacidad * b->n_parametros * sizeof(double));
+            if (filas == NULL) {
+                printf("ERROR: Memoria insuficiente leyendo '%s'\n", nombre_archivo);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        double *fila = filas + n_filas * b->n_parametros;
+        memcpy(fila, por_defecto, b->n_parametros * sizeof(double));
+        int n = 0;
+        for (char *tok = strtok(c, " \t,\r\n"); tok != NULL; tok = strtok(NULL, " \t,\r\n")) {
+            if (n < n_columnas) fila[columnas[n]] = barrido_numero(tok, nombre_archivo);
+            n++;
+        }
+        if (n != n_columnas) {
+            printf("ERROR: '%s', conjunto %ld: %d valores para %d columnas\n",
+                   nombre_archivo, n_filas + 1, n, n_columnas);
+            exit(EXIT_FAILURE);
+        }
+        n_filas++;
+    }
+    fclose(archivo);
+
+    barrido_reservar(b, n_filas);
+    memcpy(b->valores, filas, (size_t)n_filas * b->n_parametros * sizeof(double));
+    free(filas);
+}
+
+// nombres: parametros del programa separados por espacios, con su valor por
+// defecto en el mismo orden
+void barrido_preparar(Barrido *b, const char *nombres, const double *por_defecto) {
+    char copia[BARRIDO_MAX_PARAMETROS * BARRIDO_LARGO_NOMBRE];
+    snprintf(copia, sizeof(copia), "%s", nombres);
+
+    b->n_parametros = 0;
+    for (char *tok = strtok(copia, " "); tok != NULL; tok = strtok(NULL, " ")) {
+        snprintf(b->nombres[b->n_parametros++], BARRIDO_LARGO_NOMBRE, "%s", tok);
+    }
+
+    const char *grilla = getenv("BARRIDO");
+    if (grilla != NULL && grilla[0] != '\0') {
+        barrido_grilla(b, grilla, por_defecto);
+    } else {
+        barrido_lista(b, getenv("BARRIDO_ARCHIVO"), por_defecto);
+    }
+}
+
+// ============================================================================
+// AYUDAS PARA LOS TRABAJOS
+// ============================================================================
+// Pasos para ir de inicio a fin con paso h; el ultimo se acorta para
+// terminar exactamente en fin. Devuelve 0 si el intervalo o el paso no
+// sirven, o si harian falta mas de BARRIDO_MAX_PASOS (cociente infinito
+// incluido). La holgura descarta un ultimo paso de redondeo y nunca baja
+// de 1 paso cuando h es mayor que el intervalo.
+long barrido_pasos(double inicio, double fin, double h) {
+    if (!(h > 0) || !(fin > inicio)) return 0;
+    
+    double cociente = (fin - inicio) / h;
+    if (!isfinite(cociente) || cociente > BARRIDO_MAX_PASOS || cociente >= (double)LONG_MAX) return 0;
+    return (long)ceil(cociente - 1e-9 * fmin(cociente, 1.0));
+}
+
+void barrido_error(ResultadoBarrido *r, double error) {
+    if (error > r->error_maximo) r->error_maximo = error;
+    r->error_final = error;
+}
+
+// ============================================================================
+// POOL CON ROBO DE TRABAJO
+// ============================================================================
+// Cada hilo arranca con un tramo contiguo de conjuntos [inicio, fin) y los
+// toma desde el inicio. Al vaciarse busca el hilo con mas pendientes y le
+// roba la mitad final del tramo. Los conjuntos de una grilla tienen costos
+// muy distintos (el numero de pasos va como horizonte / h), asi que un
+// reparto fijo dejaria hilos ociosos; con robos todos terminan juntos sin
+// pagar una operacion compartida por conjunto como un contador global.
+// ============================================================================
+typedef struct {
+    long inicio, fin;
+    long robos;
+    double ocupado;
+#ifdef _OPENMP
+    omp_lock_t cerrojo;
+#endif
+} __attribute__((aligned(64))) ColaBarrido;     // Una cola por linea de cache
+
+#ifdef _OPENMP
+#define BARRIDO_CERRAR(c)   omp_set_lock(&(c)->cerrojo)
+#define BARRIDO_ABRIR(c)    omp_unset_lock(&(c)->cerrojo)
+#else
+#define BARRIDO_CERRAR(c)   ((void)0)
+#define BARRIDO_ABRIR(c)    ((void)0)
+#endif
+
+// Siguiente conjunto de la cola propia, o -1
+long barrido_tomar(ColaBarrido *c) {
+    long t = -1;
+    BARRIDO_CERRAR(c);
+    if (c->inicio < c->fin) t = c->inicio++;
+    BARRIDO_ABRIR(c);
+    return t;
+}
+
+// Roba la mitad final de la cola mas cargada. Devuelve 0 si no queda nada
+int barrido_robar(ColaBarrido *colas, int n_hilos, int ladron) {
+    for (;;) {
+        int victima = -1;
+        long mayor = 0;
+        for (int v = 0; v < n_hilos; v++) {
+            if (v == ladron) continue;
+            BARRIDO_CERRAR(&colas[v]);
+            long pendientes = colas[v].fin - colas[v].inicio;
+            BARRIDO_ABRIR(&colas[v]);
+            if (pendientes > mayor) {
+                mayor = pendientes;
+                victima = v;
+            }
+        }
+        if (victima < 0) return 0;
+
+        ColaBarrido *c = &colas[victima];
+        BARRIDO_CERRAR(c);
+        long pendientes = c->fin - c->inicio;
+        if (pendientes <= 0) {
+            BARRIDO_ABRIR(c);
+            continue;       // Otro ladron llego antes: buscar de nuevo
+        }
+        long corte = c->inicio + pendientes / 2;
+        long fin = c->fin;
+        c->fin = corte;
+        BARRIDO_ABRIR(c);
+
+        BARRIDO_CERRAR(&colas[ladron]);
+        colas[ladron].inicio = corte;
+        colas[ladron].fin = fin;
+        colas[ladron].robos++;
+        BARRIDO_ABRIR(&colas[ladron]);
+        return 1;
+    }
+}
+
+// Una pasada del pool sobre todos los conjuntos. En la fase del metodo llena
+// segundos, hilo y las estadisticas de e; en la de error salta los conjuntos
+// rechazados y llena segundos_referencia. Devuelve el tiempo de pared
+double barrido_pool(const Barrido *b, TrabajoBarrido trabajo, int fase, int n_hilos,
+                    ResultadoBarrido *resultados, EstadisticasBarrido *e) {
+    ColaBarrido *colas = aligned_alloc(64, n_hilos * sizeof(ColaBarrido));
+    if (colas == NULL) {
+        printf("ERROR: Memoria insuficiente para %d colas\n", n_hilos);
+        exit(EXIT_FAILURE);
+    }
+    for (int h = 0; h < n_hilos; h++) {
+        colas[h].inicio = b->n_trabajos * h / n_hilos;
+        colas[h].fin = b->n_trabajos * (h + 1) / n_hilos;
+        colas[h].robos = 0;
+        colas[h].ocupado = 0.0;
+#ifdef _OPENMP
+        omp_init_lock(&colas[h].cerrojo);
+#endif
+    }
+
+    double inicio = bench_tiempo();
+
+    #pragma omp parallel num_threads(n_hilos)
+    {
+        int hilo = 0;
+#ifdef _OPENMP
+        hilo = omp_get_thread_num();
+#endif
+        ColaBarrido *propia = &colas[hilo];
+
+        for (;;) {
+            long t = barrido_tomar(propia);
+            if (t < 0) {
+                if (!barrido_robar(colas, n_hilos, hilo)) break;
+                continue;
+            }
+            ResultadoBarrido *r = &resultados[t];
+            if (fase == BARRIDO_FASE_ERROR && r->estado == BARRIDO_RECHAZADO) continue;
+
+            double t0 = bench_tiempo();
+            trabajo(b->valores + t * b->n_parametros, fase, r);
+            double segundos = bench_tiempo() - t0;
+            propia->ocupado += segundos;
+            if (fase == BARRIDO_FASE_METODO) {
+                r->segundos = segundos;
+                r->hilo = hilo;
+            } else {
+                r->segundos_referencia = segundos;
+            }
+        }
+    }
+
+    double pared = bench_tiempo() - inicio;
+
+    if (fase == BARRIDO_FASE_METODO) {
+        e->robos = 0;
+        e->ocupado_min = INFINITY;
+        e->ocupado_max = 0.0;
+    }
+    for (int h = 0; h < n_hilos; h++) {
+        if (fase == BARRIDO_FASE_METODO) {
+            e->robos += colas[h].robos;
+            e->ocupado_min = fmin(e->ocupado_min, colas[h].ocupado);
+            e->ocupado_max = fmax(e->ocupado_max, colas[h].ocupado);
+        }
+#ifdef _OPENMP
+        omp_destroy_lock(&colas[h].cerrojo);
+#endif
+    }
+    free(colas);
+    return pared;
+}
+
+void barrido_ejecutar(const Barrido *b, TrabajoBarrido trabajo, ResultadoBarrido *resultados,
+                      EstadisticasBarrido *e) {
+    int n_hilos = 1;
+#ifdef _OPENMP
+    n_hilos = omp_get_max_threads();
+    const char *texto = getenv("BARRIDO_HILOS");
+    if (texto != NULL && texto[0] != '\0') n_hilos = atoi(texto);
+#endif
+    if (n_hilos < 1) n_hilos = 1;
+    if (n_hilos > BARRIDO_MAX_HILOS) n_hilos = BARRIDO_MAX_HILOS;
+    if (n_hilos > b->n_trabajos) n_hilos = (int)b->n_trabajos;
+
+    memset(resultados, 0, b->n_trabajos * sizeof(ResultadoBarrido));
+
+    // Los trabajos reportan NaN/Inf en su estado; VALIDAR terminaria el proceso
+    int validar_previo = validar_operaciones;
+    validar_operaciones = 0;
+
+    e->hilos = n_hilos;
+    e->segundos = barrido_pool(b, trabajo, BARRIDO_FASE_METODO, n_hilos, resultados, e);
+    e->segundos_referencia = barrido_pool(b, trabajo, BARRIDO_FASE_ERROR, n_hilos, resultados, e);
+
+    validar_operaciones = validar_previo;
+}
+
+// ============================================================================
+// TABLA DE RESULTADOS
+// ============================================================================
+const char* barrido_nombre_estado(int estado) {
+    switch (estado) {
+        case BARRIDO_INVALIDO:  return "INVALIDO";
+        case BARRIDO_RECHAZADO: return "RECHAZADO";
+        default:                return "OK";
+    }
+}
+
+void barrido_guardar_csv(const char *programa, const Barrido *b, const ResultadoBarrido *r) {
+    FILE *csv = fopen(BARRIDO_CSV, "w");
+    if (csv == NULL) {
+        printf("ADVERTENCIA: No se pudo abrir '%s'\n", BARRIDO_CSV);
+        return;
+    }
+
+    fprintf(csv, "programa,conjunto");
+    for (int k = 0; k < b->n_parametros; k++) fprintf(csv, ",%s", b->nombres[k]);
+    fprintf(csv, ",error_maximo,error_final,referencia,pasos,evaluaciones,segundos,segundos_referencia,hilo,estado\n");
+
+    for (long t = 0; t < b->n_trabajos; t++) {
+        fprintf(csv, "%s,%ld", programa, t + 1);
+        for (int k = 0; k < b->n_parametros; k++) {
+            fprintf(csv, ",%.10g", b->valores[t * b->n_parametros + k]);
+        }
+        fprintf(csv, ",%.6e,%.6e,%s,%ld,%ld,%.6f,%.6f,%d,%s\n",
+                r[t].error_maximo, r[t].error_final, r[t].con_exacta ? "exacta" : "refinada",
+                r[t].pasos, r[t].evaluaciones, r[t].segundos, r[t].segundos_referencia, r[t].hilo,
+                barrido_nombre_estado(r[t].estado));
+    }
+    fclose(csv);
+}
+
+void barrido_imprimir(const Barrido *b, const ResultadoBarrido *r, const EstadisticasBarrido *e) {
+    printf("%7s", "#");
+    for (int k = 0; k < b->n_parametros; k++) printf(" %11.11s", b->nombres[k]);
+    printf(" %10s %10s %-4s %11s %9s %9s %4s %s\n",
+           "Error max", "Error fin", "Ref", "Evals", "ms", "ms ref", "Hilo", "Estado");
+
+    long mostradas = (b->n_trabajos < BARRIDO_FILAS_PANTALLA) ? b->n_trabajos : BARRIDO_FILAS_PANTALLA;
+    for (long t = 0; t < mostradas; t++) {
+        printf("%7ld", t + 1);
+        for (int k = 0; k < b->n_parametros; k++) printf(" %11.5g", b->valores[t * b->n_parametros + k]);
+        printf(" %10.3e %10.3e %-4s %11ld %9.2f %9.2f %4d %s\n",
+               r[t].error_maximo, r[t].error_final, r[t].con_exacta ? "ex" : "ref",
+               r[t].evaluaciones, r[t].segundos * 1e3, r[t].segundos_referencia * 1e3,
+               r[t].hilo, barrido_nombre_estado(r[t].estado));
+    }
+    if (mostradas < b->n_trabajos) {
+        printf("    ... %ld conjuntos mas en %s\n", b->n_trabajos - mostradas, BARRIDO_CSV);
+    }
+
+    double suma = 0.0, suma_referencia = 0.0;
+    int fallidos = 0;
+    for (long t = 0; t < b->n_trabajos; t++) {
+        suma += r[t].segundos;
+        suma_referencia += r[t].segundos_referencia;
+        if (r[t].estado != BARRIDO_OK) fallidos++;
+    }
+
+    printf("\nRESUMEN DEL BARRIDO:\n");
+    printf("-----------------------------------------------------------------\n");
+    printf("  Conjuntos:              %ld (%d con problemas)\n", b->n_trabajos, fallidos);
+    printf("  Hilos:                  %d\n", e->hilos);
+    printf("  Tiempo de pared:        %.4f s (solo el metodo)\n", e->segundos);
+    printf("  Suma de trabajos:       %.4f s\n", suma);
+    if (e->segundos > 0) {
+        printf("  Aceleracion:            %.2fx (eficiencia %.0f%%)\n",
+               suma / e->segundos, 100 * suma / e->segundos / e->hilos);
+    }
+    printf("  Ocupacion por hilo:     %.4f a %.4f s\n", e->ocupado_min, e->ocupado_max);
+    printf("  Robos:                  %ld\n", e->robos);
+    printf("  Pasada de error:        %.4f s de pared, %.4f s de trabajos (referencias)\n",
+           e->segundos_referencia, suma_referencia);
+    printf("  Ref: ex = solucion exacta, ref = mismo metodo con paso h/%d\n", BARRIDO_REFINAMIENTO);
+    printf("  Tabla completa:         %s\n", BARRIDO_CSV);
+}
+
+// Barrido completo: conjuntos del entorno, pool, tabla y CSV. Devuelve
+// EXIT_FAILURE si algun conjunto fallo
+int barrido_correr(const char *programa, const char *nombres, const double *por_defecto,
+                   TrabajoBarrido trabajo) {
+    Barrido b;
+    barrido_preparar(&b, nombres, por_defecto);
+
+    ResultadoBarrido *resultados = malloc(b.n_trabajos * sizeof(ResultadoBarrido));
+    if (resultados == NULL) {
+        printf("ERROR: Memoria insuficiente para %ld resultados\n", b.n_trabajos);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("===============================================================\n");
+    printf("          BARRIDO DE PARAMETROS: %s (%ld conjuntos)\n", programa, b.n_trabajos);
+    printf("===============================================================\n\n");
+
+    EstadisticasBarrido e;
+    barrido_ejecutar(&b, trabajo, resultados, &e);
+    barrido_imprimir(&b, resultados, &e);
+    barrido_guardar_csv(programa, &b, resultados);
+
+    int fallidos = 0;
+    for (long t = 0; t < b.n_trabajos; t++) {
+        if (resultados[t].estado != BARRIDO_OK) fallidos++;
+    }
+    free(resultados);
+    free(b.valores);
+
+    return fallidos ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif
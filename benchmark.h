@@ -0,0 +1,150 @@
+// benchmark.h
+// Micro-benchmarks de los nucleos numericos: calentamiento, repeticiones y
+// estadisticas, con resultados en benchmark.csv
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ============================================================================
+// USO
+// ============================================================================
+// Cada programa ejecuta su bateria con la variable de entorno BENCHMARK:
+//   BENCHMARK=1 ./ecuacion1
+// y agrega una fila por nucleo a BENCH_ARCHIVO (CSV, encabezado si es nuevo).
+// Un nucleo se describe con una funcion que lo llama 'llamadas' veces y
+// devuelve cuantas unidades de trabajo (pasos, iteraciones, puntos) y cuantas
+// evaluaciones de la funcion del problema realizo.
+// ============================================================================
+#define BENCH_CALENTAMIENTO     3       // Repeticiones descartadas
+#define BENCH_REPETICIONES      15      // Repeticiones medidas
+#define BENCH_TIEMPO_MINIMO     0.02    // Segundos minimos por repeticion
+#define BENCH_ARCHIVO           "benchmark.csv"
+
+typedef struct {
+    double unidades;        // Pasos / iteraciones / puntos ejecutados
+    double evaluaciones;    // Evaluaciones de la funcion del problema
+} ConteoBench;
+
+typedef ConteoBench (*NucleoBench)(void *contexto, long llamadas);
+
+typedef struct {
+    long llamadas;          // Llamadas por repeticion (calibradas)
+    double ns_minimo, ns_mediana, ns_media, ns_desvio;     // ns por unidad
+    double unidades_por_llamada, evaluaciones_por_llamada;
+} ResultadoBench;
+
+// Acumula resultados para que el compilador no elimine el trabajo medido
+volatile double bench_sumidero = 0.0;
+
+double bench_tiempo() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int bench_comparar(const void *a, const void *b) {
+    double da = *(const double*)a, db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+void bench_encabezado(const char *programa) {
+    printf("===============================================================================\n");
+    printf(" MICRO-BENCHMARKS: %s\n", programa);
+    printf(" %d repeticiones (+%d de calentamiento), >= %.0f ms cada una\n",
+           BENCH_REPETICIONES, BENCH_CALENTAMIENTO, BENCH_TIEMPO_MINIMO * 1e3);
+    printf("===============================================================================\n");
+    printf("%-28s %-11s %10s %10s %8s %10s\n",
+           "Nucleo", "Unidad", "ns/unidad", "minimo", "desvio", "evals/llam");
+    printf("-------------------------------------------------------------------------------\n");
+}
+
+void bench_guardar(const char *programa, const char *nucleo, const char *unidad,
+                   const ResultadoBench *r) {
+    FILE *csv = fopen(BENCH_ARCHIVO, "a+");
+    if (csv == NULL) {
+        printf("ADVERTENCIA: No se pudo abrir '%s'\n", BENCH_ARCHIVO);
+        return;
+    }
+
+    fseek(csv, 0, SEEK_END);
+    if (ftell(csv) == 0) {
+        fprintf(csv, "programa,nucleo,unidad,llamadas,repeticiones,unidades_por_llamada,"
+                     "evaluaciones_por_llamada,ns_minimo,ns_mediana,ns_media,ns_desvio\n");
+    }
+    fprintf(csv, "%s,%s,%s,%ld,%d,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g\n",
+            programa, nucleo, unidad, r->llamadas, BENCH_REPETICIONES,
+            r->unidades_por_llamada, r->evaluaciones_por_llamada,
+            r->ns_minimo, r->ns_mediana, r->ns_media, r->ns_desvio);
+    fclose(csv);
+}
+
+ResultadoBench bench_medir(const char *programa, const char *nucleo, const char *unidad,
+                           NucleoBench f, void *contexto) {
+    ResultadoBench r;
+    ConteoBench c;
+    double t;
+
+    // Calibracion: duplicar las llamadas hasta superar el tiempo minimo
+    r.llamadas = 1;
+    for (;;) {
+        t = bench_tiempo();
+        c = f(contexto, r.llamadas);
+        t = bench_tiempo() - t;
+        if (t >= BENCH_TIEMPO_MINIMO || r.llamadas > (1L << 40)) break;
+        r.llamadas *= (t > 0 && BENCH_TIEMPO_MINIMO / t < 2) ? 2 : 4;
+    }
+
+    for (int i = 0; i < BENCH_CALENTAMIENTO; i++) {
+        f(contexto, r.llamadas);
+    }
+
+    double ns[BENCH_REPETICIONES];
+    double suma = 0.0;
+
+    for (int i = 0; i < BENCH_REPETICIONES; i++) {
+        t = bench_tiempo();
+        c = f(contexto, r.llamadas);
+        t = bench_tiempo() - t;
+        ns[i] = (c.unidades > 0) ? t * 1e9 / c.unidades : NAN;
+        suma += ns[i];
+    }
+
+    r.ns_media = suma / BENCH_REPETICIONES;
+    double suma_cuad = 0.0;
+    for (int i = 0; i < BENCH_REPETICIONES; i++) {
+        suma_cuad += (ns[i] - r.ns_media) * (ns[i] - r.ns_media);
+    }
+    r.ns_desvio = sqrt(suma_cuad / (BENCH_REPETICIONES - 1));
+
+    qsort(ns, BENCH_REPETICIONES, sizeof(double), bench_comparar);
+    r.ns_minimo = ns[0];
+    r.ns_mediana = ns[BENCH_REPETICIONES / 2];
+    r.unidades_por_llamada = c.unidades / r.llamadas;
+    r.evaluaciones_por_llamada = c.evaluaciones / r.llamadas;
+
+    printf("%-28s %-11s %10.2f %10.2f %7.1f%% %10.1f\n",
+           nucleo, unidad, r.ns_mediana, r.ns_minimo,
+           100 * r.ns_desvio / r.ns_media, r.evaluaciones_por_llamada);
+
+    bench_guardar(programa, nucleo, unidad, &r);
+    return r;
+}
+
+void bench_pie() {
+    printf("-------------------------------------------------------------------------------\n");
+    printf(" Resultados agregados a %s\n", BENCH_ARCHIVO);
+}
+
+// Activa la bateria si BENCHMARK esta definida en el entorno (y no es "0")
+int bench_solicitado() {
+    const char *valor = getenv("BENCHMARK");
+    return valor != NULL && valor[0] != '\0' && strcmp(valor, "0") != 0;
+}
+
+#endif
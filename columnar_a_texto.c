@@ -0,0 +1,77 @@
+// columnar_a_texto.c
+// Convierte archivos binarios columnares (.bin) a texto para gnuplot
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "datos_columnar.h"
+
+// ============================================================================
+// PARAMETROS CONFIGURABLES
+// ============================================================================
+#define DIGITOS_DEFECTO     10
+// ============================================================================
+
+// Uso: columnar_a_texto archivo.bin [salida.dat] [digitos]
+// Sin archivo de salida escribe en stdout, de modo que gnuplot puede leerlo
+// directamente con: plot '< ./columnar_a_texto archivo.bin'
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("Uso: %s archivo.bin [salida.dat] [digitos]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    LectorDatos *lector = lector_abrir(argv[1]);
+    if (lector == NULL) {
+        fprintf(stderr, "ERROR: No se pudo abrir '%s' (errno %d)\n", argv[1], errno);
+        return EXIT_FAILURE;
+    }
+
+    FILE *salida = stdout;
+    if (argc >= 3 && strcmp(argv[2], "-") != 0) {
+        salida = fopen(argv[2], "w");
+        if (salida == NULL) {
+            fprintf(stderr, "ERROR: No se pudo abrir '%s'\n", argv[2]);
+            lector_cerrar(lector);
+            return EXIT_FAILURE;
+        }
+    }
+
+    int digitos = (argc >= 4) ? atoi(argv[3]) : DIGITOS_DEFECTO;
+    if (digitos < 1 || digitos > 17) {
+        fprintf(stderr, "ERROR: digitos debe estar entre 1 y 17 (%d)\n", digitos);
+        lector_cerrar(lector);
+        return EXIT_FAILURE;
+    }
+
+    if (lector->formato == FORMATO_BINARIO) {
+        fprintf(salida, "#");
+        for (int c = 0; c < lector->n_columnas; c++) {
+            fprintf(salida, " %s", lector->nombres[c]);
+        }
+        fprintf(salida, "\n");
+    }
+
+    double v[COLUMNAR_MAX_COLUMNAS];
+    long filas = 0;
+    int n;
+
+    while ((n = lector_fila(lector, v, COLUMNAR_MAX_COLUMNAS)) > 0) {
+        for (int c = 0; c < n; c++) {
+            fprintf(salida, c ? " %.*g" : "%.*g", digitos, v[c]);
+        }
+        fprintf(salida, "\n");
+        filas++;
+    }
+
+    if (lector->formato == FORMATO_BINARIO && (uint64_t)filas != lector->n_filas) {
+        fprintf(stderr, "ADVERTENCIA: Se leyeron %ld de %llu filas\n",
+                filas, (unsigned long long)lector->n_filas);
+    }
+
+    if (salida != stdout) fclose(salida);
+    lector_cerrar(lector);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,331 @@
+// convergencia.h
+// Estudio de convergencia de RK4: integra con h, h/2, h/4, ..., estima el
+// orden observado, extrapola por Richardson y recomienda el paso para una
+// tolerancia dada
+
+#ifndef CONVERGENCIA_H
+#define CONVERGENCIA_H
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include "nucleo.h"
+#include "datos_columnar.h"
+#include "benchmark.h"
+
+// ============================================================================
+// USO
+// ============================================================================
+//   CONVERGENCIA=1e-8 ./ecuacion1
+// El valor es la tolerancia pedida (error maximo sobre la malla gruesa).
+// CONVERGENCIA_NIVELES fija cuantas mallas se integran (h ... h/2^(n-1)).
+//
+// Nada depende de la solucion exacta: la diferencia entre niveles sucesivos
+// da el orden observado p = log2(|y_h - y_h/2| / |y_h/2 - y_h/4|), y con las
+// dos mallas mas finas
+//   y_R = y_f + (y_f - y_g) / (2^p - 1)
+// es la solucion extrapolada sobre los nodos de la malla gruesa. El error de
+// cada nivel se estima contra y_R; si el programa conoce la solucion exacta
+// se muestra al lado para comparar.
+// ============================================================================
+#define CONVERGENCIA_NIVELES        6       // Por defecto (o entorno CONVERGENCIA_NIVELES)
+#define CONVERGENCIA_MAX_NIVELES    16
+#define CONVERGENCIA_ORDEN_NOMINAL  4.0     // RK4
+#define CONVERGENCIA_SEGURIDAD      0.8     // El h recomendado apunta a esta fraccion de la tolerancia
+#define CONVERGENCIA_MAX_VALORES    50000000L   // Tope de niveles x nodos x dimension
+
+// Llena y[] con la solucion exacta en t (NULL si no se conoce)
+typedef void (*SolucionExactaEDO)(double t, double *y);
+
+typedef struct {
+    const ProblemaEDO *problema;
+    double t_inicial, t_final, h;
+    const double *y_inicial;
+    int n_error;                    // Componentes que entran en el error (las primeras)
+    const char *nombres;            // Nombres de las componentes, separados por espacios
+    SolucionExactaEDO exacta;
+    int formato_salida;
+} EstudioConvergencia;
+
+// Activa el estudio si CONVERGENCIA esta definida; deja en *tolerancia su valor
+int convergencia_solicitada(double *tolerancia) {
+    const char *texto = getenv("CONVERGENCIA");
+    if (texto == NULL || texto[0] == '\0') return 0;
+
+    char *fin;
+    double valor = strtod(texto, &fin);
+    if (fin == texto || *fin != '\0' || !(valor > 0) || !isfinite(valor)) {
+        printf("ERROR: CONVERGENCIA='%s' debe ser la tolerancia (> 0), p. ej. CONVERGENCIA=1e-8\n", texto);
+        exit(EXIT_FAILURE);
+    }
+    if (tolerancia != NULL) *tolerancia = valor;
+    return 1;
+}
+
+// Integra un nivel con 'subpasos' pasos por intervalo de la malla gruesa y
+// guarda el estado en cada nodo grueso. Devuelve 0, o el nodo donde el estado
+// dejo de ser valido.
+long convergencia_nivel(const EstudioConvergencia *e, long n_gruesos, long subpasos, double *nodos) {
+    int n = e->problema->dimension;
+    double h_grueso = (e->t_final - e->t_inicial) / n_gruesos;
+    double h = h_grueso / subpasos;
+    double y[EDO_MAX_DIMENSION];
+
+    for (int c = 0; c < n; c++) y[c] = nodos[c] = e->y_inicial[c];
+
+    for (long i = 0; i < n_gruesos; i++) {
+        double t = e->t_inicial + i * h_grueso;
+        for (long k = 0; k < subpasos; k++) {
+            rk4_paso_edo(e->problema, t + k * h, y, h);
+        }
+        for (int c = 0; c < n; c++) {
+            if (!es_numerico_valido(y[c])) return i + 1;
+            nodos[(i + 1) * n + c] = y[c];
+        }
+    }
+    return 0;
+}
+
+// Maxima diferencia entre dos niveles sobre los nodos gruesos
+double convergencia_distancia(const double *a, const double *b, long n_nodos, int n, int n_error) {
+    double d = 0.0;
+    for (long i = 0; i < n_nodos; i++) {
+        for (int c = 0; c < n_error; c++) {
+            d = fmax(d, fabs(a[i * n + c] - b[i * n + c]));
+        }
+    }
+    return d;
+}
+
+// ============================================================================
+// ESTUDIO COMPLETO
+// ============================================================================
+int convergencia_ejecutar(const EstudioConvergencia *e, double tolerancia) {
+    int n = e->problema->dimension;
+    int niveles = CONVERGENCIA_NIVELES;
+    const char *texto = getenv("CONVERGENCIA_NIVELES");
+    if (texto != NULL && texto[0] != '\0') niveles = atoi(texto);
+    if (niveles < 3 || niveles > CONVERGENCIA_MAX_NIVELES) {
+        printf("ERROR: CONVERGENCIA_NIVELES debe estar entre 3 y %d (%d)\n", CONVERGENCIA_MAX_NIVELES, niveles);
+        exit(EXIT_FAILURE);
+    }
+
+    // La malla gruesa debe cubrir el intervalo con pasos iguales
+    long n_gruesos = lround((e->t_final - e->t_inicial) / e->h);
+    if (n_gruesos < 1) n_gruesos = 1;
+    double h = (e->t_final - e->t_inicial) / n_gruesos;
+    long n_nodos = n_gruesos + 1;
+
+    if ((double)niveles * n_nodos * n > CONVERGENCIA_MAX_VALORES) {
+        printf("ERROR: %d niveles x %ld nodos no caben en memoria; use un PASO_H mayor\n", niveles, n_nodos);
+        exit(EXIT_FAILURE);
+    }
+
+    double *nodos = malloc((size_t)niveles * n_nodos * n * sizeof(double));
+    double *richardson = malloc((size_t)n_nodos * n * sizeof(double));
+    if (nodos == NULL || richardson == NULL) {
+        printf("ERROR: Memoria insuficiente para el estudio de convergencia\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("===============================================================\n");
+    printf("          ESTUDIO DE CONVERGENCIA RK4 (%d niveles)\n", niveles);
+    printf("===============================================================\n\n");
+    printf("   Intervalo:        [%.4g, %.4g]\n", e->t_inicial, e->t_final);
+    printf("   Malla gruesa:     h = %.6g (%ld pasos)%s\n", h, n_gruesos,
+           fabs(h - e->h) > 1e-12 * fabs(e->h) ? ", ajustado para cubrir el intervalo" : "");
+    printf("   Malla mas fina:   h = %.6g (%ld pasos)\n", h / (1L << (niveles - 1)), n_gruesos << (niveles - 1));
+    printf("   Tolerancia:       %.3e\n", tolerancia);
+    printf("   Solucion exacta:  %s\n\n", e->exacta ? "disponible (solo para comparar)" : "no disponible");
+
+    // Niveles en paralelo, el mas fino (y caro) primero. VALIDAR queda
+    // apagado: un NaN se informa por nivel en lugar de terminar el proceso
+    long fallo[CONVERGENCIA_MAX_NIVELES];
+    double segundos[CONVERGENCIA_MAX_NIVELES];
+    int validar_previo = validar_operaciones;
+    validar_operaciones = 0;
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int j = 0; j < niveles; j++) {
+        int k = niveles - 1 - j;
+        double inicio = bench_tiempo();
+        fallo[k] = convergencia_nivel(e, n_gruesos, 1L << k, nodos + (size_t)k * n_nodos * n);
+        segundos[k] = bench_tiempo() - inicio;
+    }
+    validar_operaciones = validar_previo;
+
+    // Se usan los niveles validos contiguos desde el mas fino: un h grande
+    // puede ser inestable sin invalidar el estudio
+    int primero = 0;
+    for (int k = 0; k < niveles; k++) {
+        if (fallo[k]) {
+            printf(" ADVERTENCIA: Nivel %d (h = %.3e) con valores invalidos en el nodo %ld; se descarta\n",
+                   k, h / (1L << k), fallo[k]);
+            primero = k + 1;
+        }
+    }
+    if (niveles - primero < 3) {
+        printf(" ERROR: Hacen falta al menos 3 niveles validos para estimar el orden\n");
+        free(nodos);
+        free(richardson);
+        return EXIT_FAILURE;
+    }
+
+    // Diferencias entre niveles sucesivos y orden observado
+    double diferencia[CONVERGENCIA_MAX_NIVELES], orden[CONVERGENCIA_MAX_NIVELES];
+    for (int k = primero; k + 1 < niveles; k++) {
+        diferencia[k] = convergencia_distancia(nodos + (size_t)k * n_nodos * n,
+                                               nodos + (size_t)(k + 1) * n_nodos * n, n_nodos, n, e->n_error);
+    }
+    for (int k = primero; k + 2 < niveles; k++) {
+        orden[k] = (diferencia[k] > 0 && diferencia[k + 1] > 0)
+                 ? log2(diferencia[k] / diferencia[k + 1]) : NAN;
+    }
+
+    // Richardson con las dos mallas mas finas. Si el orden observado no es
+    // creible (redondeo dominante, fuera de regimen asintotico) se usa el nominal
+    double p = orden[niveles - 3];
+    int orden_nominal = !(fabs(p - CONVERGENCIA_ORDEN_NOMINAL) <= 1.0);
+    if (orden_nominal) p = CONVERGENCIA_ORDEN_NOMINAL;
+
+    const double *fino = nodos + (size_t)(niveles - 1) * n_nodos * n;
+    const double *medio = nodos + (size_t)(niveles - 2) * n_nodos * n;
+    double factor = 1.0 / (pow(2.0, p) - 1.0);
+    for (long i = 0; i < n_nodos * n; i++) {
+        richardson[i] = fino[i] + (fino[i] - medio[i]) * factor;
+    }
+
+    // Error de cada nivel contra Richardson y, si existe, contra la exacta
+    double estimado[CONVERGENCIA_MAX_NIVELES], real[CONVERGENCIA_MAX_NIVELES];
+    double real_richardson = 0.0;
+    double exacta[EDO_MAX_DIMENSION];
+    for (int k = primero; k < niveles; k++) {
+        estimado[k] = convergencia_distancia(nodos + (size_t)k * n_nodos * n, richardson, n_nodos, n, e->n_error);
+        real[k] = 0.0;
+    }
+    if (e->exacta != NULL) {
+        for (long i = 0; i < n_nodos; i++) {
+            e->exacta(e->t_inicial + i * h, exacta);
+            for (int c = 0; c < e->n_error; c++) {
+                for (int k = primero; k < niveles; k++) {
+                    real[k] = fmax(real[k], fabs(nodos[((size_t)k * n_nodos + i) * n + c] - exacta[c]));
+                }
+                real_richardson = fmax(real_richardson, fabs(richardson[i * n + c] - exacta[c]));
+            }
+        }
+    }
+
+    printf("+-------+-----------+-----------+-----------+-----------+-------+-----------+-----------+----------+\n");
+    printf("| Nivel |     h     |   Pasos   |   Evals   | |y-y(h/2)||  Orden | Err. est. | Err. real |    ms    |\n");
+    printf("+-------+-----------+-----------+-----------+-----------+-------+-----------+-----------+----------+\n");
+    for (int k = primero; k < niveles; k++) {
+        long pasos = n_gruesos << k;
+        printf("| %5d | %9.3e | %9ld | %9ld |", k, h / (1L << k), pasos, 4 * pasos);
+        if (k + 1 < niveles) printf(" %9.3e |", diferencia[k]); else printf(" %9s |", "-");
+        if (k + 2 < niveles && isfinite(orden[k])) printf(" %5.2f |", orden[k]); else printf(" %5s |", "-");
+        printf(" %9.3e |", estimado[k]);
+        if (e->exacta != NULL) printf(" %9.3e |", real[k]); else printf(" %9s |", "-");
+        printf(" %8.2f |\n", segundos[k] * 1e3);
+    }
+    printf("+-------+-----------+-----------+-----------+-----------+-------+-----------+-----------+----------+\n");
+    printf("  Orden usado en Richardson: %.2f (%s)\n", p,
+           orden_nominal ? "nominal; el observado no es confiable" : "observado en las mallas finas");
+    if (e->exacta != NULL) {
+        printf("  Error real de la solucion extrapolada: %.3e\n", real_richardson);
+    }
+
+    // Recomendacion: el h probado mas grande que cumple y la prediccion
+    // err(h) ~ err_k (h / h_k)^q desde el nivel mas grueso que cumple (o el
+    // mas fino si ninguno) hacia CONVERGENCIA_SEGURIDAD * tolerancia,
+    // redondeada a un numero entero de pasos. Si un nivel mas grueso falla,
+    // se interpola con el orden observado entre ambos y el resultado queda
+    // por debajo del h que fallo.
+    int cumple = -1;
+    for (int k = primero; k < niveles; k++) {
+        if (estimado[k] <= tolerancia) { cumple = k; break; }
+    }
+    int base = (cumple >= 0) ? cumple : niveles - 1;
+    double h_base = h / (1L << base);
+    double q = p;
+    if (cumple > primero && isfinite(orden[cumple - 1]) && orden[cumple - 1] > 0) q = orden[cumple - 1];
+    double h_predicho = (estimado[base] > 0)
+                      ? h_base * pow(CONVERGENCIA_SEGURIDAD * tolerancia / estimado[base], 1.0 / q) : h;
+    if (cumple > primero && !(h_predicho < h / (1L << (cumple - 1)))) h_predicho = h_base;
+    long n_recomendado = (long)ceil((e->t_final - e->t_inicial) / h_predicho - 1e-9);
+    if (n_recomendado < 1) n_recomendado = 1;
+    double h_recomendado = (e->t_final - e->t_inicial) / n_recomendado;
+
+    printf("\nRECOMENDACION (tolerancia %.3e):\n", tolerancia);
+    printf("-----------------------------------------------------------------\n");
+    if (cumple >= 0) {
+        printf("  Mayor h probado que cumple:  %.6g (nivel %d, error estimado %.3e)\n",
+               h / (1L << cumple), cumple, estimado[cumple]);
+    } else {
+        printf("  Ningun nivel probado cumple la tolerancia\n");
+    }
+    printf("  h recomendado:               %.6g (%ld pasos, %ld evaluaciones)\n",
+           h_recomendado, n_recomendado, 4 * n_recomendado);
+    if (h_recomendado > h / (1L << primero) || h_recomendado < h / (1L << (niveles - 1))) {
+        printf("  ADVERTENCIA: h recomendado fuera de las mallas probadas (prediccion con orden %.2f);\n", p);
+        printf("     confirmar con PASO_H = %.6g\n", h_recomendado);
+    }
+    
+    // Diferencias del orden del redondeo: el orden observado y el error
+    // estimado de las mallas finas dejan de tener sentido
+    double escala = 0.0;
+    for (long i = 0; i < n_nodos; i++) {
+        for (int c = 0; c < e->n_error; c++) escala = fmax(escala, fabs(richardson[i * n + c]));
+    }
+    if (diferencia[niveles - 2] <= 1000 * DBL_EPSILON * fmax(escala, 1.0)) {
+        printf("  ADVERTENCIA: las mallas mas finas difieren en el orden del redondeo;\n");
+        printf("     use menos niveles o un PASO_H mayor\n");
+    }
+
+    // Solucion extrapolada y errores por nivel
+    char columnas[256], formato[256];
+    snprintf(columnas, sizeof(columnas), "x");
+    snprintf(formato, sizeof(formato), "%%.10g");
+    char copia[128];
+    snprintf(copia, sizeof(copia), "%s", e->nombres);
+    int c = 0;
+    for (char *tok = strtok(copia, " "); tok != NULL && c < n; tok = strtok(NULL, " "), c++) {
+        size_t largo = strlen(columnas);
+        snprintf(columnas + largo, sizeof(columnas) - largo, " %s_richardson %s_fino", tok, tok);
+        largo = strlen(formato);
+        snprintf(formato + largo, sizeof(formato) - largo, " %%.15g %%.15g");
+    }
+    size_t largo = strlen(formato);
+    snprintf(formato + largo, sizeof(formato) - largo, "\n");
+
+    SalidaDatos *datos = salida_abrir("convergencia_richardson.dat", e->formato_salida, columnas, formato);
+    double fila[1 + 2 * EDO_MAX_DIMENSION];
+    for (long i = 0; i < n_nodos; i++) {
+        fila[0] = e->t_inicial + i * h;
+        for (int k = 0; k < c; k++) {
+            fila[1 + 2 * k] = richardson[i * n + k];
+            fila[2 + 2 * k] = fino[i * n + k];
+        }
+        salida_fila(datos, fila);
+    }
+    salida_cerrar(datos);
+
+    datos = salida_abrir("convergencia.dat", e->formato_salida, "nivel h error_estimado error_real",
+                         "%.0f %.10g %.6e %.6e\n");
+    for (int k = primero; k < niveles; k++) {
+        SALIDA_FILA(datos, k, h / (1L << k), estimado[k], e->exacta ? real[k] : NAN);
+    }
+    salida_cerrar(datos);
+
+    printf("\nARCHIVOS:\n");
+    printf("  - %s -> solucion extrapolada en la malla gruesa\n",
+           nombre_salida("convergencia_richardson.dat", e->formato_salida));
+    printf("  - %s -> error por nivel\n", nombre_salida("convergencia.dat", e->formato_salida));
+
+    free(nodos);
+    free(richardson);
+    return (cumple >= 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif
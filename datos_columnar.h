@@ -0,0 +1,365 @@
+// datos_columnar.h
+// Salida de datos en texto (gnuplot) o en formato binario columnar
+
+#ifndef DATOS_COLUMNAR_H
+#define DATOS_COLUMNAR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// ============================================================================
+// FORMATO BINARIO COLUMNAR
+// ============================================================================
+// Cabecera (orden de bytes nativo, little-endian en x86):
+//   char     magica[8]          "NUMCOL01"
+//   uint32   n_columnas
+//   char     tipo[4]            "f8" (double IEEE-754)
+//   uint64   n_filas            (se completa al cerrar)
+//   uint32   filas_por_bloque
+//   uint32   reservado
+//   char     nombres[n_columnas][32]
+// Datos: bloques de filas_por_bloque filas (el ultimo puede ser parcial);
+// dentro de cada bloque se guarda columna por columna.
+// ============================================================================
+#define FORMATO_TEXTO       0
+#define FORMATO_BINARIO     1
+
+#define COLUMNAR_MAGICA         "NUMCOL01"
+#define COLUMNAR_MAX_COLUMNAS   16
+#define COLUMNAR_LARGO_NOMBRE   32
+#define COLUMNAR_FILAS_BLOQUE   65536
+#define COLUMNAR_CONVERTIDOR    "./columnar_a_texto"
+
+typedef struct {
+    int formato;
+    int n_columnas;
+    const char *formato_texto;      // printf de una fila completa (modo texto)
+    FILE *archivo;
+    int filas_bloque;
+    int filas_en_bloque;
+    uint64_t n_filas;
+    double *bloque;                 // n_columnas x filas_bloque, por columnas
+} SalidaDatos;
+
+typedef struct {
+    int formato;
+    int n_columnas;
+    char nombres[COLUMNAR_MAX_COLUMNAS][COLUMNAR_LARGO_NOMBRE];
+    FILE *archivo;
+    uint64_t n_filas;
+    uint64_t filas_leidas;
+    int filas_bloque;
+    int filas_en_bloque;
+    int fila_en_bloque;
+    double *bloque;
+} LectorDatos;
+
+// Nombre real del archivo: en modo binario la extension .dat pasa a .bin
+const char* nombre_salida(const char *nombre, int formato) {
+    static char buffers[4][256];
+    static int turno = 0;
+    char *destino = buffers[turno];
+    turno = (turno + 1) % 4;
+
+    snprintf(destino, 256, "%s", nombre);
+    if (formato == FORMATO_BINARIO) {
+        char *punto = strrchr(destino, '.');
+        if (punto != NULL && strcmp(punto, ".dat") == 0) {
+            strcpy(punto, ".bin");
+        } else {
+            strncat(destino, ".bin", 255 - strlen(destino));
+        }
+    }
+    return destino;
+}
+
+// Fuente de datos para un comando plot de gnuplot ('archivo' o una tuberia
+// que convierte el binario a texto al vuelo)
+const char* fuente_gnuplot(const char *nombre, int formato) {
+    static char buffers[4][320];
+    static int turno = 0;
+    char *destino = buffers[turno];
+    turno = (turno + 1) % 4;
+
+    if (formato == FORMATO_BINARIO) {
+        snprintf(destino, 320, "'< %s %s'", COLUMNAR_CONVERTIDOR, nombre_salida(nombre, formato));
+    } else {
+        snprintf(destino, 320, "'%s'", nombre);
+    }
+    return destino;
+}
+
+// ============================================================================
+// ESCRITURA
+// ============================================================================
+// columnas: nombres separados por espacios ("x y"). En modo texto se escriben
+// como comentario de cabecera y cada fila usa formato_texto.
+SalidaDatos* salida_abrir(const char *nombre, int formato, const char *columnas,
+                          const char *formato_texto) {
+    SalidaDatos *s = calloc(1, sizeof(SalidaDatos));
+    if (s == NULL) {
+        printf("ERROR: Memoria insuficiente para abrir '%s'\n", nombre);
+        exit(EXIT_FAILURE);
+    }
+
+    char nombres[COLUMNAR_MAX_COLUMNAS][COLUMNAR_LARGO_NOMBRE];
+    memset(nombres, 0, sizeof(nombres));
+
+    char copia[COLUMNAR_MAX_COLUMNAS * COLUMNAR_LARGO_NOMBRE];
+    snprintf(copia, sizeof(copia), "%s", columnas);
+    for (char *tok = strtok(copia, " "); tok != NULL; tok = strtok(NULL, " ")) {
+        if (s->n_columnas >= COLUMNAR_MAX_COLUMNAS) {
+            printf("ERROR: Demasiadas columnas para '%s'\n", nombre);
+            exit(EXIT_FAILURE);
+        }
+        snprintf(nombres[s->n_columnas++], COLUMNAR_LARGO_NOMBRE, "%s", tok);
+    }
+
+    s->formato = formato;
+    s->formato_texto = formato_texto;
+
+    const char *ruta = nombre_salida(nombre, formato);
+    s->archivo = fopen(ruta, formato == FORMATO_BINARIO ? "wb" : "w");
+    if (s->archivo == NULL) {
+        printf("ERROR: No se pudo abrir '%s'\n", ruta);
+        exit(EXIT_FAILURE);
+    }
+
+    if (formato == FORMATO_TEXTO) {
+        fprintf(s->archivo, "# %s\n", columnas);
+        return s;
+    }
+
+    s->filas_bloque = COLUMNAR_FILAS_BLOQUE;
+    s->bloque = malloc((size_t)s->n_columnas * s->filas_bloque * sizeof(double));
+    if (s->bloque == NULL) {
+        printf("ERROR: Memoria insuficiente para el bloque de '%s'\n", ruta);
+        exit(EXIT_FAILURE);
+    }
+
+    uint32_t n_columnas = s->n_columnas, filas_bloque = s->filas_bloque, reservado = 0;
+    uint64_t n_filas = 0;
+    char tipo[4] = "f8";
+
+    fwrite(COLUMNAR_MAGICA, 1, 8, s->archivo);
+    fwrite(&n_columnas, sizeof(n_columnas), 1, s->archivo);
+    fwrite(tipo, 1, 4, s->archivo);
+    fwrite(&n_filas, sizeof(n_filas), 1, s->archivo);
+    fwrite(&filas_bloque, sizeof(filas_bloque), 1, s->archivo);
+    fwrite(&reservado, sizeof(reservado), 1, s->archivo);
+    fwrite(nombres, COLUMNAR_LARGO_NOMBRE, s->n_columnas, s->archivo);
+
+    return s;
+}
+
+void salida_vaciar_bloque(SalidaDatos *s) {
+    if (s->filas_en_bloque == 0) return;
+
+    for (int c = 0; c < s->n_columnas; c++) {
+        fwrite(s->bloque + (size_t)c * s->filas_bloque, sizeof(double),
+               s->filas_en_bloque, s->archivo);
+    }
+    s->filas_en_bloque = 0;
+}
+
+void salida_fila(SalidaDatos *s, const double *v) {
+    if (s->formato == FORMATO_BINARIO) {
+        for (int c = 0; c < s->n_columnas; c++) {
+            s->bloque[(size_t)c * s->filas_bloque + s->filas_en_bloque] = v[c];
+        }
+        s->n_filas++;
+        if (++s->filas_en_bloque == s->filas_bloque) {
+            salida_vaciar_bloque(s);
+        }
+        return;
+    }
+
+    switch (s->n_columnas) {
+        case 1: fprintf(s->archivo, s->formato_texto, v[0]); break;
+        case 2: fprintf(s->archivo, s->formato_texto, v[0], v[1]); break;
+        case 3: fprintf(s->archivo, s->formato_texto, v[0], v[1], v[2]); break;
+        case 4: fprintf(s->archivo, s->formato_texto, v[0], v[1], v[2], v[3]); break;
+        case 5: fprintf(s->archivo, s->formato_texto, v[0], v[1], v[2], v[3], v[4]); break;
+        case 6: fprintf(s->archivo, s->formato_texto, v[0], v[1], v[2], v[3], v[4], v[5]); break;
+        case 7: fprintf(s->archivo, s->formato_texto, v[0], v[1], v[2], v[3], v[4], v[5], v[6]); break;
+        case 8: fprintf(s->archivo, s->formato_texto, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]); break;
+        default:
+            for (int c = 0; c < s->n_columnas; c++) {
+                fprintf(s->archivo, c ? " %.6f" : "%.6f", v[c]);
+            }
+            fprintf(s->archivo, "\n");
+    }
+}
+
+#define SALIDA_FILA(s, ...) salida_fila((s), (const double[]){ __VA_ARGS__ })
+
+void salida_cerrar(SalidaDatos *s) {
+    if (s->formato == FORMATO_BINARIO) {
+        salida_vaciar_bloque(s);
+
+        // Completar el numero de filas en la cabecera
+        fseek(s->archivo, 8 + sizeof(uint32_t) + 4, SEEK_SET);
+        fwrite(&s->n_filas, sizeof(s->n_filas), 1, s->archivo);
+    }
+
+    fclose(s->archivo);
+    free(s->bloque);
+    free(s);
+}
+
+// ============================================================================
+// ESCRITURA POR REGIONES (binario de tamano conocido)
+// ============================================================================
+// Para resultados que se completan en cualquier orden (p. ej. tiles de una
+// malla terminados por distintos hilos): el archivo se abre con n_filas y
+// filas_bloque fijos y cada tramo se escribe directo en su posicion. Con
+// filas_bloque = nodos por fila de la malla, un bloque es una fila y un tramo
+// de fila es contiguo dentro de cada columna. El resultado es un NUMCOL01
+// normal que lector_abrir y columnar_a_texto leen sin cambios.
+SalidaDatos* salida_abrir_regiones(const char *nombre, const char *columnas,
+                                   uint64_t n_filas, int filas_bloque) {
+    SalidaDatos *s = salida_abrir(nombre, FORMATO_BINARIO, columnas, NULL);
+
+    // Sin bloque en memoria: salida_cerrar solo completa la cabecera
+    free(s->bloque);
+    s->bloque = NULL;
+    s->filas_bloque = filas_bloque;
+    s->n_filas = n_filas;
+
+    uint32_t filas_por_bloque = filas_bloque;
+    fseek(s->archivo, 8 + sizeof(uint32_t) + 4 + sizeof(uint64_t), SEEK_SET);
+    fwrite(&filas_por_bloque, sizeof(filas_por_bloque), 1, s->archivo);
+    return s;
+}
+
+// Escribe n valores de una columna desde la fila fila0; el tramo no puede
+// cruzar el final de un bloque
+void salida_escribir_tramo(SalidaDatos *s, uint64_t fila0, int n, int columna,
+                           const double *valores) {
+    uint64_t bloque = fila0 / s->filas_bloque;
+    uint64_t inicio_bloque = bloque * s->filas_bloque;
+    uint64_t filas_este_bloque = s->n_filas - inicio_bloque < (uint64_t)s->filas_bloque
+                               ? s->n_filas - inicio_bloque : (uint64_t)s->filas_bloque;
+
+    if (fila0 - inicio_bloque + n > filas_este_bloque || columna >= s->n_columnas) {
+        printf("ERROR: Tramo fuera del archivo columnar (fila %llu, columna %d)\n",
+               (unsigned long long)fila0, columna);
+        exit(EXIT_FAILURE);
+    }
+
+    long cabecera = 8 + sizeof(uint32_t) + 4 + sizeof(uint64_t) + 2 * sizeof(uint32_t)
+                  + (long)s->n_columnas * COLUMNAR_LARGO_NOMBRE;
+    long posicion = cabecera
+                  + (long)(inicio_bloque * s->n_columnas * sizeof(double))
+                  + (long)((columna * filas_este_bloque + (fila0 - inicio_bloque)) * sizeof(double));
+    fseek(s->archivo, posicion, SEEK_SET);
+    fwrite(valores, sizeof(double), n, s->archivo);
+}
+
+// ============================================================================
+// LECTURA (texto o binario, detectado por la cabecera)
+// ============================================================================
+LectorDatos* lector_abrir(const char *ruta) {
+    FILE *archivo = fopen(ruta, "rb");
+    if (archivo == NULL) return NULL;
+
+    LectorDatos *l = calloc(1, sizeof(LectorDatos));
+    if (l == NULL) {
+        fclose(archivo);
+        return NULL;
+    }
+    l->archivo = archivo;
+
+    char magica[8];
+    if (fread(magica, 1, 8, archivo) != 8 || memcmp(magica, COLUMNAR_MAGICA, 8) != 0) {
+        l->formato = FORMATO_TEXTO;
+        rewind(archivo);
+        return l;
+    }
+
+    uint32_t n_columnas, filas_bloque, reservado;
+    char tipo[4];
+
+    if (fread(&n_columnas, sizeof(n_columnas), 1, archivo) != 1 ||
+        fread(tipo, 1, 4, archivo) != 4 ||
+        fread(&l->n_filas, sizeof(l->n_filas), 1, archivo) != 1 ||
+        fread(&filas_bloque, sizeof(filas_bloque), 1, archivo) != 1 ||
+        fread(&reservado, sizeof(reservado), 1, archivo) != 1 ||
+        n_columnas == 0 || n_columnas > COLUMNAR_MAX_COLUMNAS ||
+        filas_bloque == 0 || memcmp(tipo, "f8\0\0", 4) != 0 ||
+        fread(l->nombres, COLUMNAR_LARGO_NOMBRE, n_columnas, archivo) != n_columnas) {
+        printf("ERROR: Cabecera columnar invalida en '%s'\n", ruta);
+        fclose(archivo);
+        free(l);
+        return NULL;
+    }
+
+    l->formato = FORMATO_BINARIO;
+    l->n_columnas = n_columnas;
+    l->filas_bloque = filas_bloque;
+    l->bloque = malloc((size_t)n_columnas * filas_bloque * sizeof(double));
+    if (l->bloque == NULL) {
+        printf("ERROR: Memoria insuficiente para leer '%s'\n", ruta);
+        fclose(archivo);
+        free(l);
+        return NULL;
+    }
+
+    return l;
+}
+
+// Lee la siguiente fila en v (hasta max_columnas valores). Devuelve el numero
+// de columnas leidas o 0 al terminar el archivo.
+int lector_fila(LectorDatos *l, double *v, int max_columnas) {
+    if (l->formato == FORMATO_TEXTO) {
+        char linea[1024];
+        while (fgets(linea, sizeof(linea), l->archivo) != NULL) {
+            if (linea[0] == '#' || linea[0] == '\n') continue;
+
+            int n = 0;
+            char *p = linea, *fin;
+            while (n < max_columnas) {
+                double valor = strtod(p, &fin);
+                if (fin == p) break;
+                v[n++] = valor;
+                p = fin;
+            }
+            if (n > 0) return n;
+        }
+        return 0;
+    }
+
+    if (l->fila_en_bloque == l->filas_en_bloque) {
+        uint64_t restantes = l->n_filas - l->filas_leidas;
+        if (restantes == 0) return 0;
+
+        l->filas_en_bloque = restantes < (uint64_t)l->filas_bloque ? (int)restantes : l->filas_bloque;
+        l->fila_en_bloque = 0;
+
+        for (int c = 0; c < l->n_columnas; c++) {
+            if (fread(l->bloque + (size_t)c * l->filas_en_bloque, sizeof(double),
+                      l->filas_en_bloque, l->archivo) != (size_t)l->filas_en_bloque) {
+                printf("ERROR: Archivo columnar truncado\n");
+                return 0;
+            }
+        }
+    }
+
+    int n = l->n_columnas < max_columnas ? l->n_columnas : max_columnas;
+    for (int c = 0; c < n; c++) {
+        v[c] = l->bloque[(size_t)c * l->filas_en_bloque + l->fila_en_bloque];
+    }
+    l->fila_en_bloque++;
+    l->filas_leidas++;
+    return n;
+}
+
+void lector_cerrar(LectorDatos *l) {
+    fclose(l->archivo);
+    free(l->bloque);
+    free(l);
+}
+
+#endif
@@ -5,49 +5,74 @@
 #include <math.h>
 #include <stdlib.h>
 #include <errno.h>
+#include "nucleo.h"
+#include "datos_columnar.h"
+#include "expresion.h"
+#include "hiperdual.h"
+#include "benchmark.h"
+#include "grafico.h"
 
 // ============================================================================
 // PARAMETROS CONFIGURABLES
 // ============================================================================
 #define FUNCION_X(x)        (sin(x) + (x)*(x))
 #define FUNCION_XY(x,y)     ((x)*(x)*sin(y) + exp((x)*(y)))
+// Las mismas funciones sobre numeros hiper-duales (modo DERIVADAS_AUTOMATICA)
+#define FUNCION_X_AD(x)     hd_suma(hd_sin(x), hd_mult(x, x))
+#define FUNCION_XY_AD(x,y)  hd_suma(hd_mult(hd_mult(x, x), hd_sin(y)), hd_exp(hd_mult(x, y)))
 #define PUNTO_X0            1.0
 #define PUNTO_Y0            0.5
 #define PASO_H              0.0001
 #define GRAFICO_INICIO      (PUNTO_X0 - 2.0)
 #define GRAFICO_FIN         (PUNTO_X0 + 2.0)
 #define GRAFICO_PUNTOS      100
-#define NOMBRE_GRAFICO      "derivadas_grafico.png"
+#define FORMATO_SALIDA      FORMATO_TEXTO    // FORMATO_TEXTO o FORMATO_BINARIO
+#define NIVEL_VALIDACION    VALIDACION_OPERACION  // _OPERACION, _PASO o _NINGUNA (o entorno VALIDACION)
+#define MODO_DERIVADAS      DERIVADAS_PASO_FIJO  // DERIVADAS_PASO_FIJO, DERIVADAS_RIDDERS o DERIVADAS_AUTOMATICA
+#define RIDDERS_H_INICIAL   0.1        // Paso de la primera fila del tableau
+#define MODO_CAMPO          0          // 1 = gradiente y Hessiano de f(x,y) sobre una malla
+#define CAMPO_NX            1024       // Nodos en x (p. ej. 4096)
+#define CAMPO_NY            1024       // Nodos en y
+#define CAMPO_RANGO         2.0        // Malla [x0 - R, x0 + R] x [y0 - R, y0 + R]
+#define MOTOR_GRAFICO       MOTOR_GNUPLOT    // MOTOR_GNUPLOT o MOTOR_SVG (o entorno GRAFICO)
+#define NOMBRE_GRAFICO      "derivadas_grafico.png" // Con MOTOR_SVG: derivadas_grafico.svg
 #define ANCHO_GRAFICO       800
 #define ALTO_GRAFICO        600
 // ============================================================================
 
-// ============================================================================
-// FUNCIONES DE VALIDACION
-// ============================================================================
-int es_numerico_valido(double valor) {
-    return !(isnan(valor) || isinf(valor) || fabs(valor) > 1e100);
-}
+#define DERIVADAS_PASO_FIJO 0   // Una diferencia central con PASO_H
+#define DERIVADAS_RIDDERS   1   // Ademas, tableau de Richardson (Ridders) con error estimado
+#define DERIVADAS_AUTOMATICA 2  // Diferenciacion automatica hiper-dual (exacta, sin h)
 
-void verificar_nan_inf(const char *nombre, double valor, int linea) {
-    if (isnan(valor)) {
-        printf(" ERROR [Linea %d]: %s = NaN (Operacion invalida)\n", linea, nombre);
-        printf("   Revise funciones matematicas (division por cero, raiz negativa, etc.)\n");
-        exit(EXIT_FAILURE);
-    }
-    if (isinf(valor)) {
-        printf(" ERROR [Linea %d]: %s = Infinito (Overflow)\n", linea, nombre);
-        printf("   Valor demasiado grande, reduzca paso h o punto de evaluacion\n");
-        exit(EXIT_FAILURE);
-    }
-    if (!es_numerico_valido(valor)) {
-        printf(" ERROR [Linea %d]: %s = Valor numerico invalido\n", linea, nombre);
-        exit(EXIT_FAILURE);
-    }
-}
+#define RIDDERS_FACTOR      1.4 // Reduccion de h entre filas del tableau
+#define RIDDERS_MAX_FILAS   10
+#define RIDDERS_SEGURIDAD   2.0 // Cortar cuando el error de orden alto crece este factor
+
+#define CAMPO_TILE          64  // Lado del bloque de nodos por tarea
+#define CAMPO_COMPONENTES   5   // fx, fy, fxx, fyy, fxy por nodo
+
+// Derivadas a) .. h) de la tabla principal
+enum {
+    DER_PRIMERA, DER_SEGUNDA, DER_PARCIAL_X, DER_PARCIAL_Y,
+    DER_SEGUNDA_X, DER_SEGUNDA_Y, DER_MIXTA, DER_TERCERA_X, N_DERIVADAS
+};
+
+// Contador global de evaluaciones de FUNCION_X / FUNCION_XY en el tableau
+long evaluaciones_funcion = 0;
+
+// Funciones definidas en tiempo de ejecucion: las variables de entorno
+// FUNCION_X y FUNCION_XY reemplazan a las macros, p. ej.
+//   FUNCION_X="sin(x) + x^2" FUNCION_XY="x^2*sin(y) + exp(x*y)" ./derivadas
+Expresion expr_fx, expr_fxy;
 
-#define VALIDAR(variable) verificar_nan_inf(#variable, variable, __LINE__)
+#define EVAL_X(x)           (expr_fx.activa ? expr_evaluar_1(&expr_fx, (x)) : FUNCION_X(x))
+#define EVAL_XY(x,y)        (expr_fxy.activa ? expr_evaluar_2(&expr_fxy, (x), (y)) : FUNCION_XY(x,y))
+#define EVAL_X_AD(x)        (expr_fx.activa ? expr_evaluar_hd_1(&expr_fx, (x)) : FUNCION_X_AD(x))
+#define EVAL_XY_AD(x,y)     (expr_fxy.activa ? expr_evaluar_hd_2(&expr_fxy, (x), (y)) : FUNCION_XY_AD(x,y))
 
+// ============================================================================
+// FUNCIONES DE VALIDACION
+// ============================================================================
 void validar_parametro_h(double h) {
     if (h <= 0) {
         printf(" ERROR: Paso h debe ser positivo (h = %.6f)\n", h);
@@ -63,20 +88,9 @@ void validar_parametro_h(double h) {
     }
 }
 
-FILE* abrir_archivo(const char *nombre, const char *modo) {
-    FILE *archivo = fopen(nombre, modo);
-    if (archivo == NULL) {
-        printf(" ERROR: No se pudo abrir archivo '%s' (modo: %s)\n", nombre, modo);
-        printf("   Codigo de error: %d\n", errno);
-        printf("   Verifique permisos y espacio en disco\n");
-        exit(EXIT_FAILURE);
-    }
-    return archivo;
-}
-
 void validar_funciones_punto(double x, double y) {
-    double fx = FUNCION_X(x);
-    double fxy = FUNCION_XY(x, y);
+    double fx = EVAL_X(x);
+    double fxy = EVAL_XY(x, y);
     
     if (!es_numerico_valido(fx)) {
         printf(" ERROR: f(x) invalida en x = %.6f\n", x);
@@ -95,8 +109,8 @@ void validar_funciones_punto(double x, double y) {
 // FUNCIONES DE CALCULO CON VALIDACION
 // ============================================================================
 double calcular_derivada_primera(double x0, double h) {
-    double f_plus = FUNCION_X(x0 + h);
-    double f_minus = FUNCION_X(x0 - h);
+    double f_plus = EVAL_X(x0 + h);
+    double f_minus = EVAL_X(x0 - h);
     
     VALIDAR(f_plus);
     VALIDAR(f_minus);
@@ -114,9 +128,9 @@ double calcular_derivada_primera(double x0, double h) {
 }
 
 double calcular_derivada_segunda(double x0, double h) {
-    double f_plus = FUNCION_X(x0 + h);
-    double f_center = FUNCION_X(x0);
-    double f_minus = FUNCION_X(x0 - h);
+    double f_plus = EVAL_X(x0 + h);
+    double f_center = EVAL_X(x0);
+    double f_minus = EVAL_X(x0 - h);
     
     VALIDAR(f_plus);
     VALIDAR(f_center);
@@ -135,8 +149,8 @@ double calcular_derivada_segunda(double x0, double h) {
 }
 
 double calcular_derivada_parcial_x(double x0, double y0, double h) {
-    double f_plus = FUNCION_XY(x0 + h, y0);
-    double f_minus = FUNCION_XY(x0 - h, y0);
+    double f_plus = EVAL_XY(x0 + h, y0);
+    double f_minus = EVAL_XY(x0 - h, y0);
     
     VALIDAR(f_plus);
     VALIDAR(f_minus);
@@ -148,8 +162,8 @@ double calcular_derivada_parcial_x(double x0, double y0, double h) {
 }
 
 double calcular_derivada_parcial_y(double x0, double y0, double h) {
-    double f_plus = FUNCION_XY(x0, y0 + h);
-    double f_minus = FUNCION_XY(x0, y0 - h);
+    double f_plus = EVAL_XY(x0, y0 + h);
+    double f_minus = EVAL_XY(x0, y0 - h);
     
     VALIDAR(f_plus);
     VALIDAR(f_minus);
@@ -161,10 +175,10 @@ double calcular_derivada_parcial_y(double x0, double y0, double h) {
 }
 
 double calcular_derivada_mixta(double x0, double y0, double h) {
-    double f_pp = FUNCION_XY(x0 + h, y0 + h);
-    double f_pm = FUNCION_XY(x0 + h, y0 - h);
-    double f_mp = FUNCION_XY(x0 - h, y0 + h);
-    double f_mm = FUNCION_XY(x0 - h, y0 - h);
+    double f_pp = EVAL_XY(x0 + h, y0 + h);
+    double f_pm = EVAL_XY(x0 + h, y0 - h);
+    double f_mp = EVAL_XY(x0 - h, y0 + h);
+    double f_mm = EVAL_XY(x0 - h, y0 - h);
     
     VALIDAR(f_pp); VALIDAR(f_pm);
     VALIDAR(f_mp); VALIDAR(f_mm);
@@ -181,6 +195,554 @@ double calcular_derivada_mixta(double x0, double y0, double h) {
     return derivada;
 }
 
+// ============================================================================
+// EXTRAPOLACION DE RICHARDSON (RIDDERS)
+// ============================================================================
+// Diferencia central de paso h para la derivada 'tipo', sin avisos ni
+// validacion (el tableau descarta por si mismo los pasos malos). Todas tienen
+// error de truncamiento en potencias pares de h, que es lo que el tableau
+// elimina columna a columna.
+double diferencia_central(int tipo, double x0, double y0, double h) {
+    switch (tipo) {
+        case DER_PRIMERA:
+            evaluaciones_funcion += 2;
+            return (EVAL_X(x0 + h) - EVAL_X(x0 - h)) / (2*h);
+        case DER_SEGUNDA:
+            evaluaciones_funcion += 3;
+            return (EVAL_X(x0 + h) - 2*EVAL_X(x0) + EVAL_X(x0 - h)) / (h*h);
+        case DER_PARCIAL_X:
+            evaluaciones_funcion += 2;
+            return (EVAL_XY(x0 + h, y0) - EVAL_XY(x0 - h, y0)) / (2*h);
+        case DER_PARCIAL_Y:
+            evaluaciones_funcion += 2;
+            return (EVAL_XY(x0, y0 + h) - EVAL_XY(x0, y0 - h)) / (2*h);
+        case DER_SEGUNDA_X:
+            evaluaciones_funcion += 3;
+            return (EVAL_XY(x0 + h, y0) - 2*EVAL_XY(x0, y0) + EVAL_XY(x0 - h, y0)) / (h*h);
+        case DER_SEGUNDA_Y:
+            evaluaciones_funcion += 3;
+            return (EVAL_XY(x0, y0 + h) - 2*EVAL_XY(x0, y0) + EVAL_XY(x0, y0 - h)) / (h*h);
+        case DER_MIXTA:
+            evaluaciones_funcion += 4;
+            return (EVAL_XY(x0 + h, y0 + h) - EVAL_XY(x0 + h, y0 - h)
+                  - EVAL_XY(x0 - h, y0 + h) + EVAL_XY(x0 - h, y0 - h)) / (4*h*h);
+        case DER_TERCERA_X:
+            evaluaciones_funcion += 4;
+            return (EVAL_XY(x0 + 2*h, y0) - 2*EVAL_XY(x0 + h, y0)
+                  + 2*EVAL_XY(x0 - h, y0) - EVAL_XY(x0 - 2*h, y0)) / (2*h*h*h);
+    }
+    return NAN;
+}
+
+typedef struct {
+    double valor;
+    double error;           // Estimacion del error absoluto
+    int filas;              // Pasos h usados
+    long evaluaciones;
+} ResultadoRidders;
+
+// Tableau de Ridders: la fila i usa h = h_inicial / RIDDERS_FACTOR^i y cada
+// columna elimina el siguiente termino h^2k del error. Se queda con la entrada
+// de menor error estimado y corta cuando la diagonal empieza a alejarse
+// (la cancelacion numerica ya domina sobre el truncamiento).
+ResultadoRidders derivada_ridders(int tipo, double x0, double y0, double h_inicial) {
+    double t[RIDDERS_MAX_FILAS][RIDDERS_MAX_FILAS];
+    double factor2 = RIDDERS_FACTOR * RIDDERS_FACTOR;
+    double h = h_inicial;
+    long evaluaciones_inicio = evaluaciones_funcion;
+    
+    ResultadoRidders r;
+    t[0][0] = diferencia_central(tipo, x0, y0, h);
+    r.valor = t[0][0];
+    r.error = INFINITY;
+    r.filas = 1;
+    
+    for (int i = 1; i < RIDDERS_MAX_FILAS; i++) {
+        h /= RIDDERS_FACTOR;
+        t[i][0] = diferencia_central(tipo, x0, y0, h);
+        r.filas = i + 1;
+        
+        double potencia = factor2;
+        for (int j = 1; j <= i; j++) {
+            t[i][j] = (t[i][j-1] * potencia - t[i-1][j-1]) / (potencia - 1);
+            potencia *= factor2;
+            
+            double error = fmax(fabs(t[i][j] - t[i][j-1]), fabs(t[i][j] - t[i-1][j-1]));
+            if (error <= r.error) {
+                r.error = error;
+                r.valor = t[i][j];
+            }
+        }
+        
+        if (fabs(t[i][i] - t[i-1][i-1]) >= RIDDERS_SEGURIDAD * r.error) break;
+    }
+    
+    r.evaluaciones = evaluaciones_funcion - evaluaciones_inicio;
+    return r;
+}
+
+// ============================================================================
+// DIFERENCIACION AUTOMATICA (HIPER-DUALES)
+// ============================================================================
+// FUNCION_X_AD / FUNCION_XY_AD deben describir las mismas funciones que
+// FUNCION_X / FUNCION_XY: se comprueba que el valor coincida en el punto.
+void validar_funciones_ad(double x, double y) {
+    double fx = EVAL_X_AD(hd_constante(x)).c[0];
+    double fxy = EVAL_XY_AD(hd_constante(x), hd_constante(y)).c[0];
+    double ref_x = EVAL_X(x), ref_xy = EVAL_XY(x, y);
+    
+    if (fabs(fx - ref_x) > 1e-12 * fmax(1.0, fabs(ref_x)) ||
+        fabs(fxy - ref_xy) > 1e-12 * fmax(1.0, fabs(ref_xy))) {
+        printf(" ERROR: FUNCION_X_AD / FUNCION_XY_AD no coinciden con FUNCION_X / FUNCION_XY\n");
+        printf("   f(x):   %.15g vs %.15g\n", fx, ref_x);
+        printf("   f(x,y): %.15g vs %.15g\n", fxy, ref_xy);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Las 8 derivadas con una pasada por direccion de siembra:
+//   f(x):   x = e1+e2+e3            -> a), b)
+//   f(x,y): x = e1+e2+e3            -> c), e), h)
+//   f(x,y): x = e1, y = e2+e3       -> d), f), g)
+// Devuelve el numero de evaluaciones (pasadas)
+int derivadas_automaticas(double x0, double y0, double d[N_DERIVADAS]) {
+    HiperDual fx = EVAL_X_AD(hd_variable(x0, HD_E1|HD_E2|HD_E3));
+    d[DER_PRIMERA] = fx.c[HD_E1];
+    d[DER_SEGUNDA] = fx.c[HD_E1|HD_E2];
+    
+    HiperDual fxx = EVAL_XY_AD(hd_variable(x0, HD_E1|HD_E2|HD_E3), hd_constante(y0));
+    d[DER_PARCIAL_X] = fxx.c[HD_E1];
+    d[DER_SEGUNDA_X] = fxx.c[HD_E1|HD_E2];
+    d[DER_TERCERA_X] = fxx.c[HD_E1|HD_E2|HD_E3];
+    
+    HiperDual fxy = EVAL_XY_AD(hd_variable(x0, HD_E1), hd_variable(y0, HD_E2|HD_E3));
+    d[DER_PARCIAL_Y] = fxy.c[HD_E2];
+    d[DER_SEGUNDA_Y] = fxy.c[HD_E2|HD_E3];
+    d[DER_MIXTA]     = fxy.c[HD_E1|HD_E2];
+    
+    for (int k = 0; k < N_DERIVADAS; k++) {
+        VALIDAR(d[k]);
+    }
+    return 3;
+}
+
+// Las 8 derivadas del informe en d[]. Devuelve las pasadas hiper-duales
+// (0 con diferencias finitas).
+int calcular_ocho_derivadas(double x0, double y0, double h, double d[N_DERIVADAS]) {
+    if (MODO_DERIVADAS == DERIVADAS_AUTOMATICA) {
+        // Derivadas exactas: 3 evaluaciones hiper-duales en total
+        return derivadas_automaticas(x0, y0, d);
+    }
+    
+    // Derivada a) D[f(x), x]
+    d[DER_PRIMERA] = calcular_derivada_primera(x0, h);
+    
+    // Derivada b) D[f(x), {x, 2}]
+    d[DER_SEGUNDA] = calcular_derivada_segunda(x0, h);
+    
+    // Derivada c) D[f(x,y), x]
+    d[DER_PARCIAL_X] = calcular_derivada_parcial_x(x0, y0, h);
+    
+    // Derivada d) D[f(x,y), y]
+    d[DER_PARCIAL_Y] = calcular_derivada_parcial_y(x0, y0, h);
+    
+    // Derivada e) D[f(x,y), {x, 2}]
+    double de = (EVAL_XY(x0 + h, y0) - 2*EVAL_XY(x0, y0) + EVAL_XY(x0 - h, y0)) / (h*h);
+    VALIDAR(de);
+    d[DER_SEGUNDA_X] = de;
+    
+    // Derivada f) D[f(x,y), {y, 2}]
+    double df = (EVAL_XY(x0, y0 + h) - 2*EVAL_XY(x0, y0) + EVAL_XY(x0, y0 - h)) / (h*h);
+    VALIDAR(df);
+    d[DER_SEGUNDA_Y] = df;
+    
+    // Derivada g) D[f(x,y), {x, y}]
+    d[DER_MIXTA] = calcular_derivada_mixta(x0, y0, h);
+    
+    // Derivada h) D[f(x,y), {x, 3}]
+    double f_2h = EVAL_XY(x0 + 2*h, y0);
+    double f_h = EVAL_XY(x0 + h, y0);
+    double f_mh = EVAL_XY(x0 - h, y0);
+    double f_m2h = EVAL_XY(x0 - 2*h, y0);
+    
+    VALIDAR(f_2h); VALIDAR(f_h);
+    VALIDAR(f_mh); VALIDAR(f_m2h);
+    
+    double dh = (f_2h - 2*f_h + 2*f_mh - f_m2h) / (2*h*h*h);
+    VALIDAR(dh);
+    d[DER_TERCERA_X] = dh;
+    return 0;
+}
+
+// ============================================================================
+// RED DE MUESTREO DEL GRAFICO
+// ============================================================================
+// f se evalua una sola vez en cada nodo de la red {x_i - h, x_i, x_i + h}
+// (3 evaluaciones por punto en lugar de las 5 de las dos formulas por
+// separado) y las derivadas salen de pasadas de diferencias sobre los
+// buffers. Con una expresion de tiempo de ejecucion se usa la API por lotes.
+void muestrear_red(double inicio, double dx, int n, double h,
+                   double *f_menos, double *f_centro, double *f_mas) {
+    double x[EXPR_LOTE], xm[EXPR_LOTE], xp[EXPR_LOTE];
+    
+    for (int base = 0; base < n; base += EXPR_LOTE) {
+        int m = (n - base < EXPR_LOTE) ? n - base : EXPR_LOTE;
+        
+        for (int j = 0; j < m; j++) {
+            x[j] = inicio + (base + j) * dx;
+            xm[j] = x[j] - h;
+            xp[j] = x[j] + h;
+        }
+        
+        if (expr_fx.activa) {
+            const double *vm[1] = {xm}, *vc[1] = {x}, *vp[1] = {xp};
+            expr_evaluar_lote(&expr_fx, vm, f_menos + base, m);
+            expr_evaluar_lote(&expr_fx, vc, f_centro + base, m);
+            expr_evaluar_lote(&expr_fx, vp, f_mas + base, m);
+        } else {
+            #pragma omp simd
+            for (int j = 0; j < m; j++) {
+                f_menos[base + j] = FUNCION_X(xm[j]);
+                f_centro[base + j] = FUNCION_X(x[j]);
+                f_mas[base + j] = FUNCION_X(xp[j]);
+            }
+        }
+    }
+}
+
+void diferencias_red(const double *f_menos, const double *f_centro, const double *f_mas,
+                     int n, double h, double *d1, double *d2) {
+    #pragma omp simd
+    for (int i = 0; i < n; i++) {
+        d1[i] = (f_mas[i] - f_menos[i]) / (2*h);
+        d2[i] = (f_mas[i] - 2*f_centro[i] + f_menos[i]) / (h*h);
+    }
+}
+
+// ============================================================================
+// CAMPO DE GRADIENTE Y HESSIANO
+// ============================================================================
+// La malla de CAMPO_NX x CAMPO_NY nodos se reparte en tiles entre hilos
+// (OpenMP). Cada tile muestrea f una vez en sus nodos mas un borde de un nodo
+// y todas las derivadas salen de diferencias centrales sobre esas muestras
+// con el espaciado de la malla como paso: ~1 evaluacion por nodo en lugar de
+// las 14 de las formulas sueltas. Con DERIVADAS_AUTOMATICA cada nodo se
+// calcula exacto con dos pasadas hiper-duales.
+//
+// Salida: derivadas_campo.bin en formato columnar (datos_columnar.h) con las
+// columnas x y fx fy fxx fyy fxy, un nodo por fila y un bloque por fila de la
+// malla (y creciente). Cada tile terminado se escribe en su posicion.
+// ============================================================================
+typedef struct {
+    long nodos_invalidos;
+    long convexos, concavos, silla;     // Signo del Hessiano
+    double gradiente_max, x_max, y_max;
+} ResumenCampo;
+
+void campo_tile(int col0, int fila0, int ancho, int alto,
+                double x_min, double y_min, double dx, double dy,
+                double *salida, ResumenCampo *r) {
+    // Muestras con borde: nodo (f, c) del tile en muestras[(f+1)*m + (c+1)]
+    double muestras[(CAMPO_TILE + 2) * (CAMPO_TILE + 2)];
+    double xs[CAMPO_TILE + 2], ys[CAMPO_TILE + 2];
+    int m = ancho + 2;
+    
+    if (MODO_DERIVADAS != DERIVADAS_AUTOMATICA) {
+        for (int c = 0; c < m; c++) xs[c] = x_min + (col0 + c - 1) * dx;
+        
+        for (int f = 0; f < alto + 2; f++) {
+            double y = y_min + (fila0 + f - 1) * dy;
+            double *fila = muestras + f * m;
+            
+            if (expr_fxy.activa) {
+                for (int c = 0; c < m; c++) ys[c] = y;
+                const double *vars[2] = {xs, ys};
+                expr_evaluar_lote(&expr_fxy, vars, fila, m);
+            } else {
+                #pragma omp simd
+                for (int c = 0; c < m; c++) fila[c] = FUNCION_XY(xs[c], y);
+            }
+        }
+    }
+    
+    for (int f = 0; f < alto; f++) {
+        double *d = salida + (long)f * CAMPO_TILE * CAMPO_COMPONENTES;
+        double y = y_min + (fila0 + f) * dy;
+        
+        if (MODO_DERIVADAS == DERIVADAS_AUTOMATICA) {
+            for (int c = 0; c < ancho; c++) {
+                double x = x_min + (col0 + c) * dx;
+                HiperDual a = EVAL_XY_AD(hd_variable(x, HD_E1|HD_E2), hd_variable(y, HD_E3));
+                HiperDual b = EVAL_XY_AD(hd_constante(x), hd_variable(y, HD_E1|HD_E2));
+                d[c*CAMPO_COMPONENTES + 0] = a.c[HD_E1];
+                d[c*CAMPO_COMPONENTES + 1] = a.c[HD_E3];
+                d[c*CAMPO_COMPONENTES + 2] = a.c[HD_E1|HD_E2];
+                d[c*CAMPO_COMPONENTES + 3] = b.c[HD_E1|HD_E2];
+                d[c*CAMPO_COMPONENTES + 4] = a.c[HD_E1|HD_E3];
+            }
+        } else {
+            const double *abajo = muestras + f * m + 1;
+            const double *centro = abajo + m;
+            const double *arriba = centro + m;
+            
+            #pragma omp simd
+            for (int c = 0; c < ancho; c++) {
+                d[c*CAMPO_COMPONENTES + 0] = (centro[c+1] - centro[c-1]) / (2*dx);
+                d[c*CAMPO_COMPONENTES + 1] = (arriba[c] - abajo[c]) / (2*dy);
+                d[c*CAMPO_COMPONENTES + 2] = (centro[c+1] - 2*centro[c] + centro[c-1]) / (dx*dx);
+                d[c*CAMPO_COMPONENTES + 3] = (arriba[c] - 2*centro[c] + abajo[c]) / (dy*dy);
+                d[c*CAMPO_COMPONENTES + 4] = (arriba[c+1] - arriba[c-1]
+                                            - abajo[c+1] + abajo[c-1]) / (4*dx*dy);
+            }
+        }
+        
+        for (int c = 0; c < ancho; c++) {
+            const double *v = d + c*CAMPO_COMPONENTES;
+            int valido = 1;
+            for (int k = 0; k < CAMPO_COMPONENTES; k++) valido &= es_numerico_valido(v[k]);
+            if (!valido) {
+                r->nodos_invalidos++;
+                continue;
+            }
+            
+            double gradiente = hypot(v[0], v[1]);
+            if (gradiente > r->gradiente_max) {
+                r->gradiente_max = gradiente;
+                r->x_max = x_min + (col0 + c) * dx;
+                r->y_max = y;
+            }
+            
+            double det = v[2]*v[3] - v[4]*v[4];
+            if (det < 0) r->silla++;
+            else if (det > 0 && v[2] > 0) r->convexos++;
+            else if (det > 0) r->concavos++;
+        }
+    }
+}
+
+// Escribe las filas de un tile terminado en su posicion del archivo: cada
+// tramo de fila es contiguo dentro de cada columna de su bloque
+void escribir_tile_campo(SalidaDatos *campo, const double *tile,
+                         int col0, int fila0, int ancho, int alto,
+                         double x_min, double y_min, double dx, double dy) {
+    double valores[CAMPO_TILE];
+    for (int f = 0; f < alto; f++) {
+        uint64_t nodo = (uint64_t)(fila0 + f) * CAMPO_NX + col0;
+        const double *d = tile + (long)f * CAMPO_TILE * CAMPO_COMPONENTES;
+        
+        for (int c = 0; c < ancho; c++) valores[c] = x_min + (col0 + c) * dx;
+        salida_escribir_tramo(campo, nodo, ancho, 0, valores);
+        for (int c = 0; c < ancho; c++) valores[c] = y_min + (fila0 + f) * dy;
+        salida_escribir_tramo(campo, nodo, ancho, 1, valores);
+        
+        for (int k = 0; k < CAMPO_COMPONENTES; k++) {
+            for (int c = 0; c < ancho; c++) valores[c] = d[c*CAMPO_COMPONENTES + k];
+            salida_escribir_tramo(campo, nodo, ancho, 2 + k, valores);
+        }
+    }
+}
+
+int ejecutar_campo() {
+    int tiles_x = (CAMPO_NX + CAMPO_TILE - 1) / CAMPO_TILE;
+    int tiles_y = (CAMPO_NY + CAMPO_TILE - 1) / CAMPO_TILE;
+    double x_min = PUNTO_X0 - CAMPO_RANGO, y_min = PUNTO_Y0 - CAMPO_RANGO;
+    double dx = 2*CAMPO_RANGO / (CAMPO_NX - 1);
+    double dy = 2*CAMPO_RANGO / (CAMPO_NY - 1);
+    
+    ResumenCampo total = {0, 0, 0, 0, -1.0, 0, 0};
+    
+    printf("===============================================================\n");
+    printf("        CAMPO DE GRADIENTE Y HESSIANO DE f(x,y)               \n");
+    printf("===============================================================\n\n");
+    printf("  f(x,y) =     %s\n", expr_fxy.activa ? expr_fxy.texto : "x²·sin(y) + e^(x·y)");
+    printf("  Malla:       %d x %d nodos\n", CAMPO_NX, CAMPO_NY);
+    printf("  Ventana:     [%.2f, %.2f] x [%.2f, %.2f]\n",
+           x_min, x_min + 2*CAMPO_RANGO, y_min, y_min + 2*CAMPO_RANGO);
+    printf("  Tiles:       %d x %d de %d nodos\n", tiles_x, tiles_y, CAMPO_TILE);
+    if (MODO_DERIVADAS == DERIVADAS_AUTOMATICA) {
+        printf("  Metodo:      hiper-duales (2 pasadas por nodo)\n\n");
+    } else {
+        printf("  Metodo:      diferencias centrales, paso = espaciado (%.2e, %.2e)\n\n", dx, dy);
+    }
+    
+    // Siempre binario: la malla tiene CAMPO_NX * CAMPO_NY filas
+    SalidaDatos *campo = salida_abrir_regiones("derivadas_campo.dat", "x y fx fy fxx fyy fxy",
+                                               (uint64_t)CAMPO_NX * CAMPO_NY, CAMPO_NX);
+    long evaluaciones = 0;
+    double inicio = bench_tiempo();
+    
+    #pragma omp parallel for schedule(dynamic)
+    for (int t = 0; t < tiles_x * tiles_y; t++) {
+        int col0 = (t % tiles_x) * CAMPO_TILE;
+        int fila0 = (t / tiles_x) * CAMPO_TILE;
+        int ancho = (CAMPO_NX - col0 < CAMPO_TILE) ? CAMPO_NX - col0 : CAMPO_TILE;
+        int alto = (CAMPO_NY - fila0 < CAMPO_TILE) ? CAMPO_NY - fila0 : CAMPO_TILE;
+        
+        static double tile[CAMPO_TILE * CAMPO_TILE * CAMPO_COMPONENTES];
+        #pragma omp threadprivate(tile)
+        ResumenCampo r = {0, 0, 0, 0, -1.0, 0, 0};
+        
+        campo_tile(col0, fila0, ancho, alto, x_min, y_min, dx, dy, tile, &r);
+        
+        // Tile terminado: acumular resumen y volcar a disco
+        #pragma omp critical
+        {
+            total.nodos_invalidos += r.nodos_invalidos;
+            total.convexos += r.convexos;
+            total.concavos += r.concavos;
+            total.silla += r.silla;
+            if (r.gradiente_max > total.gradiente_max) {
+                total.gradiente_max = r.gradiente_max;
+                total.x_max = r.x_max;
+                total.y_max = r.y_max;
+            }
+            evaluaciones += (MODO_DERIVADAS == DERIVADAS_AUTOMATICA)
+                          ? 2L * ancho * alto : (long)(ancho + 2) * (alto + 2);
+            escribir_tile_campo(campo, tile, col0, fila0, ancho, alto, x_min, y_min, dx, dy);
+        }
+    }
+    
+    double segundos = bench_tiempo() - inicio;
+    salida_cerrar(campo);
+    
+    // Mapa de calor de |grad f|
+    FILE *script = abrir_archivo("derivadas_campo.gp", "w");
+    fprintf(script, "# Script para el campo de gradiente\n");
+    fprintf(script, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n",
+            ANCHO_GRAFICO, ALTO_GRAFICO);
+    fprintf(script, "set output 'derivadas_campo.png'\n");
+    fprintf(script, "set title '|grad f(x,y)|'\n");
+    fprintf(script, "set xlabel 'x'\n");
+    fprintf(script, "set ylabel 'y'\n");
+    fprintf(script, "set xrange [%f:%f]\n", x_min, x_min + 2*CAMPO_RANGO);
+    fprintf(script, "set yrange [%f:%f]\n", y_min, y_min + 2*CAMPO_RANGO);
+    fprintf(script, "set palette rgb 33,13,10\n");
+    fprintf(script, "plot %s u 1:2:(sqrt($3**2 + $4**2)) w image notitle\n",
+            fuente_gnuplot("derivadas_campo.dat", FORMATO_BINARIO));
+    fclose(script);
+    
+    int resultado = system("gnuplot derivadas_campo.gp 2>&1");
+    
+    long nodos = (long)CAMPO_NX * CAMPO_NY;
+    printf("RESULTADOS:\n");
+    printf("-----------------------------------------------------------------\n");
+    printf("  Tiempo:               %.3f s (%.3e nodos/s)\n", segundos, nodos / segundos);
+    printf("  Evaluaciones de f:    %ld (%.3f por nodo)\n", evaluaciones, (double)evaluaciones / nodos);
+    printf("  Nodos invalidos:      %ld\n", total.nodos_invalidos);
+    printf("  |grad f| maximo:      %.6e en (%.4f, %.4f)\n",
+           total.gradiente_max, total.x_max, total.y_max);
+    printf("  Hessiano:             %ld convexos, %ld concavos, %ld silla\n",
+           total.convexos, total.concavos, total.silla);
+    
+    printf("\n  EXITO: %s -> x y fx fy fxx fyy fxy por nodo (columnar)\n",
+           nombre_salida("derivadas_campo.dat", FORMATO_BINARIO));
+    if (resultado == 0) {
+        printf("  EXITO: derivadas_campo.png -> Mapa de |grad f|\n");
+    } else {
+        printf("  ADVERTENCIA: Gnuplot reporto problemas (derivadas_campo.gp)\n");
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+// ============================================================================
+// MICRO-BENCHMARKS (BENCHMARK=1 ./derivadas)
+// ============================================================================
+// Una llamada = una derivada. El punto recorre 8 valores cercanos a
+// (PUNTO_X0, PUNTO_Y0) para que el compilador no reutilice resultados.
+typedef struct {
+    int tipo;               // 1..5: primera, segunda, parcial x, parcial y, mixta
+    double x0, y0, h;
+    double variacion;       // Separacion entre los 8 puntos
+} ContextoDerivada;
+
+ConteoBench bench_derivada(void *contexto, long llamadas) {
+    ContextoDerivada *c = contexto;
+    static const int evaluaciones[6] = {0, 2, 3, 2, 2, 4};
+    double suma = 0.0;
+    
+    for (long i = 0; i < llamadas; i++) {
+        double x = c->x0 + (i & 7) * c->variacion;
+        switch (c->tipo) {
+            case 1: suma += calcular_derivada_primera(x, c->h); break;
+            case 2: suma += calcular_derivada_segunda(x, c->h); break;
+            case 3: suma += calcular_derivada_parcial_x(x, c->y0, c->h); break;
+            case 4: suma += calcular_derivada_parcial_y(x, c->y0, c->h); break;
+            case 5: suma += calcular_derivada_mixta(x, c->y0, c->h); break;
+        }
+    }
+    bench_sumidero += suma;
+    return (ConteoBench){ llamadas, (double)evaluaciones[c->tipo] * llamadas };
+}
+
+// Una llamada = las 8 derivadas por hiper-duales (3 pasadas)
+ConteoBench bench_automatica(void *contexto, long llamadas) {
+    ContextoDerivada *c = contexto;
+    double d[N_DERIVADAS], suma = 0.0;
+    
+    for (long i = 0; i < llamadas; i++) {
+        derivadas_automaticas(c->x0 + (i & 7) * c->variacion, c->y0, d);
+        suma += d[DER_PRIMERA] + d[DER_TERCERA_X];
+    }
+    bench_sumidero += suma;
+    return (ConteoBench){ llamadas, 3.0 * llamadas };
+}
+
+int ejecutar_benchmark() {
+    static const char *nombres[6] = {"", "calcular_derivada_primera", "calcular_derivada_segunda",
+                                     "calcular_derivada_parcial_x", "calcular_derivada_parcial_y",
+                                     "calcular_derivada_mixta"};
+    
+    bench_encabezado("derivadas");
+    for (int tipo = 1; tipo <= 5; tipo++) {
+        ContextoDerivada c = {tipo, PUNTO_X0, PUNTO_Y0, PASO_H, 1e-3};
+        
+        // La derivada mixta avisa de asimetria fuera del origen (donde la
+        // funcion por defecto es simetrica): se mide solo en (0, 0)
+        if (tipo == 5) c.x0 = c.y0 = c.variacion = 0.0;
+        
+        bench_medir("derivadas", nombres[tipo], "derivada", bench_derivada, &c);
+    }
+    
+    ContextoDerivada c = {0, PUNTO_X0, PUNTO_Y0, PASO_H, 1e-3};
+    validar_funciones_ad(PUNTO_X0, PUNTO_Y0);
+    bench_medir("derivadas", "derivadas_automaticas", "8 derivadas", bench_automatica, &c);
+    bench_pie();
+    return EXIT_SUCCESS;
+}
+
+// ============================================================================
+// GRAFICO EN MEMORIA (MOTOR_SVG)
+// ============================================================================
+// Mismo contenido que derivadas_plot.gp. El mapa del campo de gradiente
+// (MODO_CAMPO) sigue usando gnuplot: es una imagen, no curvas.
+#define SERIE_PRIMERA       0
+#define SERIE_SEGUNDA       1
+
+PanelGrafico grafico;
+
+void preparar_grafico() {
+    char titulo[GRAFICO_LARGO_TEXTO];
+    snprintf(titulo, sizeof(titulo), "Derivadas de f(x) = %.120s", expr_fx.activa ? expr_fx.texto : "sin(x) + x^2");
+    
+    grafico_iniciar(&grafico, titulo, "x", "Valor de derivada");
+    grafico_rango_x(&grafico, GRAFICO_INICIO, GRAFICO_FIN);
+    grafico_serie(&grafico, "Primera derivada f'(x)", "#0066CC", TRAZO_LINEA, 2.0);
+    grafico_serie(&grafico, "Segunda derivada f''(x)", "#FF3333", TRAZO_LINEA | TRAZO_DISCONTINUO, 2.0);
+}
+
+int graficar_svg(double x0, double derivada) {
+    char titulo[GRAFICO_LARGO_TEXTO];
+    snprintf(titulo, sizeof(titulo), "Punto (x0, %.3f)", derivada);
+    int punto = grafico_serie(&grafico, titulo, "#00AA00", TRAZO_PUNTOS, 2.0);
+    grafico_punto(&grafico, punto, x0, derivada);
+    
+    int resultado = grafico_escribir_svg(grafico_nombre_svg(NOMBRE_GRAFICO), ANCHO_GRAFICO, ALTO_GRAFICO,
+                                         &grafico, 1);
+    grafico_liberar(&grafico);
+    return resultado;
+}
+
 // ============================================================================
 // PROGRAMA PRINCIPAL
 // ============================================================================
@@ -191,9 +753,24 @@ int main() {
     printf(" VALIDANDO PARAMETROS INICIALES...\n");
     printf("-------------------------------------------------------------\n");
     
+    validacion_iniciar(NIVEL_VALIDACION);
+    validar_magnitud = 1;
+    evaluaciones_funcion = 0;
+    grafico_iniciar_motor(MOTOR_GRAFICO);
+    expr_desde_entorno(&expr_fx, "FUNCION_X", "x");
+    expr_desde_entorno(&expr_fxy, "FUNCION_XY", "x y");
     validar_parametro_h(PASO_H);
     validar_funciones_punto(PUNTO_X0, PUNTO_Y0);
     
+    if (bench_solicitado()) {
+        return ejecutar_benchmark();
+    }
+    
+    if (MODO_CAMPO) {
+        if (MODO_DERIVADAS == DERIVADAS_AUTOMATICA) validar_funciones_ad(PUNTO_X0, PUNTO_Y0);
+        return ejecutar_campo();
+    }
+    
     double h = PASO_H;
     double x0 = PUNTO_X0, y0 = PUNTO_Y0;
     
@@ -214,8 +791,8 @@ int main() {
     printf(" 8 DERIVADAS NUMERICAS CON VALIDACION \n\n");
     
     printf("FUNCIONES:\n");
-    printf("  f(x)   = sin(x) + x²\n");
-    printf("  f(x,y) = x²·sin(y) + e^(x·y)\n");
+    printf("  f(x)   = %s\n", expr_fx.activa ? expr_fx.texto : "sin(x) + x²");
+    printf("  f(x,y) = %s\n", expr_fxy.activa ? expr_fxy.texto : "x²·sin(y) + e^(x·y)");
     printf("PUNTO:   (x0, y0) = (%.1f, %.1f)\n", x0, y0);
     printf("PASO:    h = %.4f\n\n", h);
     
@@ -229,50 +806,71 @@ int main() {
     printf("| #  | Derivada                            | Valor Numerico  | Estado   |\n");
     printf("+----+--------------------------------------+-----------------+----------+\n");
     
-    // Derivada a) D[f(x), x]
-    double da = calcular_derivada_primera(x0, h);
-    printf("| a) | D[f(x), x]                          | %14.6f | - VALIDO |\n", da);
+    double d[N_DERIVADAS];
+    if (MODO_DERIVADAS == DERIVADAS_AUTOMATICA) validar_funciones_ad(x0, y0);
     
-    // Derivada b) D[f(x), {x, 2}]
-    double db = calcular_derivada_segunda(x0, h);
-    printf("| b) | D[f(x), {x, 2}]                     | %14.6f | - VALIDO |\n", db);
+    // En el nivel de validacion PASO las 8 derivadas son un solo lote
+    validacion_abrir_lote();
+    int pasadas_ad = calcular_ocho_derivadas(x0, y0, h, d);
+    if (validacion_cerrar_lote("calculo de derivadas", N_DERIVADAS)) {
+        pasadas_ad = calcular_ocho_derivadas(x0, y0, h, d);
+        validacion_fin_repeticion();
+    }
     
-    // Derivada c) D[f(x,y), x]
-    double dc = calcular_derivada_parcial_x(x0, y0, h);
-    printf("| c) | D[f(x,y), x]                        | %14.6f | - VALIDO |\n", dc);
+    double da = d[DER_PRIMERA],   db = d[DER_SEGUNDA];
+    double dc = d[DER_PARCIAL_X], dd = d[DER_PARCIAL_Y];
+    double de = d[DER_SEGUNDA_X], df = d[DER_SEGUNDA_Y];
+    double dg = d[DER_MIXTA],     dh = d[DER_TERCERA_X];
     
-    // Derivada d) D[f(x,y), y]
-    double dd = calcular_derivada_parcial_y(x0, y0, h);
+    printf("| a) | D[f(x), x]                          | %14.6f | - VALIDO |\n", da);
+    printf("| b) | D[f(x), {x, 2}]                     | %14.6f | - VALIDO |\n", db);
+    printf("| c) | D[f(x,y), x]                        | %14.6f | - VALIDO |\n", dc);
     printf("| d) | D[f(x,y), y]                        | %14.6f | - VALIDO |\n", dd);
-    
-    // Derivada e) D[f(x,y), {x, 2}]
-    double de = (FUNCION_XY(x0 + h, y0) - 2*FUNCION_XY(x0, y0) + FUNCION_XY(x0 - h, y0)) / (h*h);
-    VALIDAR(de);
     printf("| e) | D[f(x,y), {x, 2}]                   | %14.6f | - VALIDO |\n", de);
-    
-    // Derivada f) D[f(x,y), {y, 2}]
-    double df = (FUNCION_XY(x0, y0 + h) - 2*FUNCION_XY(x0, y0) + FUNCION_XY(x0, y0 - h)) / (h*h);
-    VALIDAR(df);
     printf("| f) | D[f(x,y), {y, 2}]                   | %14.6f | - VALIDO |\n", df);
-    
-    // Derivada g) D[f(x,y), {x, y}]
-    double dg = calcular_derivada_mixta(x0, y0, h);
     printf("| g) | D[f(x,y), {x, y}]                   | %14.6f | - VALIDO |\n", dg);
+    printf("| h) | D[f(x,y), {x, 3}]                   | %14.6f | - VALIDO |\n", dh);
     
-    // Derivada h) D[f(x,y), {x, 3}]
-    double f_2h = FUNCION_XY(x0 + 2*h, y0);
-    double f_h = FUNCION_XY(x0 + h, y0);
-    double f_mh = FUNCION_XY(x0 - h, y0);
-    double f_m2h = FUNCION_XY(x0 - 2*h, y0);
+    printf("+----+--------------------------------------+-----------------+----------+\n");
     
-    VALIDAR(f_2h); VALIDAR(f_h);
-    VALIDAR(f_mh); VALIDAR(f_m2h);
+    if (MODO_DERIVADAS == DERIVADAS_AUTOMATICA) {
+        printf("  Diferenciacion automatica: %d evaluaciones hiper-duales (sin paso h)\n", pasadas_ad);
+    }
     
-    double dh = (f_2h - 2*f_h + 2*f_mh - f_m2h) / (2*h*h*h);
-    VALIDAR(dh);
-    printf("| h) | D[f(x,y), {x, 3}]                   | %14.6f | - VALIDO |\n", dh);
+    // ============================================================================
+    // TABLEAU DE RIDDERS
+    // ============================================================================
+    ResultadoRidders ridders[N_DERIVADAS];
     
-    printf("+----+--------------------------------------+-----------------+----------+\n");
+    if (MODO_DERIVADAS == DERIVADAS_RIDDERS) {
+        static const char *etiquetas[N_DERIVADAS] = {
+            "a) D[f(x), x]      ", "b) D[f(x), {x, 2}] ", "c) D[f(x,y), x]    ",
+            "d) D[f(x,y), y]    ", "e) D[f(x,y), {x,2}]", "f) D[f(x,y), {y,2}]",
+            "g) D[f(x,y), {x,y}]", "h) D[f(x,y), {x,3}]"
+        };
+        double paso_fijo[N_DERIVADAS] = {da, db, dc, dd, de, df, dg, dh};
+        static const int evaluaciones_fijo[N_DERIVADAS] = {2, 3, 2, 2, 3, 3, 4, 4};
+        long total_fijo = 0;
+        
+        printf("\n RICHARDSON / RIDDERS (h0 = %.3g, factor %.1f, max %d filas):\n",
+               RIDDERS_H_INICIAL, RIDDERS_FACTOR, RIDDERS_MAX_FILAS);
+        printf("+---------------------+-------------------+----------+-------+-------+------------+\n");
+        printf("| Derivada            | Valor Ridders     | Error est| Filas | Evals | |R - h fijo||\n");
+        printf("+---------------------+-------------------+----------+-------+-------+------------+\n");
+        
+        for (int k = 0; k < N_DERIVADAS; k++) {
+            ridders[k] = derivada_ridders(k, x0, y0, RIDDERS_H_INICIAL);
+            VALIDAR(ridders[k].valor);
+            total_fijo += evaluaciones_fijo[k];
+            
+            printf("| %s | %17.12f | %8.1e | %5d | %5ld | %10.2e |\n",
+                   etiquetas[k], ridders[k].valor, ridders[k].error, ridders[k].filas,
+                   ridders[k].evaluaciones, fabs(ridders[k].valor - paso_fijo[k]));
+        }
+        printf("+---------------------+-------------------+----------+-------+-------+------------+\n");
+        printf("  Evaluaciones de f: %ld (Ridders) vs %ld (paso fijo h = %g)\n",
+               evaluaciones_funcion, total_fijo, h);
+    }
     
     // ============================================================================
     // GENERAR DATOS PARA GRAFICAS
@@ -280,12 +878,24 @@ int main() {
     printf("\n GENERANDO DATOS PARA GRAFICAS...\n");
     printf("-------------------------------------------------------------\n");
     
-    FILE *datos = abrir_archivo("derivadas.dat", "w");
-    fprintf(datos, "# x df/dx d^2f/dx^2\n");
+    SalidaDatos *datos = salida_abrir("derivadas.dat", FORMATO_SALIDA, "x df/dx d^2f/dx^2",
+                                      "%.6f %.6f %.6f\n");
+    if (motor_grafico == MOTOR_SVG) preparar_grafico();
     
     double dx_graf = (GRAFICO_FIN - GRAFICO_INICIO) / GRAFICO_PUNTOS;
     int puntos_validos = 0, puntos_invalidos = 0;
     
+    // Diferencias finitas: toda la red de una vez. Si un punto obliga a
+    // agrandar h, los siguientes se recalculan punto a punto con el nuevo h.
+    double f_menos[GRAFICO_PUNTOS + 1], f_centro[GRAFICO_PUNTOS + 1], f_mas[GRAFICO_PUNTOS + 1];
+    double d1_red[GRAFICO_PUNTOS + 1], d2_red[GRAFICO_PUNTOS + 1];
+    double h_red = h;
+    
+    if (MODO_DERIVADAS != DERIVADAS_AUTOMATICA) {
+        muestrear_red(GRAFICO_INICIO, dx_graf, GRAFICO_PUNTOS + 1, h_red, f_menos, f_centro, f_mas);
+        diferencias_red(f_menos, f_centro, f_mas, GRAFICO_PUNTOS + 1, h_red, d1_red, d2_red);
+    }
+    
     for (int i = 0; i <= GRAFICO_PUNTOS; i++) {
         double x = GRAFICO_INICIO + i * dx_graf;
         
@@ -293,24 +903,42 @@ int main() {
         double d1, d2;
         int valido = 1;
         
-        try_calc:
-        d1 = (FUNCION_X(x + h) - FUNCION_X(x - h)) / (2*h);
-        d2 = (FUNCION_X(x + h) - 2*FUNCION_X(x) + FUNCION_X(x - h)) / (h*h);
-        
-        if (!es_numerico_valido(d1) || !es_numerico_valido(d2)) {
-            if (h > 1e-10) {
-                // Intentar con h mas grande
-                h *= 2;
-                printf(" Ajustando h a %.2e para x = %.3f\n", h, x);
-                goto try_calc;
-            } else {
+        if (MODO_DERIVADAS == DERIVADAS_AUTOMATICA) {
+            // Una evaluacion por punto: x = x + e1 + e2
+            HiperDual f = EVAL_X_AD(hd_variable(x, HD_E1|HD_E2));
+            d1 = f.c[HD_E1];
+            d2 = f.c[HD_E1|HD_E2];
+            if (!es_numerico_valido(d1) || !es_numerico_valido(d2)) {
                 puntos_invalidos++;
                 valido = 0;
             }
+        } else if (h == h_red && es_numerico_valido(d1_red[i]) && es_numerico_valido(d2_red[i])) {
+            d1 = d1_red[i];
+            d2 = d2_red[i];
+        } else {
+            try_calc:
+            d1 = (EVAL_X(x + h) - EVAL_X(x - h)) / (2*h);
+            d2 = (EVAL_X(x + h) - 2*EVAL_X(x) + EVAL_X(x - h)) / (h*h);
+            
+            if (!es_numerico_valido(d1) || !es_numerico_valido(d2)) {
+                if (h > 1e-10) {
+                    // Intentar con h mas grande
+                    h *= 2;
+                    printf(" Ajustando h a %.2e para x = %.3f\n", h, x);
+                    goto try_calc;
+                } else {
+                    puntos_invalidos++;
+                    valido = 0;
+                }
+            }
         }
         
         if (valido) {
-            fprintf(datos, "%.6f %.6f %.6f\n", x, d1, d2);
+            SALIDA_FILA(datos, x, d1, d2);
+            if (motor_grafico == MOTOR_SVG) {
+                grafico_punto(&grafico, SERIE_PRIMERA, x, d1);
+                grafico_punto(&grafico, SERIE_SEGUNDA, x, d2);
+            }
             puntos_validos++;
         }
         
@@ -321,7 +949,11 @@ int main() {
         }
     }
     
-    fclose(datos);
+    salida_cerrar(datos);
+    
+    if (MODO_DERIVADAS != DERIVADAS_AUTOMATICA) {
+        printf("  Red de muestreo: %d evaluaciones de f(x) (3 por punto)\n", 3 * (GRAFICO_PUNTOS + 1));
+    }
     
     if (puntos_invalidos > 0) {
         printf(" ADVERTENCIA: %d puntos no pudieron calcularse\n", puntos_invalidos);
@@ -329,27 +961,30 @@ int main() {
     }
     
     // ============================================================================
-    // CREAR SCRIPT GNUPLOT
+    // CREAR SCRIPT GNUPLOT (con MOTOR_SVG el grafico se arma en memoria)
     // ============================================================================
-    FILE *script = abrir_archivo("derivadas_plot.gp", "w");
-    
-    fprintf(script, "# Script para derivadas numericas\n");
-    fprintf(script, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
-            ANCHO_GRAFICO, ALTO_GRAFICO);
-    fprintf(script, "set output '%s'\n", NOMBRE_GRAFICO);
-    fprintf(script, "set title 'Derivadas de f(x) = sin(x) + x²'\n");
-    fprintf(script, "set xlabel 'x'\n");
-    fprintf(script, "set ylabel 'Valor de derivada'\n");
-    fprintf(script, "set grid\n");
-    fprintf(script, "set key top left box\n");
-    fprintf(script, "set xrange [%f:%f]\n", GRAFICO_INICIO, GRAFICO_FIN);
-    
-    fprintf(script, "plot 'derivadas.dat' u 1:2 w l lw 2 lc rgb '#0066CC' title 'Primera derivada f''(x)', \\\n");
-    fprintf(script, "     '' u 1:3 w l lw 2 lc rgb '#FF3333' dt 2 title 'Segunda derivada f''''(x)', \\\n");
-    fprintf(script, "     %f, %f w p pt 7 ps 2 lc rgb '#00AA00' title 'Punto (x0, %.3f)'\n", 
-            x0, da, da);
-    
-    fclose(script);
+    if (motor_grafico == MOTOR_GNUPLOT) {
+        FILE *script = abrir_archivo("derivadas_plot.gp", "w");
+        
+        fprintf(script, "# Script para derivadas numericas\n");
+        fprintf(script, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
+                ANCHO_GRAFICO, ALTO_GRAFICO);
+        fprintf(script, "set output '%s'\n", NOMBRE_GRAFICO);
+        fprintf(script, "set title 'Derivadas de f(x) = %s'\n", expr_fx.activa ? expr_fx.texto : "sin(x) + x²");
+        fprintf(script, "set xlabel 'x'\n");
+        fprintf(script, "set ylabel 'Valor de derivada'\n");
+        fprintf(script, "set grid\n");
+        fprintf(script, "set key top left box\n");
+        fprintf(script, "set xrange [%f:%f]\n", GRAFICO_INICIO, GRAFICO_FIN);
+        
+        fprintf(script, "plot %s u 1:2 w l lw 2 lc rgb '#0066CC' title 'Primera derivada f''(x)', \\\n",
+                fuente_gnuplot("derivadas.dat", FORMATO_SALIDA));
+        fprintf(script, "     '' u 1:3 w l lw 2 lc rgb '#FF3333' dt 2 title 'Segunda derivada f''''(x)', \\\n");
+        fprintf(script, "     %f, %f w p pt 7 ps 2 lc rgb '#00AA00' title 'Punto (x0, %.3f)'\n", 
+                x0, da, da);
+        
+        fclose(script);
+    }
     
     // ============================================================================
     // EJECUTAR GNUPLOT
@@ -357,14 +992,20 @@ int main() {
     printf("\n GENERANDO GRAFICO...\n");
     printf("-------------------------------------------------------------\n");
     
-    int resultado = system("gnuplot derivadas_plot.gp 2>&1");
+    int resultado = (motor_grafico == MOTOR_SVG) ? graficar_svg(x0, da)
+                                                 : system("gnuplot derivadas_plot.gp 2>&1");
     
     if (resultado != 0) {
-        printf(" ADVERTENCIA: Gnuplot reporto problemas\n");
-        printf("   Comando: gnuplot derivadas_plot.gp\n");
-        printf("   Verifique que Gnuplot este instalado correctamente\n");
+        if (motor_grafico == MOTOR_GNUPLOT) {
+            printf(" ADVERTENCIA: Gnuplot reporto problemas\n");
+            printf("   Comando: gnuplot derivadas_plot.gp\n");
+            printf("   Verifique que Gnuplot este instalado correctamente\n");
+        } else {
+            printf(" ADVERTENCIA: No se pudo escribir el grafico SVG\n");
+        }
     } else {
-        printf(" Grafico generado: %s\n", NOMBRE_GRAFICO);
+        printf(" Grafico generado: %s\n",
+               (motor_grafico == MOTOR_SVG) ? grafico_nombre_svg(NOMBRE_GRAFICO) : NOMBRE_GRAFICO);
     }
     
     // ============================================================================
@@ -373,10 +1014,21 @@ int main() {
     printf("\n ANALISIS DE ERROR (comparacion con valores analiticos):\n");
     printf("-------------------------------------------------------------\n");
     
-    // Valores analiticos exactos en x0 = 1.0
+    // Valores analiticos exactos en x0 = 1.0 (solo validos para la macro
+    // FUNCION_X; con una expresion de tiempo de ejecucion se usa la
+    // diferencia central de orden 4 con h mayor como referencia)
     double da_analitica = cos(x0) + 2*x0;        // cos(1) + 2
     double db_analitica = -sin(x0) + 2;          // -sin(1) + 2
     
+    if (expr_fx.activa) {
+        double hr = 1e-3;
+        double f2p = EVAL_X(x0 + 2*hr), f1p = EVAL_X(x0 + hr), f0 = EVAL_X(x0);
+        double f1m = EVAL_X(x0 - hr), f2m = EVAL_X(x0 - 2*hr);
+        da_analitica = (-f2p + 8*f1p - 8*f1m + f2m) / (12*hr);
+        db_analitica = (-f2p + 16*f1p - 30*f0 + 16*f1m - f2m) / (12*hr*hr);
+        printf("  (FUNCION_X en tiempo de ejecucion: referencia de orden 4)\n");
+    }
+    
     double error_abs_a = fabs(da - da_analitica);
     double error_rel_a = 100 * error_abs_a / fabs(da_analitica);
     double error_abs_b = fabs(db - db_analitica);
@@ -388,11 +1040,22 @@ int main() {
     printf("    Error absoluto:   %.2e\n", error_abs_a);
     printf("    Error relativo:   %.2e%%\n", error_rel_a);
     
+    if (MODO_DERIVADAS == DERIVADAS_RIDDERS) {
+        printf("    Ridders:          %.12f (error %.2e, estimado %.1e)\n",
+               ridders[DER_PRIMERA].valor, fabs(ridders[DER_PRIMERA].valor - da_analitica),
+               ridders[DER_PRIMERA].error);
+    }
+    
     printf("\n  Segunda derivada (f''(x)):\n");
     printf("    Valor numerico:   %.8f\n", db);
     printf("    Valor analitico:  %.8f\n", db_analitica);
     printf("    Error absoluto:   %.2e\n", error_abs_b);
     printf("    Error relativo:   %.2e%%\n", error_rel_b);
+    if (MODO_DERIVADAS == DERIVADAS_RIDDERS) {
+        printf("    Ridders:          %.12f (error %.2e, estimado %.1e)\n",
+               ridders[DER_SEGUNDA].valor, fabs(ridders[DER_SEGUNDA].valor - db_analitica),
+               ridders[DER_SEGUNDA].error);
+    }
     
     // Evaluar calidad de aproximacion
     printf("\n  EVALUACION DE LA APROXIMACION:\n");
@@ -415,7 +1078,8 @@ int main() {
     printf("  Puntos para grafico:   %d/%d validos\n", puntos_validos, GRAFICO_PUNTOS + 1);
     printf("  Error maximo:          %.2e%%\n", fmax(error_rel_a, error_rel_b));
     printf("  Grafico generado:      %s\n", (resultado == 0) ? "SI" : "NO");
-    printf("  Archivos creados:      derivadas.dat, derivadas_plot.gp\n");
+    printf("  Archivos creados:      %s, %s\n", nombre_salida("derivadas.dat", FORMATO_SALIDA),
+           (motor_grafico == MOTOR_SVG) ? grafico_nombre_svg(NOMBRE_GRAFICO) : "derivadas_plot.gp");
     
     printf("\n EJECUCION COMPLETADA\n");
     
@@ -5,6 +5,14 @@
 #include <math.h>
 #include <stdlib.h>
 #include <errno.h>
+#include "nucleo.h"
+#include "datos_columnar.h"
+#include "expresion.h"
+#include "benchmark.h"
+#include "estadistica.h"
+#include "grafico.h"
+#include "barrido.h"
+#include "convergencia.h"
 
 // ============================================================================
 // PARAMETROS CONFIGURABLES
@@ -15,32 +23,48 @@
 #define X_FINAL             5.0
 #define Y_INICIAL           1.0
 #define PASO_H              0.1
-#define NOMBRE_GRAFICO      "rk4_grafico.png"
+#define MODO_INTEGRADOR     INTEGRADOR_RK4   // INTEGRADOR_RK4 o INTEGRADOR_DOPRI5
+#define TOLERANCIA_ABS      1e-8             // Solo para INTEGRADOR_DOPRI5
+#define TOLERANCIA_REL      1e-8             // Solo para INTEGRADOR_DOPRI5
+#define FORMATO_SALIDA      FORMATO_TEXTO    // FORMATO_TEXTO o FORMATO_BINARIO
+#define NIVEL_VALIDACION    VALIDACION_OPERACION  // _OPERACION, _PASO o _NINGUNA (o entorno VALIDACION)
+#define MOTOR_GRAFICO       MOTOR_GNUPLOT    // MOTOR_GNUPLOT o MOTOR_SVG (o entorno GRAFICO)
+#define NOMBRE_GRAFICO      "rk4_grafico.png" // Con MOTOR_SVG: rk4_grafico.svg
 #define ANCHO_GRAFICO       800
 #define ALTO_GRAFICO        600
 // ============================================================================
 
+#define INTEGRADOR_RK4      0   // Paso fijo PASO_H
+#define INTEGRADOR_DOPRI5   1   // Dormand-Prince 5(4) con paso adaptativo
+
+// Contador global de evaluaciones de EDO_FUNCION
+long evaluaciones_edo = 0;
+
+// Funciones definidas en tiempo de ejecucion: las variables de entorno
+// EDO_FUNCION y SOLUCION_EXACTA (juntas) reemplazan a las macros, p. ej.
+//   EDO_FUNCION="x - y" SOLUCION_EXACTA="x - 1 + 2*exp(-x)" ./ecuacion1
+Expresion expr_edo, expr_exacta;
+
+#define EVAL_EDO(x,y)       (expr_edo.activa ? expr_evaluar_2(&expr_edo, (x), (y)) : EDO_FUNCION(x,y))
+#define EVAL_EXACTA(x)      (expr_exacta.activa ? expr_evaluar_1(&expr_exacta, (x)) : SOLUCION_EXACTA(x))
+
 // ============================================================================
 // FUNCIONES DE VALIDACION
 // ============================================================================
-int es_numerico_valido(double valor) {
-    return !(isnan(valor) || isinf(valor) || fabs(valor) > 1e100);
-}
-
-void verificar_nan_inf(const char *nombre, double valor, int linea) {
-    if (isnan(valor)) {
-        printf(" ERROR [Linea %d]: %s = NaN\n", linea, nombre);
-        printf("   Causa posible: Operacion matematica invalida\n");
-        exit(EXIT_FAILURE);
-    }
-    if (isinf(valor)) {
-        printf(" ERROR [Linea %d]: %s = Infinito\n", linea, nombre);
-        printf("   Causa posible: Overflow numerico\n");
+void cargar_expresiones() {
+    expr_desde_entorno(&expr_edo, "EDO_FUNCION", "x y");
+    expr_desde_entorno(&expr_exacta, "SOLUCION_EXACTA", "x");
+    
+    // El estudio de convergencia no necesita la solucion exacta
+    if (expr_edo.activa != expr_exacta.activa && !(expr_edo.activa && convergencia_solicitada(NULL))) {
+        printf(" ERROR: EDO_FUNCION y SOLUCION_EXACTA deben definirse juntas en el entorno\n");
         exit(EXIT_FAILURE);
     }
 }
 
-#define VALIDAR(variable) verificar_nan_inf(#variable, variable, __LINE__)
+const char* texto_edo() {
+    return expr_edo.activa ? expr_edo.texto : "x - y";
+}
 
 void validar_parametros() {
     if (PASO_H <= 0) {
@@ -54,6 +78,12 @@ void validar_parametros() {
         exit(EXIT_FAILURE);
     }
     
+    if (MODO_INTEGRADOR == INTEGRADOR_DOPRI5 && (TOLERANCIA_ABS < 0 || TOLERANCIA_REL < 0 ||
+                                                 TOLERANCIA_ABS + TOLERANCIA_REL <= 0)) {
+        printf(" ERROR: Tolerancias invalidas (abs = %e, rel = %e)\n", TOLERANCIA_ABS, TOLERANCIA_REL);
+        exit(EXIT_FAILURE);
+    }
+    
     if (!es_numerico_valido(Y_INICIAL)) {
         printf(" ERROR: Y_INICIAL invalido: %f\n", Y_INICIAL);
         exit(EXIT_FAILURE);
@@ -61,7 +91,7 @@ void validar_parametros() {
     
     // Validar solucion exacta en algunos puntos
     for (double x = X_INICIAL; x <= X_FINAL; x += 1.0) {
-        double y_exacta = SOLUCION_EXACTA(x);
+        double y_exacta = EVAL_EXACTA(x);
         if (!es_numerico_valido(y_exacta)) {
             printf(" ERROR: Solucion exacta invalida en x = %f\n", x);
             exit(EXIT_FAILURE);
@@ -69,53 +99,71 @@ void validar_parametros() {
     }
 }
 
-FILE* abrir_archivo(const char *nombre, const char *modo) {
-    FILE *archivo = fopen(nombre, modo);
-    if (archivo == NULL) {
-        printf(" ERROR: No se pudo abrir '%s'\n", nombre);
-        printf("   Error del sistema: %d\n", errno);
-        exit(EXIT_FAILURE);
+// ============================================================================
+// GRAFICO EN MEMORIA (MOTOR_SVG)
+// ============================================================================
+// Mismo contenido que rk4_plot.gp, armado con los puntos de guardar_fila
+#define SERIE_NUMERICA      0
+#define SERIE_EXACTA        1
+#define SERIE_ERROR         2
+
+PanelGrafico grafico;
+
+void preparar_grafico() {
+    char titulo[GRAFICO_LARGO_TEXTO];
+    snprintf(titulo, sizeof(titulo), "Metodo de Runge-Kutta 4: y' = %.120s", texto_edo());
+    
+    grafico_iniciar(&grafico, titulo, "x", "y(x)");
+    snprintf(grafico.etiqueta_y2, GRAFICO_LARGO_TEXTO, "Error absoluto");
+    grafico_rango_x(&grafico, X_INICIAL, X_FINAL);
+    grafico_serie(&grafico, "Solucion RK4", "#0066CC", TRAZO_LINEA | TRAZO_PUNTOS, 1.0);
+    grafico_serie(&grafico, "Solucion exacta", "#FF3333", TRAZO_LINEA, 2.0);
+    grafico_serie(&grafico, "Error", "#00AA00", TRAZO_LINEA | TRAZO_EJE_Y2, 1.0);
+}
+
+// Una fila de resultados: a los archivos de datos y, con MOTOR_SVG, al grafico
+void guardar_fila(SalidaDatos *datos_sol, SalidaDatos *datos_err, double x, double y, double error) {
+    SALIDA_FILA(datos_sol, x, y);
+    SALIDA_FILA(datos_err, x, error);
+    
+    if (motor_grafico == MOTOR_SVG) {
+        grafico_punto(&grafico, SERIE_NUMERICA, x, y);
+        grafico_punto(&grafico, SERIE_ERROR, x, error);
+    }
+}
+
+// La solucion exacta se evalua aqui, asi que tambien se dibuja cuando viene
+// del entorno (gnuplot no entiende la sintaxis de expresion.h)
+int graficar_svg() {
+    for (int i = 0; i <= GRAFICO_MUESTRAS; i++) {
+        double x = X_INICIAL + (X_FINAL - X_INICIAL) * i / GRAFICO_MUESTRAS;
+        grafico_punto(&grafico, SERIE_EXACTA, x, EVAL_EXACTA(x));
     }
-    return archivo;
+    
+    int resultado = grafico_escribir_svg(grafico_nombre_svg(NOMBRE_GRAFICO), ANCHO_GRAFICO, ALTO_GRAFICO,
+                                         &grafico, 1);
+    grafico_liberar(&grafico);
+    return resultado;
 }
 
 // ============================================================================
 // RUNGE-KUTTA 4 CON VALIDACION
 // ============================================================================
+void derivada_edo(double x, const double *y, double *dy) {
+    dy[0] = EVAL_EDO(x, y[0]);
+}
+
+const ProblemaEDO problema_edo = { 1, derivada_edo };
+
 double rk4_validado(double x, double y, double h, int paso_actual) {
-    double k1, k2, k3, k4;
-    
-    // k1
-    k1 = EDO_FUNCION(x, y);
-    VALIDAR(k1);
-    
-    // k2
-    double x2 = x + h/2;
-    double y2 = y + h*k1/2;
-    VALIDAR(x2); VALIDAR(y2);
-    
-    k2 = EDO_FUNCION(x2, y2);
-    VALIDAR(k2);
-    
-    // k3
-    double x3 = x + h/2;
-    double y3 = y + h*k2/2;
-    VALIDAR(x3); VALIDAR(y3);
-    
-    k3 = EDO_FUNCION(x3, y3);
-    VALIDAR(k3);
+    double estado[1] = { y };
     
-    // k4
-    double x4 = x + h;
-    double y4 = y + h*k3;
-    VALIDAR(x4); VALIDAR(y4);
+    // Etapas k1..k4 validadas en rk4_paso_edo (nucleo.h)
+    rk4_paso_edo(&problema_edo, x, estado, h);
     
-    k4 = EDO_FUNCION(x4, y4);
-    VALIDAR(k4);
+    evaluaciones_edo += 4;
     
-    // Resultado final
-    double resultado = y + h*(k1 + 2*k2 + 2*k3 + k4)/6;
-    VALIDAR(resultado);
+    double resultado = estado[0];
     
     // Detectar inestabilidad
     if (fabs(resultado) > 1e10 && paso_actual > 10) {
@@ -126,6 +174,234 @@ double rk4_validado(double x, double y, double h, int paso_actual) {
     return resultado;
 }
 
+// ============================================================================
+// DORMAND-PRINCE 5(4) CON PASO ADAPTATIVO
+// ============================================================================
+// Un paso del par embebido. k[0] debe contener EDO_FUNCION(x, y) y al salir
+// k[6] = EDO_FUNCION(x + h, y_nuevo) (propiedad FSAL: se reutiliza como k1 del
+// paso siguiente si el paso es aceptado). Devuelve la solucion de orden 5 y en
+// *error_local la diferencia con la de orden 4.
+double dopri5_paso(double x, double y, double h, double k[7], double *error_local) {
+    k[1] = EVAL_EDO(x + h/5, y + h*(k[0]/5));
+    k[2] = EVAL_EDO(x + 3*h/10, y + h*(3*k[0]/40 + 9*k[1]/40));
+    k[3] = EVAL_EDO(x + 4*h/5, y + h*(44*k[0]/45 - 56*k[1]/15 + 32*k[2]/9));
+    k[4] = EVAL_EDO(x + 8*h/9, y + h*(19372*k[0]/6561 - 25360*k[1]/2187
+                                         + 64448*k[2]/6561 - 212*k[3]/729));
+    k[5] = EVAL_EDO(x + h, y + h*(9017*k[0]/3168 - 355*k[1]/33 + 46732*k[2]/5247
+                                     + 49*k[3]/176 - 5103*k[4]/18656));
+    
+    double resultado = y + h*(35*k[0]/384 + 500*k[2]/1113 + 125*k[3]/192
+                              - 2187*k[4]/6784 + 11*k[5]/84);
+    VALIDAR(resultado);
+    
+    k[6] = EVAL_EDO(x + h, resultado);
+    VALIDAR(k[6]);
+    evaluaciones_edo += 6;
+    
+    *error_local = h*(71*k[0]/57600 - 71*k[2]/16695 + 71*k[3]/1920
+                      - 17253*k[4]/339200 + 22*k[5]/525 - k[6]/40);
+    VALIDAR(*error_local);
+    
+    return resultado;
+}
+
+// Integra de X_INICIAL a X_FINAL con control de error por paso
+// |err| <= TOLERANCIA_ABS + TOLERANCIA_REL*max(|y|, |y_nuevo|). Escribe cada
+// paso aceptado en los archivos de datos, acumula su error en 'errores' y
+// devuelve el numero de pasos.
+int integrar_dopri5(SalidaDatos *datos_sol, SalidaDatos *datos_err, double *y_final,
+                    EstadisticaOnline *errores, int *rechazos) {
+    double x = X_INICIAL;
+    double y = Y_INICIAL;
+    double h = PASO_H;
+    double h_min = 1e-12 * (X_FINAL - X_INICIAL);
+    double k[7];
+    int paso = 0;
+    
+    *rechazos = 0;
+    k[0] = EVAL_EDO(x, y);
+    VALIDAR(k[0]);
+    evaluaciones_edo++;
+    
+    while (1) {
+        double exacta = EVAL_EXACTA(x);
+        VALIDAR(exacta);
+        
+        double error = fabs(y - exacta);
+        estad_agregar(errores, error);
+        
+        if (paso % 5 == 0) {
+            printf("| %4d | %6.2f | %9.5f | %9.5f | %9.5f | h=%7.1e |\n", 
+                   paso, x, y, exacta, error, h);
+        }
+        
+        guardar_fila(datos_sol, datos_err, x, y, error);
+        
+        if (x >= X_FINAL) break;
+        
+        // Buscar un paso aceptable
+        double y_nuevo, h_usado;
+        while (1) {
+            if (x + h > X_FINAL) h = X_FINAL - x;
+            
+            double error_local;
+            validacion_abrir_lote();
+            y_nuevo = dopri5_paso(x, y, h, k, &error_local);
+            if (validacion_cerrar_lote("paso", paso)) {
+                y_nuevo = dopri5_paso(x, y, h, k, &error_local);
+                validacion_fin_repeticion();
+            }
+            
+            double escala = TOLERANCIA_ABS + TOLERANCIA_REL * fmax(fabs(y), fabs(y_nuevo));
+            double razon = fabs(error_local) / escala;
+            
+            // Factor de ajuste con seguridad 0.9, limitado a [0.2, 5]
+            double factor = (razon > 0) ? 0.9 * pow(razon, -0.2) : 5.0;
+            factor = fmin(5.0, fmax(0.2, factor));
+            
+            h_usado = h;
+            if (razon <= 1.0) {
+                h *= factor;
+                break;
+            }
+            
+            (*rechazos)++;
+            h *= fmin(factor, 1.0);
+            
+            if (h < h_min) {
+                printf(" ERROR: Paso adaptativo demasiado pequeño (h = %.2e) en x = %.6f\n", h, x);
+                *y_final = y;
+                return -1;
+            }
+        }
+        
+        y = y_nuevo;
+        x = (X_FINAL - x - h_usado < h_min) ? X_FINAL : x + h_usado;
+        k[0] = k[6];
+        paso++;
+    }
+    
+    *y_final = y;
+    return paso;
+}
+
+// ============================================================================
+// BARRIDO DE PARAMETROS (BARRIDO=... ./ecuacion1, ver barrido.h)
+// ============================================================================
+// Cada conjunto (PASO_H, X_FINAL, Y_INICIAL) se integra con RK4 de paso fijo
+// sin escribir archivos. Con la Y_INICIAL de la macro el error se mide contra
+// SOLUCION_EXACTA; con otra, contra RK4 de paso h/BARRIDO_REFINAMIENTO.
+#define PARAMETROS_BARRIDO  "PASO_H X_FINAL Y_INICIAL"
+
+void trabajo_barrido(const double *p, int fase, ResultadoBarrido *r) {
+    double h = p[0], x_final = p[1];
+    double y[1] = { p[2] }, y_ref[1] = { p[2] };
+    long pasos = barrido_pasos(X_INICIAL, x_final, h);
+    
+    if (pasos == 0) {
+        r->estado = BARRIDO_RECHAZADO;
+        return;
+    }
+    r->con_exacta = (p[2] == Y_INICIAL);
+    
+    for (long i = 0; i < pasos; i++) {
+        double x = X_INICIAL + i*h;
+        double h_paso = (i == pasos - 1) ? x_final - x : h;
+        
+        rk4_paso_edo(&problema_edo, x, y, h_paso);
+        if (fase == BARRIDO_FASE_METODO) r->pasos++;
+        if (!es_numerico_valido(y[0])) {
+            r->estado = BARRIDO_INVALIDO;
+            break;
+        }
+        if (fase == BARRIDO_FASE_METODO) continue;
+        
+        double referencia;
+        if (r->con_exacta) {
+            referencia = EVAL_EXACTA(x + h_paso);
+        } else {
+            for (int k = 0; k < BARRIDO_REFINAMIENTO; k++) {
+                rk4_paso_edo(&problema_edo, x + k*h_paso/BARRIDO_REFINAMIENTO, y_ref,
+                             h_paso/BARRIDO_REFINAMIENTO);
+            }
+            referencia = y_ref[0];
+        }
+        barrido_error(r, fabs(y[0] - referencia));
+    }
+    r->evaluaciones = 4 * r->pasos;
+}
+
+int ejecutar_barrido() {
+    const double por_defecto[] = { PASO_H, X_FINAL, Y_INICIAL };
+    
+    printf(" Ecuacion: y' = %s, y(%.1f) = Y_INICIAL\n", texto_edo(), X_INICIAL);
+    if (MODO_INTEGRADOR != INTEGRADOR_RK4) {
+        printf(" El barrido usa RK4 de paso fijo (MODO_INTEGRADOR se ignora)\n");
+    }
+    printf("\n");
+    return barrido_correr("ecuacion1", PARAMETROS_BARRIDO, por_defecto, trabajo_barrido);
+}
+
+// ============================================================================
+// ESTUDIO DE CONVERGENCIA (CONVERGENCIA=tol ./ecuacion1, ver convergencia.h)
+// ============================================================================
+void exacta_convergencia(double x, double *y) {
+    y[0] = EVAL_EXACTA(x);
+}
+
+int ejecutar_convergencia(double tolerancia) {
+    const double y_inicial[1] = { Y_INICIAL };
+    int con_exacta = !expr_edo.activa || expr_exacta.activa;
+    EstudioConvergencia estudio = { &problema_edo, X_INICIAL, X_FINAL, PASO_H, y_inicial, 1, "y",
+                                    con_exacta ? exacta_convergencia : NULL, FORMATO_SALIDA };
+    
+    printf(" Ecuacion: y' = %s, y(%.1f) = %.1f\n\n", texto_edo(), X_INICIAL, Y_INICIAL);
+    return convergencia_ejecutar(&estudio, tolerancia);
+}
+
+// ============================================================================
+// MICRO-BENCHMARKS (BENCHMARK=1 ./ecuacion1)
+// ============================================================================
+// Una llamada = un paso. La trayectoria recorre [X_INICIAL, X_FINAL] y vuelve
+// a empezar, asi los pasos medidos son los mismos que en una corrida normal.
+ConteoBench bench_rk4(void *contexto, long llamadas) {
+    (void)contexto;
+    long evaluaciones_inicio = evaluaciones_edo;
+    double x = X_INICIAL, y = Y_INICIAL;
+    
+    for (long i = 0; i < llamadas; i++) {
+        if (x > X_FINAL) { x = X_INICIAL; y = Y_INICIAL; }
+        y = rk4_validado(x, y, PASO_H, 0);
+        x += PASO_H;
+    }
+    bench_sumidero += y;
+    return (ConteoBench){ llamadas, evaluaciones_edo - evaluaciones_inicio };
+}
+
+ConteoBench bench_dopri5(void *contexto, long llamadas) {
+    (void)contexto;
+    long evaluaciones_inicio = evaluaciones_edo;
+    double x = X_INICIAL, y = Y_INICIAL, k[7], error_local;
+    
+    k[0] = EVAL_EDO(x, y);
+    for (long i = 0; i < llamadas; i++) {
+        if (x > X_FINAL) { x = X_INICIAL; y = Y_INICIAL; k[0] = EVAL_EDO(x, y); }
+        y = dopri5_paso(x, y, PASO_H, k, &error_local);
+        x += PASO_H;
+        k[0] = k[6];
+    }
+    bench_sumidero += y + error_local;
+    return (ConteoBench){ llamadas, evaluaciones_edo - evaluaciones_inicio };
+}
+
+int ejecutar_benchmark() {
+    bench_encabezado("ecuacion1");
+    bench_medir("ecuacion1", "rk4_validado", "paso", bench_rk4, NULL);
+    bench_medir("ecuacion1", "dopri5_paso", "paso", bench_dopri5, NULL);
+    bench_pie();
+    return EXIT_SUCCESS;
+}
+
 // ============================================================================
 // PROGRAMA PRINCIPAL
 // ============================================================================
@@ -136,15 +412,32 @@ int main() {
     printf(" VALIDANDO PARAMETROS...\n");
     printf("-------------------------------------------------------------\n");
     
+    validacion_iniciar(NIVEL_VALIDACION);
+    evaluaciones_edo = 0;
+    grafico_iniciar_motor(MOTOR_GRAFICO);
+    cargar_expresiones();
     validar_parametros();
     
+    if (bench_solicitado()) {
+        return ejecutar_benchmark();
+    }
+    
+    if (barrido_solicitado()) {
+        return ejecutar_barrido();
+    }
+    
+    double tolerancia;
+    if (convergencia_solicitada(&tolerancia)) {
+        return ejecutar_convergencia(tolerancia);
+    }
+    
     double x = X_INICIAL;
     double y = Y_INICIAL;
     int paso = 0;
     int pasos_totales = (int)((X_FINAL - X_INICIAL) / PASO_H) + 1;
     
     printf(" Parametros validos\n");
-    printf("   Ecuacion: y' = x - y\n");
+    printf("   Ecuacion: y' = %s\n", texto_edo());
     printf("   Condicion inicial: y(%.1f) = %.1f\n", X_INICIAL, Y_INICIAL);
     printf("   Intervalo: [%.1f, %.1f]\n", X_INICIAL, X_FINAL);
     printf("   Paso: h = %.3f\n", PASO_H);
@@ -153,11 +446,21 @@ int main() {
     // ============================================================================
     // CONFIGURACION
     // ============================================================================
-    printf(" ECUACION DIFERENCIAL: y' = x - y (RK4) \n\n");
+    if (MODO_INTEGRADOR == INTEGRADOR_DOPRI5) {
+        printf(" ECUACION DIFERENCIAL: y' = %s (Dormand-Prince 5(4)) \n", texto_edo());
+        printf("   Tolerancias: abs = %.1e, rel = %.1e\n\n", TOLERANCIA_ABS, TOLERANCIA_REL);
+    } else {
+        printf(" ECUACION DIFERENCIAL: y' = %s (RK4) \n\n", texto_edo());
+    }
     
-    FILE *datos_sol = abrir_archivo("rk4_solucion.dat", "w");
-    FILE *datos_err = abrir_archivo("rk4_error.dat", "w");
-    FILE *script_gp = abrir_archivo("rk4_plot.gp", "w");
+    SalidaDatos *datos_sol = salida_abrir("rk4_solucion.dat", FORMATO_SALIDA, "x y", "%.6f %.6f\n");
+    SalidaDatos *datos_err = salida_abrir("rk4_error.dat", FORMATO_SALIDA, "x error", "%.6f %.6f\n");
+    FILE *script_gp = NULL;
+    if (motor_grafico == MOTOR_SVG) {
+        preparar_grafico();
+    } else {
+        script_gp = abrir_archivo("rk4_plot.gp", "w");
+    }
     
     printf("PROCESO DE INTEGRACION:\n");
     printf("+------+--------+-----------+-----------+-----------+-----------+\n");
@@ -165,85 +468,100 @@ int main() {
     printf("+------+--------+-----------+-----------+-----------+-----------+\n");
     
     int errores_numericos = 0;
-    double error_maximo = 0.0;
+    EstadisticaOnline errores;
+    estad_iniciar(&errores);
     
     // ============================================================================
-    // INTEGRACION CON RUNGE-KUTTA 4
+    // INTEGRACION (RUNGE-KUTTA 4 O DORMAND-PRINCE 5(4))
     // ============================================================================
-    while (x <= X_FINAL + PASO_H/2) {
-        // Calcular solucion exacta
-        double exacta = SOLUCION_EXACTA(x);
-        VALIDAR(exacta);
-        
-        double error = fabs(y - exacta);
-        VALIDAR(error);
+    int rechazos = 0;
+    
+    if (MODO_INTEGRADOR == INTEGRADOR_DOPRI5) {
+        paso = integrar_dopri5(datos_sol, datos_err, &y, &errores, &rechazos);
         
-        if (error > error_maximo) {
-            error_maximo = error;
+        if (paso < 0) {
+            salida_cerrar(datos_sol);
+            salida_cerrar(datos_err);
+            return EXIT_FAILURE;
         }
-        
-        // Estado de validacion
-        const char *estado = "- OK";
-        if (!es_numerico_valido(y)) {
-            estado = "- INVALIDO";
-            errores_numericos++;
+        x = X_FINAL;
+    } else {
+        while (x <= X_FINAL + PASO_H/2) {
+            // Calcular solucion exacta
+            double exacta = EVAL_EXACTA(x);
+            VALIDAR(exacta);
             
-            printf("+------+--------+-----------+-----------+-----------+-----------+\n");
-            printf("| %4d | %6.2f | %9.5f | %9.5f | %9.5f | %s |\n", 
-                   paso, x, y, exacta, error, estado);
-            printf("+------+--------+-----------+-----------+-----------+-----------+\n");
+            double error = fabs(y - exacta);
+            VALIDAR(error);
             
-            printf("\n ERROR CRITICO: Valor no numerico en paso %d\n", paso);
-            printf("   x = %.6f, y = %.6f\n", x, y);
-            printf("   El metodo no puede continuar\n");
+            // Estado de validacion
+            const char *estado = "- OK";
+            if (!es_numerico_valido(y)) {
+                estado = "- INVALIDO";
+                errores_numericos++;
             
-            fclose(datos_sol);
-            fclose(datos_err);
-            return EXIT_FAILURE;
-        }
-        
-        // Mostrar cada 5 pasos
-        if (paso % 5 == 0) {
-            printf("| %4d | %6.2f | %9.5f | %9.5f | %9.5f | %s |\n", 
-                   paso, x, y, exacta, error, estado);
-        }
-        
-        // Guardar datos
-        fprintf(datos_sol, "%.6f %.6f\n", x, y);
-        fprintf(datos_err, "%.6f %.6f\n", x, error);
-        
-        // Ultimo punto
-        if (x >= X_FINAL) break;
-        
-        // Calcular siguiente punto
-        double y_nuevo = rk4_validado(x, y, PASO_H, paso);
-        
-        // Validar nuevo valor
-        if (!es_numerico_valido(y_nuevo)) {
-            printf(" ADVERTENCIA: Valor invalido en paso %d, ajustando...\n", paso);
+                printf("+------+--------+-----------+-----------+-----------+-----------+\n");
+                printf("| %4d | %6.2f | %9.5f | %9.5f | %9.5f | %s |\n", 
+                       paso, x, y, exacta, error, estado);
+                printf("+------+--------+-----------+-----------+-----------+-----------+\n");
+            
+                printf("\n ERROR CRITICO: Valor no numerico en paso %d\n", paso);
+                printf("   x = %.6f, y = %.6f\n", x, y);
+                printf("   El metodo no puede continuar\n");
+            
+                salida_cerrar(datos_sol);
+                salida_cerrar(datos_err);
+                return EXIT_FAILURE;
+            }
+            
+            // Mostrar cada 5 pasos
+            if (paso % 5 == 0) {
+                printf("| %4d | %6.2f | %9.5f | %9.5f | %9.5f | %s |\n", 
+                       paso, x, y, exacta, error, estado);
+            }
+            
+            // Guardar datos
+            guardar_fila(datos_sol, datos_err, x, y, error);
+            estad_agregar(&errores, error);
+            
+            // Ultimo punto
+            if (x >= X_FINAL) break;
+            
+            // Calcular siguiente punto (en el nivel PASO, un lote por paso)
+            validacion_abrir_lote();
+            double y_nuevo = rk4_validado(x, y, PASO_H, paso);
+            if (validacion_cerrar_lote("paso", paso)) {
+                y_nuevo = rk4_validado(x, y, PASO_H, paso);
+                validacion_fin_repeticion();
+            }
+            
+            // Validar nuevo valor
+            if (!es_numerico_valido(y_nuevo)) {
+                printf(" ADVERTENCIA: Valor invalido en paso %d, ajustando...\n", paso);
             
-            // Intentar con paso mas pequeño
-            double y_half1 = rk4_validado(x, y, PASO_H/2, paso);
-            double y_half2 = rk4_validado(x + PASO_H/2, y_half1, PASO_H/2, paso);
+                // Intentar con paso mas pequeño
+                double y_half1 = rk4_validado(x, y, PASO_H/2, paso);
+                double y_half2 = rk4_validado(x + PASO_H/2, y_half1, PASO_H/2, paso);
             
-            if (es_numerico_valido(y_half2)) {
-                y_nuevo = y_half2;
-                printf("   Solucionado con paso reducido a h/2\n");
-            } else {
-                printf(" ERROR: No se pudo recuperar con paso reducido\n");
+                if (es_numerico_valido(y_half2)) {
+                    y_nuevo = y_half2;
+                    printf("   Solucionado con paso reducido a h/2\n");
+                } else {
+                    printf(" ERROR: No se pudo recuperar con paso reducido\n");
+                    break;
+                }
+            }
+            
+            y = y_nuevo;
+            x += PASO_H;
+            paso++;
+            
+            // Verificar limite de pasos (prevencion de bucle infinito)
+            if (paso > pasos_totales * 10) {
+                printf(" ADVERTENCIA: Demasiados pasos (%d), posible bucle infinito\n", paso);
                 break;
             }
         }
-        
-        y = y_nuevo;
-        x += PASO_H;
-        paso++;
-        
-        // Verificar limite de pasos (prevencion de bucle infinito)
-        if (paso > pasos_totales * 10) {
-            printf(" ADVERTENCIA: Demasiados pasos (%d), posible bucle infinito\n", paso);
-            break;
-        }
     }
     
     printf("+------+--------+-----------+-----------+-----------+-----------+\n");
@@ -251,32 +569,40 @@ int main() {
            paso, errores_numericos);
     printf("+--------------------------------------------------------------+\n\n");
     
-    fclose(datos_sol);
-    fclose(datos_err);
+    salida_cerrar(datos_sol);
+    salida_cerrar(datos_err);
     
     // ============================================================================
-    // CREAR SCRIPT GNUPLOT
+    // CREAR SCRIPT GNUPLOT (con MOTOR_SVG el grafico se arma en memoria)
     // ============================================================================
-    fprintf(script_gp, "# Script para Runge-Kutta 4\n");
-    fprintf(script_gp, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
-            ANCHO_GRAFICO, ALTO_GRAFICO);
-    fprintf(script_gp, "set output '%s'\n", NOMBRE_GRAFICO);
-    fprintf(script_gp, "set title 'Metodo de Runge-Kutta 4: y' = x - y'\n");
-    fprintf(script_gp, "set xlabel 'x'\n");
-    fprintf(script_gp, "set ylabel 'y(x)'\n");
-    fprintf(script_gp, "set grid\n");
-    fprintf(script_gp, "set key top left box\n");
-    fprintf(script_gp, "set xrange [%f:%f]\n", X_INICIAL, X_FINAL);
-    
-    fprintf(script_gp, "plot 'rk4_solucion.dat' w lp pt 7 ps 0.5 lc rgb '#0066CC' title 'Solucion RK4', \\\n");
-    fprintf(script_gp, "     x - 1 + 2*exp(-x) w l lw 2 lc rgb '#FF3333' title 'Solucion exacta', \\\n");
-    fprintf(script_gp, "     'rk4_error.dat' u 1:2 w l lw 1 lc rgb '#00AA00' axes x1y2 title 'Error'\n");
-    
-    fprintf(script_gp, "\n# Configurar segundo eje Y para error\n");
-    fprintf(script_gp, "set y2tics\n");
-    fprintf(script_gp, "set y2label 'Error absoluto'\n");
-    
-    fclose(script_gp);
+    if (motor_grafico == MOTOR_GNUPLOT) {
+        fprintf(script_gp, "# Script para Runge-Kutta 4\n");
+        fprintf(script_gp, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
+                ANCHO_GRAFICO, ALTO_GRAFICO);
+        fprintf(script_gp, "set output '%s'\n", NOMBRE_GRAFICO);
+        fprintf(script_gp, "set title \"Metodo de Runge-Kutta 4: y' = %s\"\n", texto_edo());
+        fprintf(script_gp, "set xlabel 'x'\n");
+        fprintf(script_gp, "set ylabel 'y(x)'\n");
+        fprintf(script_gp, "set grid\n");
+        fprintf(script_gp, "set key top left box\n");
+        fprintf(script_gp, "set xrange [%f:%f]\n", X_INICIAL, X_FINAL);
+        
+        fprintf(script_gp, "plot %s w lp pt 7 ps 0.5 lc rgb '#0066CC' title 'Solucion RK4', \\\n",
+                fuente_gnuplot("rk4_solucion.dat", FORMATO_SALIDA));
+        // La sintaxis de expresion.h no es la de gnuplot: una solucion exacta de
+        // tiempo de ejecucion no se dibuja como curva (su error si se grafica)
+        if (!expr_exacta.activa) {
+            fprintf(script_gp, "     x - 1 + 2*exp(-x) w l lw 2 lc rgb '#FF3333' title 'Solucion exacta', \\\n");
+        }
+        fprintf(script_gp, "     %s u 1:2 w l lw 1 lc rgb '#00AA00' axes x1y2 title 'Error'\n",
+                fuente_gnuplot("rk4_error.dat", FORMATO_SALIDA));
+        
+        fprintf(script_gp, "\n# Configurar segundo eje Y para error\n");
+        fprintf(script_gp, "set y2tics\n");
+        fprintf(script_gp, "set y2label 'Error absoluto'\n");
+        
+        fclose(script_gp);
+    }
     
     // ============================================================================
     // EJECUTAR GNUPLOT
@@ -284,13 +610,19 @@ int main() {
     printf(" GENERANDO GRAFICO...\n");
     printf("-------------------------------------------------------------\n");
     
-    int resultado_gnuplot = system("gnuplot rk4_plot.gp 2>&1");
+    int resultado_gnuplot = (motor_grafico == MOTOR_SVG) ? graficar_svg()
+                                                         : system("gnuplot rk4_plot.gp 2>&1");
     
     if (resultado_gnuplot != 0) {
-        printf(" ADVERTENCIA: Gnuplot reporto problemas\n");
-        printf("   Comando: gnuplot rk4_plot.gp\n");
+        if (motor_grafico == MOTOR_GNUPLOT) {
+            printf(" ADVERTENCIA: Gnuplot reporto problemas\n");
+            printf("   Comando: gnuplot rk4_plot.gp\n");
+        } else {
+            printf(" ADVERTENCIA: No se pudo escribir el grafico SVG\n");
+        }
     } else {
-        printf(" Grafico generado: %s\n", NOMBRE_GRAFICO);
+        printf(" Grafico generado: %s\n",
+               (motor_grafico == MOTOR_SVG) ? grafico_nombre_svg(NOMBRE_GRAFICO) : NOMBRE_GRAFICO);
     }
     
     // ============================================================================
@@ -299,33 +631,19 @@ int main() {
     printf("\n ANALISIS DE RESULTADOS:\n");
     printf("-------------------------------------------------------------\n");
     
-    // Calcular estadisticas de error
-    FILE *err_file = fopen("rk4_error.dat", "r");
-    double error_promedio = 0.0;
-    double error_final = 0.0;
-    int puntos_leidos = 0;
-    double x_val, err_val;
-    
-    if (err_file) {
-        while (fscanf(err_file, "%lf %lf", &x_val, &err_val) == 2) {
-            error_promedio += err_val;
-            if (x_val == X_FINAL || puntos_leidos == paso - 1) {
-                error_final = err_val;
-            }
-            puntos_leidos++;
-        }
-        fclose(err_file);
-        
-        if (puntos_leidos > 0) {
-            error_promedio /= puntos_leidos;
-        }
-    }
+    // Estadisticas acumuladas durante la integracion (sin releer rk4_error.dat)
+    double error_maximo = estad_maximo(&errores);
     
     printf("  Pasos completados:   %d de %d estimados\n", paso, pasos_totales);
-    printf("  Error maximo:        %.6f\n", error_maximo);
-    printf("  Error promedio:      %.6f\n", error_promedio);
-    printf("  Error final:         %.6f\n", error_final);
+    printf("  Error maximo:        %.2e\n", error_maximo);
+    printf("  Error promedio:      %.2e\n", estad_media(&errores));
+    printf("  Error RMS:           %.2e\n", estad_rms(&errores));
+    printf("  Error final:         %.2e\n", estad_ultimo(&errores));
     printf("  Errores numericos:   %d\n", errores_numericos);
+    printf("  Evaluaciones f(x,y): %ld\n", evaluaciones_edo);
+    if (MODO_INTEGRADOR == INTEGRADOR_DOPRI5) {
+        printf("  Pasos rechazados:    %d\n", rechazos);
+    }
     
     // Evaluar precision
     printf("\n  EVALUACION DE PRECISION:\n");
@@ -346,19 +664,24 @@ int main() {
     printf("-------------------------------------------------------------\n");
     
     // Calcular derivada numerica final
-    double derivada_final = EDO_FUNCION(X_FINAL, y);
-    double derivada_teorica = X_FINAL - y;
-    double discrepancia = fabs(derivada_final - derivada_teorica);
+    double derivada_final = EVAL_EDO(X_FINAL, y);
     
     printf("  En x = %.2f:\n", X_FINAL);
     printf("    y calculado:     %.6f\n", y);
-    printf("    y exacto:        %.6f\n", SOLUCION_EXACTA(X_FINAL));
+    printf("    y exacto:        %.6f\n", EVAL_EXACTA(X_FINAL));
     printf("    y' calculado:    %.6f\n", derivada_final);
-    printf("    y' teorico:      %.6f\n", derivada_teorica);
-    printf("    Discrepancia:    %.2e\n", discrepancia);
     
-    if (discrepancia > 0.01) {
-        printf("  ADVERTENCIA: Discrepancia significativa en derivada\n");
+    // y' = x - y solo es la derivada teorica para la ecuacion de las macros
+    if (!expr_edo.activa) {
+        double derivada_teorica = X_FINAL - y;
+        double discrepancia = fabs(derivada_final - derivada_teorica);
+        
+        printf("    y' teorico:      %.6f\n", derivada_teorica);
+        printf("    Discrepancia:    %.2e\n", discrepancia);
+        
+        if (discrepancia > 0.01) {
+            printf("  ADVERTENCIA: Discrepancia significativa en derivada\n");
+        }
     }
     
     // ============================================================================
@@ -372,7 +695,9 @@ int main() {
     printf("  Error maximo:        %.2e\n", error_maximo);
     printf("  Grafico generado:    %s\n", 
            (resultado_gnuplot == 0) ? "SI" : "NO");
-    printf("  Archivos creados:    rk4_solucion.dat, rk4_error.dat, rk4_plot.gp\n");
+    printf("  Archivos creados:    %s, %s, %s\n",
+           nombre_salida("rk4_solucion.dat", FORMATO_SALIDA), nombre_salida("rk4_error.dat", FORMATO_SALIDA),
+           (motor_grafico == MOTOR_SVG) ? grafico_nombre_svg(NOMBRE_GRAFICO) : "rk4_plot.gp");
     
     printf("\n EJECUCION COMPLETADA\n");
     
@@ -1,10 +1,18 @@
 // 6_ecuacion2.c
-// EDO y'' + y = 0 con Runge-Kutta 4 y validaciones robustas
+// EDO y'' + y = 0 con Runge-Kutta 4 o integradores simplecticos, y validaciones robustas
 
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
 #include <errno.h>
+#include "nucleo.h"
+#include "datos_columnar.h"
+#include "expresion.h"
+#include "benchmark.h"
+#include "estadistica.h"
+#include "grafico.h"
+#include "barrido.h"
+#include "convergencia.h"
 
 // ============================================================================
 // PARAMETROS CONFIGURABLES
@@ -16,33 +24,49 @@
 #define Y_INICIAL           0.0
 #define YP_INICIAL          1.0
 #define PASO_H              0.05
-#define NOMBRE_GRAFICO      "ypp_grafico.png"
+#define INTEGRADOR          INTEGRADOR_RK4   // INTEGRADOR_RK4, _VERLET, _YOSHIDA4 o _YOSHIDA6
+#define MODO_DERIVA         0          // 1 = compara la deriva de energia de todos los integradores
+#define DERIVA_PERIODOS     1000       // Horizonte de la comparacion, en periodos 2*pi
+#define FORMATO_SALIDA      FORMATO_TEXTO    // FORMATO_TEXTO o FORMATO_BINARIO
+#define NIVEL_VALIDACION    VALIDACION_OPERACION  // _OPERACION, _PASO o _NINGUNA (o entorno VALIDACION)
+#define MOTOR_GRAFICO       MOTOR_GNUPLOT    // MOTOR_GNUPLOT o MOTOR_SVG (o entorno GRAFICO)
+#define NOMBRE_GRAFICO      "ypp_grafico.png" // Con MOTOR_SVG: ypp_grafico.svg
 #define ANCHO_GRAFICO       800
 #define ALTO_GRAFICO        1000
 // ============================================================================
 
+// Integradores. Los simplecticos (composiciones de Stormer-Verlet) suponen
+// y'' = F(x, y) sin dependencia de y': para un hamiltoniano separable el
+// error de energia queda acotado en vez de crecer con el numero de pasos.
+#define INTEGRADOR_RK4      0
+#define INTEGRADOR_VERLET   1          // Orden 2, 1 evaluacion por paso
+#define INTEGRADOR_YOSHIDA4 2          // Orden 4, 3 subpasos de Verlet
+#define INTEGRADOR_YOSHIDA6 3          // Orden 6, 7 subpasos de Verlet (solucion A de Yoshida)
+#define N_INTEGRADORES      4
+#define DERIVA_MUESTRAS     500        // Puntos por integrador en energia_deriva.dat
+
+// Funciones definidas en tiempo de ejecucion: las variables de entorno
+// EDO_FUNCION (y'' en funcion de x, y, yp) y SOLUCION_EXACTA reemplazan a las
+// macros, p. ej.  EDO_FUNCION="-y" SOLUCION_EXACTA="sin(x)" ./ecuacion2
+Expresion expr_edo, expr_exacta;
+
+#define EVAL_EDO(x,y,yp)    (expr_edo.activa ? expr_evaluar_3(&expr_edo, (x), (y), (yp)) : EDO_FUNCION(x,y,yp))
+#define EVAL_EXACTA(x)      (expr_exacta.activa ? expr_evaluar_1(&expr_exacta, (x)) : SOLUCION_EXACTA(x))
+
 // ============================================================================
 // FUNCIONES DE VALIDACION
 // ============================================================================
-int es_numerico_valido(double valor) {
-    return !(isnan(valor) || isinf(valor) || fabs(valor) > 1e100);
-}
-
-void verificar_nan_inf(const char *nombre, double valor, int linea) {
-    if (isnan(valor)) {
-        printf(" ERROR [Linea %d]: %s = NaN\n", linea, nombre);
-        printf("   Posible causa: Division por cero o operacion invalida\n");
-        exit(EXIT_FAILURE);
-    }
-    if (isinf(valor)) {
-        printf(" ERROR [Linea %d]: %s = Infinito\n", linea, nombre);
-        printf("   Posible causa: Overflow numerico\n");
+void cargar_expresiones() {
+    expr_desde_entorno(&expr_edo, "EDO_FUNCION", "x y yp");
+    expr_desde_entorno(&expr_exacta, "SOLUCION_EXACTA", "x");
+    
+    // El estudio de convergencia no necesita la solucion exacta
+    if (expr_edo.activa != expr_exacta.activa && !(expr_edo.activa && convergencia_solicitada(NULL))) {
+        printf(" ERROR: EDO_FUNCION y SOLUCION_EXACTA deben definirse juntas en el entorno\n");
         exit(EXIT_FAILURE);
     }
 }
 
-#define VALIDAR(variable) verificar_nan_inf(#variable, variable, __LINE__)
-
 void validar_parametros() {
     if (PASO_H <= 0) {
         printf(" ERROR: PASO_H debe ser positivo (h = %f)\n", PASO_H);
@@ -67,62 +91,25 @@ void validar_parametros() {
     }
 }
 
-FILE* abrir_archivo(const char *nombre, const char *modo) {
-    FILE *archivo = fopen(nombre, modo);
-    if (archivo == NULL) {
-        printf(" ERROR: No se pudo abrir '%s'\n", nombre);
-        printf("   Error del sistema: %d\n", errno);
-        exit(EXIT_FAILURE);
-    }
-    return archivo;
-}
-
 // ============================================================================
 // RUNGE-KUTTA 4 PARA SISTEMAS CON VALIDACION
 // ============================================================================
+// Estado (y, y'): la EDO de segundo orden como sistema de primer orden
+void derivada_edo(double x, const double *estado, double *d) {
+    d[0] = estado[1];
+    d[1] = EVAL_EDO(x, estado[0], estado[1]);
+}
+
+const ProblemaEDO problema_edo = { 2, derivada_edo };
+
 void rk4_sistema_validado(double x, double *y, double *yp, double h, int paso_actual) {
-    double k1_y, k1_yp, k2_y, k2_yp, k3_y, k3_yp, k4_y, k4_yp;
-    
-    // k1
-    k1_y = *yp;
-    k1_yp = EDO_FUNCION(x, *y, *yp);
-    VALIDAR(k1_y); VALIDAR(k1_yp);
-    
-    // k2
-    double x2 = x + h/2;
-    double y2 = *y + h*k1_y/2;
-    double yp2 = *yp + h*k1_yp/2;
-    VALIDAR(x2); VALIDAR(y2); VALIDAR(yp2);
-    
-    k2_y = yp2;
-    k2_yp = EDO_FUNCION(x2, y2, yp2);
-    VALIDAR(k2_y); VALIDAR(k2_yp);
+    double estado[2] = { *y, *yp };
     
-    // k3
-    double x3 = x + h/2;
-    double y3 = *y + h*k2_y/2;
-    double yp3 = *yp + h*k2_yp/2;
-    VALIDAR(x3); VALIDAR(y3); VALIDAR(yp3);
+    // Etapas k1..k4 validadas en rk4_paso_edo (nucleo.h)
+    rk4_paso_edo(&problema_edo, x, estado, h);
     
-    k3_y = yp3;
-    k3_yp = EDO_FUNCION(x3, y3, yp3);
-    VALIDAR(k3_y); VALIDAR(k3_yp);
-    
-    // k4
-    double x4 = x + h;
-    double y4 = *y + h*k3_y;
-    double yp4 = *yp + h*k3_yp;
-    VALIDAR(x4); VALIDAR(y4); VALIDAR(yp4);
-    
-    k4_y = yp4;
-    k4_yp = EDO_FUNCION(x4, y4, yp4);
-    VALIDAR(k4_y); VALIDAR(k4_yp);
-    
-    // Actualizar valores
-    double y_nuevo = *y + h*(k1_y + 2*k2_y + 2*k3_y + k4_y)/6;
-    double yp_nuevo = *yp + h*(k1_yp + 2*k2_yp + 2*k3_yp + k4_yp)/6;
-    
-    VALIDAR(y_nuevo); VALIDAR(yp_nuevo);
+    double y_nuevo = estado[0];
+    double yp_nuevo = estado[1];
     
     // Verificar conservacion de energia (E = y² + y'²)
     double energia_antes = (*y)*(*y) + (*yp)*(*yp);
@@ -144,6 +131,352 @@ void rk4_sistema_validado(double x, double *y, double *yp, double h, int paso_ac
     *yp = yp_nuevo;
 }
 
+// ============================================================================
+// INTEGRADORES SIMPLECTICOS
+// ============================================================================
+// Un subpaso de Verlet (patada-deriva-patada) de tamano w*h:
+//   yp += (w h / 2) a;  y += w h yp;  a = F(x + w h, y);  yp += (w h / 2) a
+// La aceleracion final es la inicial del subpaso siguiente, asi que cada
+// subpaso cuesta una sola evaluacion. Yoshida compone subpasos simetricos
+// con pesos que cancelan los terminos de error hasta orden 4 o 6.
+// ============================================================================
+const double YOSHIDA4_PESOS[3] = {
+    1.3512071919596578, -1.7024143839193153, 1.3512071919596578
+};
+const double YOSHIDA6_PESOS[7] = {
+    0.78451361047755726, 0.23557321335935813, -1.1776799841788701, 1.3151863206839112,
+    -1.1776799841788701, 0.23557321335935813, 0.78451361047755726
+};
+
+const char* nombre_integrador(int integrador) {
+    switch (integrador) {
+        case INTEGRADOR_VERLET:   return "Verlet";
+        case INTEGRADOR_YOSHIDA4: return "Yoshida4";
+        case INTEGRADOR_YOSHIDA6: return "Yoshida6";
+        default:                  return "RK4";
+    }
+}
+
+// Evaluaciones de EDO_FUNCION por paso
+int evaluaciones_por_paso(int integrador) {
+    switch (integrador) {
+        case INTEGRADOR_VERLET:   return 1;
+        case INTEGRADOR_YOSHIDA4: return 3;
+        case INTEGRADOR_YOSHIDA6: return 7;
+        default:                  return 4;
+    }
+}
+
+// *a entra con F(x, y, yp) y sale con la aceleracion en x + h
+void paso_simplectico(int integrador, double x, double *y, double *yp, double *a, double h) {
+    const double *pesos = YOSHIDA4_PESOS;
+    int n_pesos = 3;
+    static const double VERLET_PESO[1] = {1.0};
+    
+    if (integrador == INTEGRADOR_VERLET) {
+        pesos = VERLET_PESO;
+        n_pesos = 1;
+    } else if (integrador == INTEGRADOR_YOSHIDA6) {
+        pesos = YOSHIDA6_PESOS;
+        n_pesos = 7;
+    }
+    
+    for (int k = 0; k < n_pesos; k++) {
+        double hk = pesos[k] * h;
+        *yp += 0.5 * hk * (*a);
+        *y += hk * (*yp);
+        x += hk;
+        *a = EVAL_EDO(x, *y, *yp);
+        *yp += 0.5 * hk * (*a);
+    }
+    VALIDAR(*y); VALIDAR(*yp); VALIDAR(*a);
+}
+
+// Avanza un paso con el integrador elegido. *a solo lo usan los simplecticos
+void avanzar_paso(int integrador, double x, double *y, double *yp, double *a, double h, int paso_actual) {
+    if (integrador == INTEGRADOR_RK4) {
+        rk4_sistema_validado(x, y, yp, h, paso_actual);
+    } else {
+        paso_simplectico(integrador, x, y, yp, a, h);
+    }
+}
+
+// 1 si la EDO del entorno lee yp (registro 2): los simplecticos no aplican
+int edo_depende_de_yp() {
+    if (!expr_edo.activa) return 0;
+    if (expr_edo.resultado == 2) return 1;
+    for (int i = 0; i < expr_edo.n_instr; i++) {
+        const InstrExpr *in = &expr_edo.codigo[i];
+        if (in->a == 2 || (expr_es_binaria(in->op) && in->b == 2)) return 1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// COMPARACION DE DERIVA DE ENERGIA (MODO_DERIVA)
+// ============================================================================
+// Cada integrador recorre DERIVA_PERIODOS periodos dos veces: con PASO_H y
+// con el paso que iguala el costo de RK4 (mismas evaluaciones por unidad de
+// x). Un error de energia acotado da max|dE| similar en ambas mitades del
+// recorrido; una deriva secular lo hace crecer en la segunda.
+// ============================================================================
+typedef struct {
+    double h, deriva_final, deriva_max, max_primera, max_segunda, error_max, segundos;
+    long pasos, evaluaciones;
+} ResultadoDeriva;
+
+ResultadoDeriva medir_deriva(int integrador, double h, SalidaDatos *serie) {
+    ResultadoDeriva r = {h, 0, 0, 0, 0, 0, 0, 0, 0};
+    double x_final = X_INICIAL + DERIVA_PERIODOS * 2 * M_PI;
+    double y = Y_INICIAL, yp = YP_INICIAL;
+    double e0 = y*y + yp*yp;
+    double a = EVAL_EDO(X_INICIAL, y, yp);
+    
+    r.pasos = (long)((x_final - X_INICIAL) / h + 0.5);
+    long cada = (r.pasos > DERIVA_MUESTRAS) ? r.pasos / DERIVA_MUESTRAS : 1;
+    double inicio = bench_tiempo();
+    
+    for (long i = 0; i < r.pasos; i++) {
+        double x = X_INICIAL + i * h;
+        avanzar_paso(integrador, x, &y, &yp, &a, h, 0);
+        
+        // Con estado inicial nulo dE/E0 no esta definida: se reporta 0
+        double deriva = 0.0;
+        if (e0 > 0) {
+            deriva = (y*y + yp*yp - e0) / e0;
+        }
+        double error = fabs(y - EVAL_EXACTA(x + h));
+        if (fabs(deriva) > r.deriva_max) r.deriva_max = fabs(deriva);
+        if (error > r.error_max) r.error_max = error;
+        if (2 * i < r.pasos) {
+            if (fabs(deriva) > r.max_primera) r.max_primera = fabs(deriva);
+        } else if (fabs(deriva) > r.max_segunda) {
+            r.max_segunda = fabs(deriva);
+        }
+        if (serie != NULL && (i + 1) % cada == 0) {
+            SALIDA_FILA(serie, integrador, x + h, deriva);
+        }
+        r.deriva_final = deriva;
+    }
+    
+    r.segundos = bench_tiempo() - inicio;
+    r.evaluaciones = r.pasos * evaluaciones_por_paso(integrador)
+                     + (integrador != INTEGRADOR_RK4);
+    return r;
+}
+
+int ejecutar_comparacion_deriva() {
+    printf(" Parametros validos\n\n");
+    printf(" DERIVA DE ENERGIA: %d periodos (x en [%.1f, %.1f])\n\n",
+           DERIVA_PERIODOS, X_INICIAL, X_INICIAL + DERIVA_PERIODOS * 2 * M_PI);
+    
+    if (edo_depende_de_yp()) {
+        printf(" ADVERTENCIA: EDO_FUNCION depende de yp; los integradores simplecticos\n");
+        printf("   suponen y'' = F(x, y) y su energia no tiene por que quedar acotada\n\n");
+    }
+    
+    SalidaDatos *serie = salida_abrir("energia_deriva.dat", FORMATO_SALIDA, "integrador x dE_rel",
+                                      "%.0f %.6f %.6e\n");
+    
+    for (int bloque = 0; bloque < 2; bloque++) {
+        printf("%s\n", bloque == 0 ? "MISMO PASO (h = PASO_H):"
+                                    : "MISMO COSTO QUE RK4 (h = PASO_H * evaluaciones por paso / 4):");
+        printf("+----------+--------+---------+---------+-----------+-----------+-----------+-----------+--------+\n");
+        printf("|Integrador|   h    |  Pasos  |  Evals  | dE/E final| max|dE/E| | 2a/1a mit.| Error max | ms     |\n");
+        printf("+----------+--------+---------+---------+-----------+-----------+-----------+-----------+--------+\n");
+        
+        for (int i = 0; i < N_INTEGRADORES; i++) {
+            double h = (bloque == 0) ? PASO_H : PASO_H * evaluaciones_por_paso(i) / 4.0;
+            ResultadoDeriva r = medir_deriva(i, h, (bloque == 1) ? serie : NULL);
+            double cociente = (r.max_primera > 0) ? r.max_segunda / r.max_primera : 0.0;
+            
+            printf("| %-8s | %6.4f | %7ld | %7ld | %9.2e | %9.2e | %9.2f | %9.2e | %6.1f |\n",
+                   nombre_integrador(i), r.h, r.pasos, r.evaluaciones, r.deriva_final,
+                   r.deriva_max, cociente, r.error_max, r.segundos * 1e3);
+        }
+        printf("+----------+--------+---------+---------+-----------+-----------+-----------+-----------+--------+\n\n");
+    }
+    salida_cerrar(serie);
+    
+    printf("  2a/1a mit.: max|dE/E| en la segunda mitad sobre la primera\n");
+    printf("              (~1 = error acotado, ~2 o mas = deriva secular)\n");
+    printf("  - %s -> dE/E a lo largo del recorrido (mismo costo)\n",
+           nombre_salida("energia_deriva.dat", FORMATO_SALIDA));
+    
+    return EXIT_SUCCESS;
+}
+
+// ============================================================================
+// BARRIDO DE PARAMETROS (BARRIDO=... ./ecuacion2, ver barrido.h)
+// ============================================================================
+// Cada conjunto (PASO_H, X_FINAL, Y_INICIAL, YP_INICIAL) se integra con el
+// INTEGRADOR configurado sin escribir archivos. Con las condiciones iniciales
+// de las macros el error de y se mide contra SOLUCION_EXACTA; con otras,
+// contra el mismo integrador con paso h/BARRIDO_REFINAMIENTO.
+#define PARAMETROS_BARRIDO  "PASO_H X_FINAL Y_INICIAL YP_INICIAL"
+
+// Paso sin avisos ni VALIDAR: estado = (y, y'), *a solo para los simplecticos
+void paso_barrido(double x, double *estado, double *a, double h) {
+    if (INTEGRADOR == INTEGRADOR_RK4) {
+        rk4_paso_edo(&problema_edo, x, estado, h);
+    } else {
+        paso_simplectico(INTEGRADOR, x, &estado[0], &estado[1], a, h);
+    }
+}
+
+void trabajo_barrido(const double *p, int fase, ResultadoBarrido *r) {
+    double h = p[0], x_final = p[1];
+    double estado[2] = { p[2], p[3] }, estado_ref[2] = { p[2], p[3] };
+    long pasos = barrido_pasos(X_INICIAL, x_final, h);
+    
+    if (pasos == 0) {
+        r->estado = BARRIDO_RECHAZADO;
+        return;
+    }
+    r->con_exacta = (p[2] == Y_INICIAL && p[3] == YP_INICIAL);
+    double a = EVAL_EDO(X_INICIAL, estado[0], estado[1]);
+    double a_ref = a;
+    
+    for (long i = 0; i < pasos; i++) {
+        double x = X_INICIAL + i*h;
+        double h_paso = (i == pasos - 1) ? x_final - x : h;
+        
+        paso_barrido(x, estado, &a, h_paso);
+        if (fase == BARRIDO_FASE_METODO) r->pasos++;
+        if (!es_numerico_valido(estado[0]) || !es_numerico_valido(estado[1])) {
+            r->estado = BARRIDO_INVALIDO;
+            break;
+        }
+        if (fase == BARRIDO_FASE_METODO) continue;
+        
+        double referencia;
+        if (r->con_exacta) {
+            referencia = EVAL_EXACTA(x + h_paso);
+        } else {
+            for (int k = 0; k < BARRIDO_REFINAMIENTO; k++) {
+                paso_barrido(x + k*h_paso/BARRIDO_REFINAMIENTO, estado_ref, &a_ref,
+                             h_paso/BARRIDO_REFINAMIENTO);
+            }
+            referencia = estado_ref[0];
+        }
+        barrido_error(r, fabs(estado[0] - referencia));
+    }
+    r->evaluaciones = r->pasos * evaluaciones_por_paso(INTEGRADOR) + (INTEGRADOR != INTEGRADOR_RK4);
+}
+
+int ejecutar_barrido() {
+    const double por_defecto[] = { PASO_H, X_FINAL, Y_INICIAL, YP_INICIAL };
+    
+    printf(" Ecuacion: y'' = %s (%s)\n\n", expr_edo.activa ? expr_edo.texto : "-y",
+           nombre_integrador(INTEGRADOR));
+    return barrido_correr("ecuacion2", PARAMETROS_BARRIDO, por_defecto, trabajo_barrido);
+}
+
+// ============================================================================
+// ESTUDIO DE CONVERGENCIA (CONVERGENCIA=tol ./ecuacion2, ver convergencia.h)
+// ============================================================================
+// Siempre con RK4 sobre el estado (y, y'); el error se mide sobre y, como en
+// la integracion normal
+void exacta_convergencia(double x, double *estado) {
+    estado[0] = EVAL_EXACTA(x);
+    estado[1] = NAN;        // y' exacta no se conoce (no entra en el error)
+}
+
+int ejecutar_convergencia(double tolerancia) {
+    const double y_inicial[2] = { Y_INICIAL, YP_INICIAL };
+    int con_exacta = !expr_edo.activa || expr_exacta.activa;
+    EstudioConvergencia estudio = { &problema_edo, X_INICIAL, X_FINAL, PASO_H, y_inicial, 1, "y yp",
+                                    con_exacta ? exacta_convergencia : NULL, FORMATO_SALIDA };
+    
+    printf(" Ecuacion: y'' = %s\n", expr_edo.activa ? expr_edo.texto : "-y");
+    if (INTEGRADOR != INTEGRADOR_RK4) {
+        printf(" El estudio usa RK4 (INTEGRADOR = %s se ignora)\n", nombre_integrador(INTEGRADOR));
+    }
+    printf("\n");
+    return convergencia_ejecutar(&estudio, tolerancia);
+}
+
+// ============================================================================
+// MICRO-BENCHMARKS (BENCHMARK=1 ./ecuacion2)
+// ============================================================================
+// Una llamada = un paso; la trayectoria reinicia al llegar a X_FINAL.
+ConteoBench bench_rk4_sistema(void *contexto, long llamadas) {
+    (void)contexto;
+    double x = X_INICIAL, y = Y_INICIAL, yp = YP_INICIAL;
+    
+    for (long i = 0; i < llamadas; i++) {
+        if (x > X_FINAL) { x = X_INICIAL; y = Y_INICIAL; yp = YP_INICIAL; }
+        rk4_sistema_validado(x, &y, &yp, PASO_H, 0);
+        x += PASO_H;
+    }
+    bench_sumidero += y + yp;
+    return (ConteoBench){ llamadas, 4.0 * llamadas };
+}
+
+ConteoBench bench_simplectico(void *contexto, long llamadas) {
+    int integrador = *(const int*)contexto;
+    double x = X_INICIAL, y = Y_INICIAL, yp = YP_INICIAL;
+    double a = EVAL_EDO(x, y, yp);
+    
+    for (long i = 0; i < llamadas; i++) {
+        if (x > X_FINAL) { x = X_INICIAL; y = Y_INICIAL; yp = YP_INICIAL; a = EVAL_EDO(x, y, yp); }
+        paso_simplectico(integrador, x, &y, &yp, &a, PASO_H);
+        x += PASO_H;
+    }
+    bench_sumidero += y + yp;
+    return (ConteoBench){ llamadas, (double)evaluaciones_por_paso(integrador) * llamadas };
+}
+
+int ejecutar_benchmark() {
+    bench_encabezado("ecuacion2");
+    bench_medir("ecuacion2", "rk4_sistema_validado", "paso", bench_rk4_sistema, NULL);
+    for (int i = INTEGRADOR_VERLET; i < N_INTEGRADORES; i++) {
+        char nombre[64];
+        snprintf(nombre, sizeof nombre, "paso_simplectico(%s)", nombre_integrador(i));
+        bench_medir("ecuacion2", nombre, "paso", bench_simplectico, &i);
+    }
+    bench_pie();
+    return EXIT_SUCCESS;
+}
+
+// ============================================================================
+// GRAFICO EN MEMORIA (MOTOR_SVG)
+// ============================================================================
+// Los dos paneles de ypp_plot.gp: solucion y(x) y plano de fase
+#define SERIE_NUMERICA      0
+#define SERIE_EXACTA        1
+
+PanelGrafico graficos[2];
+
+void preparar_grafico() {
+    char titulo[GRAFICO_LARGO_TEXTO];
+    snprintf(titulo, sizeof(titulo), "Solucion %s", nombre_integrador(INTEGRADOR));
+    
+    grafico_iniciar(&graficos[0], "Solucion: y'' + y = 0", "x", "y(x)");
+    grafico_serie(&graficos[0], titulo, "#0066CC", TRAZO_LINEA, 2.0);
+    grafico_serie(&graficos[0], "y(x) exacta", "#FF3333", TRAZO_LINEA | TRAZO_DISCONTINUO, 2.0);
+    
+    grafico_iniciar(&graficos[1], "Plano de fase: y vs y'", "y(x)", "y'(x)");
+    graficos[1].leyenda = LEYENDA_NINGUNA;
+    graficos[1].proporcion_igual = 1;
+    grafico_serie(&graficos[1], "Trayectoria", "#00AA00", TRAZO_LINEA, 1.5);
+}
+
+// La solucion exacta se evalua aqui, asi que tambien se dibuja cuando viene
+// del entorno (gnuplot no entiende la sintaxis de expresion.h)
+int graficar_svg(double x_final) {
+    for (int i = 0; i <= GRAFICO_MUESTRAS; i++) {
+        double x = X_INICIAL + (x_final - X_INICIAL) * i / GRAFICO_MUESTRAS;
+        grafico_punto(&graficos[0], SERIE_EXACTA, x, EVAL_EXACTA(x));
+    }
+    
+    int resultado = grafico_escribir_svg(grafico_nombre_svg(NOMBRE_GRAFICO), ANCHO_GRAFICO, ALTO_GRAFICO,
+                                         graficos, 2);
+    grafico_liberar(&graficos[0]);
+    grafico_liberar(&graficos[1]);
+    return resultado;
+}
+
 // ============================================================================
 // PROGRAMA PRINCIPAL
 // ============================================================================
@@ -154,8 +487,28 @@ int main() {
     printf(" VALIDANDO PARAMETROS...\n");
     printf("-------------------------------------------------------------\n");
     
+    validacion_iniciar(NIVEL_VALIDACION);
+    grafico_iniciar_motor(MOTOR_GRAFICO);
+    cargar_expresiones();
     validar_parametros();
     
+    if (bench_solicitado()) {
+        return ejecutar_benchmark();
+    }
+    
+    if (barrido_solicitado()) {
+        return ejecutar_barrido();
+    }
+    
+    double tolerancia;
+    if (convergencia_solicitada(&tolerancia)) {
+        return ejecutar_convergencia(tolerancia);
+    }
+    
+    if (MODO_DERIVA) {
+        return ejecutar_comparacion_deriva();
+    }
+    
     double x = X_INICIAL;
     double y = Y_INICIAL;
     double yp = YP_INICIAL;
@@ -163,7 +516,11 @@ int main() {
     int pasos_totales = (int)((X_FINAL - X_INICIAL) / PASO_H) + 1;
     
     printf(" Parametros validos\n");
-    printf("   Ecuacion: y'' + y = 0\n");
+    if (expr_edo.activa) {
+        printf("   Ecuacion: y'' = %s\n", expr_edo.texto);
+    } else {
+        printf("   Ecuacion: y'' + y = 0\n");
+    }
     printf("   Condiciones: y(0) = %.1f, y'(0) = %.1f\n", Y_INICIAL, YP_INICIAL);
     printf("   Intervalo: [%.1f, %.1f]\n", X_INICIAL, X_FINAL);
     printf("   Paso: h = %.3f\n", PASO_H);
@@ -172,12 +529,22 @@ int main() {
     // ============================================================================
     // CONFIGURACION
     // ============================================================================
-    printf(" ECUACION DIFERENCIAL: y'' + y = 0 (RK4) \n\n");
+    printf(" ECUACION DIFERENCIAL: y'' + y = 0 (%s) \n\n", nombre_integrador(INTEGRADOR));
     
-    FILE *datos_sol = abrir_archivo("ypp_solucion.dat", "w");
-    FILE *datos_der = abrir_archivo("ypp_derivada.dat", "w");
-    FILE *datos_fase = abrir_archivo("ypp_fase.dat", "w");
-    FILE *script_gp = abrir_archivo("ypp_plot.gp", "w");
+    if (INTEGRADOR != INTEGRADOR_RK4 && edo_depende_de_yp()) {
+        printf(" ADVERTENCIA: EDO_FUNCION depende de yp; %s supone y'' = F(x, y)\n\n",
+               nombre_integrador(INTEGRADOR));
+    }
+    
+    SalidaDatos *datos_sol = salida_abrir("ypp_solucion.dat", FORMATO_SALIDA, "x y", "%.6f %.6f\n");
+    SalidaDatos *datos_der = salida_abrir("ypp_derivada.dat", FORMATO_SALIDA, "x yp", "%.6f %.6f\n");
+    SalidaDatos *datos_fase = salida_abrir("ypp_fase.dat", FORMATO_SALIDA, "y yp", "%.6f %.6f\n");
+    FILE *script_gp = NULL;
+    if (motor_grafico == MOTOR_SVG) {
+        preparar_grafico();
+    } else {
+        script_gp = abrir_archivo("ypp_plot.gp", "w");
+    }
     
     printf("PROCESO DE INTEGRACION:\n");
     printf("+------+--------+-----------+-----------+-----------+-----------+\n");
@@ -185,24 +552,24 @@ int main() {
     printf("+------+--------+-----------+-----------+-----------+-----------+\n");
     
     int errores_numericos = 0;
-    double error_maximo = 0.0;
+    EstadisticaOnline errores, energias;
+    estad_iniciar(&errores);
+    estad_iniciar(&energias);
     double energia_inicial = Y_INICIAL*Y_INICIAL + YP_INICIAL*YP_INICIAL;
+    double aceleracion = EVAL_EDO(x, y, yp);
+    long evaluaciones = (INTEGRADOR != INTEGRADOR_RK4);
     
     // ============================================================================
-    // INTEGRACION CON RUNGE-KUTTA 4
+    // INTEGRACION (RK4 O SIMPLECTICA)
     // ============================================================================
     while (x <= X_FINAL + PASO_H/2) {
         // Calcular solucion exacta y error
-        double exacta = SOLUCION_EXACTA(x);
+        double exacta = EVAL_EXACTA(x);
         VALIDAR(exacta);
         
         double error = fabs(y - exacta);
         VALIDAR(error);
         
-        if (error > error_maximo) {
-            error_maximo = error;
-        }
-        
         // Calcular energia actual
         double energia_actual = y*y + yp*yp;
         VALIDAR(energia_actual);
@@ -221,9 +588,9 @@ int main() {
             printf("\n ERROR CRITICO: Valores no numericos en paso %d\n", paso);
             printf("   x = %.6f, y = %.6f, y' = %.6f\n", x, y, yp);
             
-            fclose(datos_sol);
-            fclose(datos_der);
-            fclose(datos_fase);
+            salida_cerrar(datos_sol);
+            salida_cerrar(datos_der);
+            salida_cerrar(datos_fase);
             return EXIT_FAILURE;
         }
         
@@ -234,15 +601,29 @@ int main() {
         }
         
         // Guardar datos
-        fprintf(datos_sol, "%.6f %.6f\n", x, y);
-        fprintf(datos_der, "%.6f %.6f\n", x, yp);
-        fprintf(datos_fase, "%.6f %.6f\n", y, yp);
+        SALIDA_FILA(datos_sol, x, y);
+        SALIDA_FILA(datos_der, x, yp);
+        SALIDA_FILA(datos_fase, y, yp);
+        if (motor_grafico == MOTOR_SVG) {
+            grafico_punto(&graficos[0], SERIE_NUMERICA, x, y);
+            grafico_punto(&graficos[1], 0, y, yp);
+        }
+        estad_agregar(&errores, error);
+        estad_agregar(&energias, energia_actual);
         
         // Ultimo punto
         if (x >= X_FINAL) break;
         
-        // Calcular siguiente punto
-        rk4_sistema_validado(x, &y, &yp, PASO_H, paso);
+        // Calcular siguiente punto (en el nivel PASO, un lote por paso)
+        double y_lote = y, yp_lote = yp, aceleracion_lote = aceleracion;
+        validacion_abrir_lote();
+        avanzar_paso(INTEGRADOR, x, &y, &yp, &aceleracion, PASO_H, paso);
+        if (validacion_cerrar_lote("paso", paso)) {
+            y = y_lote; yp = yp_lote; aceleracion = aceleracion_lote;
+            avanzar_paso(INTEGRADOR, x, &y, &yp, &aceleracion, PASO_H, paso);
+            validacion_fin_repeticion();
+        }
+        evaluaciones += evaluaciones_por_paso(INTEGRADOR);
         
         x += PASO_H;
         paso++;
@@ -258,45 +639,54 @@ int main() {
     printf("| INTEGRACION COMPLETADA: %d pasos                            |\n", paso);
     printf("+--------------------------------------------------------------+\n\n");
     
-    fclose(datos_sol);
-    fclose(datos_der);
-    fclose(datos_fase);
+    salida_cerrar(datos_sol);
+    salida_cerrar(datos_der);
+    salida_cerrar(datos_fase);
     
     // ============================================================================
-    // CREAR SCRIPT GNUPLOT
+    // CREAR SCRIPT GNUPLOT (con MOTOR_SVG el grafico se arma en memoria)
     // ============================================================================
-    fprintf(script_gp, "# Script para ecuacion y'' + y = 0\n");
-    fprintf(script_gp, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
-            ANCHO_GRAFICO, ALTO_GRAFICO);
-    fprintf(script_gp, "set output '%s'\n", NOMBRE_GRAFICO);
-    
-    fprintf(script_gp, "\n# Configurar multiples graficos\n");
-    fprintf(script_gp, "set multiplot layout 2,1\n");
-    fprintf(script_gp, "set lmargin 10\n");
-    fprintf(script_gp, "set rmargin 5\n\n");
-    
-    // Grafico 1: Solucion
-    fprintf(script_gp, "# Grafico 1: Solucion y(x)\n");
-    fprintf(script_gp, "set title 'Solucion: y'' + y = 0'\n");
-    fprintf(script_gp, "set xlabel 'x'\n");
-    fprintf(script_gp, "set ylabel 'y(x)'\n");
-    fprintf(script_gp, "set grid\n");
-    fprintf(script_gp, "set key top left box\n");
-    fprintf(script_gp, "plot 'ypp_solucion.dat' w l lw 2 lc rgb '#0066CC' title 'Solucion RK4', \\\n");
-    fprintf(script_gp, "     sin(x) w l lw 2 lc rgb '#FF3333' dt 2 title 'sin(x) (exacta)'\n\n");
-    
-    // Grafico 2: Plano de fase
-    fprintf(script_gp, "# Grafico 2: Plano de fase\n");
-    fprintf(script_gp, "set title 'Plano de fase: y vs y''\n");
-    fprintf(script_gp, "set xlabel 'y(x)'\n");
-    fprintf(script_gp, "set ylabel 'y'(x)'\n");
-    fprintf(script_gp, "set grid\n");
-    fprintf(script_gp, "set key off\n");
-    fprintf(script_gp, "set size ratio -1\n");
-    fprintf(script_gp, "plot 'ypp_fase.dat' w l lw 1.5 lc rgb '#00AA00' title 'Trayectoria'\n\n");
-    
-    fprintf(script_gp, "unset multiplot\n");
-    fclose(script_gp);
+    if (motor_grafico == MOTOR_GNUPLOT) {
+        fprintf(script_gp, "# Script para ecuacion y'' + y = 0\n");
+        fprintf(script_gp, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
+                ANCHO_GRAFICO, ALTO_GRAFICO);
+        fprintf(script_gp, "set output '%s'\n", NOMBRE_GRAFICO);
+        
+        fprintf(script_gp, "\n# Configurar multiples graficos\n");
+        fprintf(script_gp, "set multiplot layout 2,1\n");
+        fprintf(script_gp, "set lmargin 10\n");
+        fprintf(script_gp, "set rmargin 5\n\n");
+        
+        // Grafico 1: Solucion
+        fprintf(script_gp, "# Grafico 1: Solucion y(x)\n");
+        fprintf(script_gp, "set title 'Solucion: y'' + y = 0'\n");
+        fprintf(script_gp, "set xlabel 'x'\n");
+        fprintf(script_gp, "set ylabel 'y(x)'\n");
+        fprintf(script_gp, "set grid\n");
+        fprintf(script_gp, "set key top left box\n");
+        // La sintaxis de expresion.h no es la de gnuplot: una solucion exacta de
+        // tiempo de ejecucion no se dibuja como curva
+        fprintf(script_gp, "plot %s w l lw 2 lc rgb '#0066CC' title 'Solucion RK4'%s",
+                fuente_gnuplot("ypp_solucion.dat", FORMATO_SALIDA),
+                expr_exacta.activa ? "\n\n" : ", \\\n");
+        if (!expr_exacta.activa) {
+            fprintf(script_gp, "     sin(x) w l lw 2 lc rgb '#FF3333' dt 2 title 'sin(x) (exacta)'\n\n");
+        }
+        
+        // Grafico 2: Plano de fase
+        fprintf(script_gp, "# Grafico 2: Plano de fase\n");
+        fprintf(script_gp, "set title 'Plano de fase: y vs y''\n");
+        fprintf(script_gp, "set xlabel 'y(x)'\n");
+        fprintf(script_gp, "set ylabel 'y'(x)'\n");
+        fprintf(script_gp, "set grid\n");
+        fprintf(script_gp, "set key off\n");
+        fprintf(script_gp, "set size ratio -1\n");
+        fprintf(script_gp, "plot %s w l lw 1.5 lc rgb '#00AA00' title 'Trayectoria'\n\n",
+                fuente_gnuplot("ypp_fase.dat", FORMATO_SALIDA));
+        
+        fprintf(script_gp, "unset multiplot\n");
+        fclose(script_gp);
+    }
     
     // ============================================================================
     // EJECUTAR GNUPLOT
@@ -304,12 +694,15 @@ int main() {
     printf(" GENERANDO GRAFICO...\n");
     printf("-------------------------------------------------------------\n");
     
-    int resultado_gnuplot = system("gnuplot ypp_plot.gp 2>&1");
+    int resultado_gnuplot = (motor_grafico == MOTOR_SVG) ? graficar_svg(x)
+                                                         : system("gnuplot ypp_plot.gp 2>&1");
     
     if (resultado_gnuplot != 0) {
-        printf(" ADVERTENCIA: Gnuplot reporto problemas\n");
+        printf(" ADVERTENCIA: %s\n", (motor_grafico == MOTOR_SVG) ? "No se pudo escribir el grafico SVG"
+                                                                 : "Gnuplot reporto problemas");
     } else {
-        printf(" Grafico generado: %s\n", NOMBRE_GRAFICO);
+        printf(" Grafico generado: %s\n",
+               (motor_grafico == MOTOR_SVG) ? grafico_nombre_svg(NOMBRE_GRAFICO) : NOMBRE_GRAFICO);
     }
     
     // ============================================================================
@@ -318,10 +711,17 @@ int main() {
     printf("\n ANALISIS DE RESULTADOS:\n");
     printf("-------------------------------------------------------------\n");
     
+    // Estadisticas acumuladas durante la integracion
+    double error_maximo = estad_maximo(&errores);
+    
     // Calcular energia final y variacion
     double energia_final = y*y + yp*yp;
     double variacion_energia = fabs(energia_final - energia_inicial);
-    double variacion_relativa = 100 * variacion_energia / energia_inicial;
+    // Con energia inicial nula se usa la variacion absoluta
+    double variacion_relativa = 100 * variacion_energia;
+    if (energia_inicial > 0) {
+        variacion_relativa /= energia_inicial;
+    }
     
     // Calcular periodicidad
     double periodo_teorico = 2*M_PI;
@@ -329,10 +729,22 @@ int main() {
     
     printf("  Pasos completados:   %d\n", paso);
     printf("  Error maximo:        %.6f\n", error_maximo);
+    printf("  Error promedio:      %.2e\n", estad_media(&errores));
+    printf("  Error RMS:           %.2e\n", estad_rms(&errores));
     printf("  Energia inicial:     %.6f\n", energia_inicial);
     printf("  Energia final:       %.6f\n", energia_final);
+    printf("  Energia min / max:   %.8f / %.8f\n", estad_minimo(&energias), estad_maximo(&energias));
     printf("  Variacion energia:   %.2e (%.2f%%)\n", 
            variacion_energia, variacion_relativa);
+    if (energia_inicial > 0) {
+        printf("  Deriva energia:      %.2e por unidad de x (max |dE/E0| = %.2e)\n",
+               (energia_final - energia_inicial) / energia_inicial / (x - X_INICIAL),
+               fmax(estad_maximo(&energias) - energia_inicial,
+                    energia_inicial - estad_minimo(&energias)) / energia_inicial);
+    } else {
+        printf("  Deriva energia:      no definida (energia inicial nula)\n");
+    }
+    printf("  Evaluaciones EDO:    %ld (%s)\n", evaluaciones, nombre_integrador(INTEGRADOR));
     printf("  Ciclos completos:    %d\n", ciclos_completos);
     printf("  Errores numericos:   %d\n", errores_numericos);
     
@@ -350,7 +762,7 @@ int main() {
     
     // Evaluar periodicidad
     printf("\n  EVALUACION DE PERIODICIDAD:\n");
-    double y_final_teorico = sin(X_FINAL);
+    double y_final_teorico = EVAL_EXACTA(X_FINAL);
     double error_periodicidad = fabs(y - y_final_teorico);
     
     if (error_periodicidad < 0.01) {
@@ -368,14 +780,17 @@ int main() {
     printf("-------------------------------------------------------------\n");
     
     // Verificar que satisface la EDO
-    double ypp_numerica = EDO_FUNCION(x, y, yp);
+    double ypp_numerica = EVAL_EDO(x, y, yp);
     double residual = ypp_numerica + y;  // y'' + y deberia ser 0
     
     printf("  En x = %.4f:\n", x);
     printf("    y calculado:       %.8f\n", y);
     printf("    y' calculado:      %.8f\n", yp);
     printf("    y'' calculado:     %.8f\n", ypp_numerica);
-    printf("    Residual (y''+y):  %.2e (deberia ser ~0)\n", residual);
+    
+    // El residual y'' + y solo tiene sentido para la ecuacion de las macros
+    if (expr_edo.activa) residual = 0.0;
+    else printf("    Residual (y''+y):  %.2e (deberia ser ~0)\n", residual);
     
     if (fabs(residual) > 0.1) {
         printf("  ADVERTENCIA: Residual grande, solucion puede no satisfacer EDO\n");
@@ -394,7 +809,13 @@ int main() {
            variacion_energia, variacion_relativa);
     printf("  Grafico generado:    %s\n", 
            (resultado_gnuplot == 0) ? "SI" : "NO");
-    printf("  Archivos creados:    ypp_solucion.dat, ypp_derivada.dat, ypp_fase.dat\n");
+    printf("  Archivos creados:    %s, %s, %s\n",
+           nombre_salida("ypp_solucion.dat", FORMATO_SALIDA),
+           nombre_salida("ypp_derivada.dat", FORMATO_SALIDA),
+           nombre_salida("ypp_fase.dat", FORMATO_SALIDA));
+    if (motor_grafico == MOTOR_SVG) {
+        printf("                       %s\n", grafico_nombre_svg(NOMBRE_GRAFICO));
+    }
     
     printf("\n EJECUCION COMPLETADA\n");
     
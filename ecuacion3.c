@@ -5,6 +5,14 @@
 #include <math.h>
 #include <stdlib.h>
 #include <errno.h>
+#include "nucleo.h"
+#include "datos_columnar.h"
+#include "expresion.h"
+#include "benchmark.h"
+#include "estadistica.h"
+#include "grafico.h"
+#include "barrido.h"
+#include "convergencia.h"
 
 // ============================================================================
 // ============================================================================
@@ -15,34 +23,36 @@
 #define X_INICIAL           1.0
 #define Y_INICIAL           0.0
 #define PASO_H              0.05
-#define NOMBRE_GRAFICO1     "sistema_temporal.png"
+#define FORMATO_SALIDA      FORMATO_TEXTO    // FORMATO_TEXTO o FORMATO_BINARIO
+#define NIVEL_VALIDACION    VALIDACION_OPERACION  // _OPERACION, _PASO o _NINGUNA (o entorno VALIDACION)
+#define MODO_ENSEMBLE       0        // 1 = barrido de muchas condiciones iniciales
+#define ENSEMBLE_N          16384    // Trayectorias del ensemble
+#define ENSEMBLE_RANGO      2.0      // Condiciones iniciales en [-R, R] x [-R, R]
+#define MODO_STREAMING      0        // 1 = integracion larga con reducciones en linea
+#define STREAM_PASOS        1000000000L  // Pasos de PASO_H desde T_INICIAL (ignora T_FINAL)
+#define STREAM_DIEZMADO     10000    // Se guarda 1 de cada N pasos
+#define STREAM_VENTANA      100000   // Pasos por ventana de envolvente min/max
+#define MOTOR_GRAFICO       MOTOR_GNUPLOT    // MOTOR_GNUPLOT o MOTOR_SVG (o entorno GRAFICO)
+#define NOMBRE_GRAFICO1     "sistema_temporal.png"   // Con MOTOR_SVG: extension .svg
 #define NOMBRE_GRAFICO2     "sistema_fase.png"
 #define ANCHO_GRAFICO       800
 #define ALTO_GRAFICO        600
 // ============================================================================
 
-// ============================================================================
-// FUNCIONES DE VALIDACION
-// ============================================================================
-int es_numerico_valido(double valor) {
-    return !(isnan(valor) || isinf(valor) || fabs(valor) > 1e100);
-}
+#define ENSEMBLE_BLOQUE     512      // Trayectorias por bloque (caben en L1)
+#define STREAM_MAX_FILAS    100000   // Tope de filas por archivo: diezmado y ventana crecen si hace falta
+#define STREAM_PROGRESO     10       // Filas de progreso en pantalla
 
-void verificar_nan_inf(const char *nombre, double valor, int linea) {
-    if (isnan(valor)) {
-        printf("ERROR [Linea %d]: %s = NaN\n", linea, nombre);
-        printf("   Causa: Operacion matematica invalida\n");
-        exit(EXIT_FAILURE);
-    }
-    if (isinf(valor)) {
-        printf("ERROR [Linea %d]: %s = Infinito\n", linea, nombre);
-        printf("   Causa: Overflow numerico\n");
-        exit(EXIT_FAILURE);
-    }
-}
+// Funciones definidas en tiempo de ejecucion: las variables de entorno F1 y F2
+// reemplazan a las macros, p. ej.  F1="y" F2="-x - 0.1*y" ./ecuacion3
+Expresion expr_f1, expr_f2;
 
-#define VALIDAR(variable) verificar_nan_inf(#variable, variable, __LINE__)
+#define EVAL_F1(x,y)        (expr_f1.activa ? expr_evaluar_2(&expr_f1, (x), (y)) : F1(x,y))
+#define EVAL_F2(x,y)        (expr_f2.activa ? expr_evaluar_2(&expr_f2, (x), (y)) : F2(x,y))
 
+// ============================================================================
+// FUNCIONES DE VALIDACION
+// ============================================================================
 void validar_parametros() {
     if (PASO_H <= 0) {
         printf("ERROR: PASO_H debe ser positivo (h = %f)\n", PASO_H);
@@ -60,8 +70,8 @@ void validar_parametros() {
     }
     
     // Verificar propiedades del sistema
-    double f1_inicial = F1(X_INICIAL, Y_INICIAL);
-    double f2_inicial = F2(X_INICIAL, Y_INICIAL);
+    double f1_inicial = EVAL_F1(X_INICIAL, Y_INICIAL);
+    double f2_inicial = EVAL_F2(X_INICIAL, Y_INICIAL);
     VALIDAR(f1_inicial);
     VALIDAR(f2_inicial);
     
@@ -69,58 +79,25 @@ void validar_parametros() {
     printf("Sistema valido: matriz antisimetrica\n");
 }
 
-FILE* abrir_archivo(const char *nombre, const char *modo) {
-    FILE *archivo = fopen(nombre, modo);
-    if (archivo == NULL) {
-        printf("ERROR: No se pudo abrir '%s'\n", nombre);
-        exit(EXIT_FAILURE);
-    }
-    return archivo;
-}
-
 // ============================================================================
 // RUNGE-KUTTA 4 PARA SISTEMAS 2x2 CON VALIDACION
 // ============================================================================
+void derivada_sistema(double t, const double *estado, double *d) {
+    (void)t;    // Sistema autonomo
+    d[0] = EVAL_F1(estado[0], estado[1]);
+    d[1] = EVAL_F2(estado[0], estado[1]);
+}
+
+const ProblemaEDO problema_sistema = { 2, derivada_sistema };
+
 void rk4_sistema2_validado(double t, double *x, double *y, double h, int iter_actual) {
-    double k1_x, k1_y, k2_x, k2_y, k3_x, k3_y, k4_x, k4_y;
-    
-    // k1
-    k1_x = F1(*x, *y);
-    k1_y = F2(*x, *y);
-    VALIDAR(k1_x); VALIDAR(k1_y);
-    
-    // k2
-    double x2 = *x + h*k1_x/2;
-    double y2 = *y + h*k1_y/2;
-    VALIDAR(x2); VALIDAR(y2);
+    double estado[2] = { *x, *y };
     
-    k2_x = F1(x2, y2);
-    k2_y = F2(x2, y2);
-    VALIDAR(k2_x); VALIDAR(k2_y);
+    // Etapas k1..k4 validadas en rk4_paso_edo (nucleo.h)
+    rk4_paso_edo(&problema_sistema, t, estado, h);
     
-    // k3
-    double x3 = *x + h*k2_x/2;
-    double y3 = *y + h*k2_y/2;
-    VALIDAR(x3); VALIDAR(y3);
-    
-    k3_x = F1(x3, y3);
-    k3_y = F2(x3, y3);
-    VALIDAR(k3_x); VALIDAR(k3_y);
-    
-    // k4
-    double x4 = *x + h*k3_x;
-    double y4 = *y + h*k3_y;
-    VALIDAR(x4); VALIDAR(y4);
-    
-    k4_x = F1(x4, y4);
-    k4_y = F2(x4, y4);
-    VALIDAR(k4_x); VALIDAR(k4_y);
-    
-    // Nuevos valores
-    double x_nuevo = *x + h*(k1_x + 2*k2_x + 2*k3_x + k4_x)/6;
-    double y_nuevo = *y + h*(k1_y + 2*k2_y + 2*k3_y + k4_y)/6;
-    
-    VALIDAR(x_nuevo); VALIDAR(y_nuevo);
+    double x_nuevo = estado[0];
+    double y_nuevo = estado[1];
     
     // Verificar conservacion de energia (x^2 + y^2 constante)
     double energia_antes = (*x)*(*x) + (*y)*(*y);
@@ -144,6 +121,569 @@ void rk4_sistema2_validado(double t, double *x, double *y, double h, int iter_ac
     *y = y_nuevo;
 }
 
+// ============================================================================
+// ENSEMBLE DE TRAYECTORIAS (RK4 VECTORIZADO)
+// ============================================================================
+// Estructura de arreglos: x[i], y[i] son el estado de la trayectoria i.
+// Compilar con -O3 -march=native (y -fopenmp para usar varios nucleos) para que
+// el lazo sobre trayectorias use AVX2/AVX-512.
+typedef struct {
+    int n;
+    double *x0, *y0;        // Condiciones iniciales
+    double *x, *y;          // Estado actual
+    int *activo;            // 1 mientras la trayectoria sea numericamente valida
+    int *paso_fallo;        // Paso en que se invalido (-1 si nunca)
+} Ensemble;
+
+double* reservar_alineado(int n) {
+    size_t bytes = ((n * sizeof(double) + 63) / 64) * 64;
+    double *p = aligned_alloc(64, bytes);
+    if (p == NULL) {
+        printf("ERROR: Memoria insuficiente para ensemble de %d trayectorias\n", n);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+void crear_ensemble(Ensemble *e, int n) {
+    e->n = n;
+    e->x0 = reservar_alineado(n);
+    e->y0 = reservar_alineado(n);
+    e->x = reservar_alineado(n);
+    e->y = reservar_alineado(n);
+    e->activo = malloc(n * sizeof(int));
+    e->paso_fallo = malloc(n * sizeof(int));
+    
+    if (e->activo == NULL || e->paso_fallo == NULL) {
+        printf("ERROR: Memoria insuficiente para ensemble de %d trayectorias\n", n);
+        exit(EXIT_FAILURE);
+    }
+    
+    // Malla cuadrada de condiciones iniciales
+    int lado = (int)ceil(sqrt((double)n));
+    double paso_malla = (lado > 1) ? 2*ENSEMBLE_RANGO / (lado - 1) : 0.0;
+    
+    for (int i = 0; i < n; i++) {
+        e->x0[i] = e->x[i] = -ENSEMBLE_RANGO + (i % lado) * paso_malla;
+        e->y0[i] = e->y[i] = -ENSEMBLE_RANGO + (i / lado) * paso_malla;
+        e->activo[i] = es_numerico_valido(e->x[i]) && es_numerico_valido(e->y[i]);
+        e->paso_fallo[i] = e->activo[i] ? -1 : 0;
+    }
+}
+
+void liberar_ensemble(Ensemble *e) {
+    free(e->x0); free(e->y0);
+    free(e->x); free(e->y);
+    free(e->activo); free(e->paso_fallo);
+}
+
+// Avanza n trayectorias 'pasos' pasos de RK4. En lugar de VALIDAR (que
+// aborta el programa) cada carril lleva una mascara: si el nuevo estado es
+// NaN, infinito o > 1e100 la trayectoria se congela en su ultimo valor valido
+// y se anota el paso. Sin ramas en el cuerpo, el compilador puede vectorizar.
+// Usa las macros F1/F2; con expresiones del entorno ver rk4_ensemble_bloque_expr.
+void rk4_ensemble_bloque(double *restrict x, double *restrict y, int *restrict activo,
+                         int *restrict paso_fallo, int n, double h, int paso_inicial, int pasos) {
+    for (int paso = paso_inicial; paso < paso_inicial + pasos; paso++) {
+        #pragma omp simd
+        for (int i = 0; i < n; i++) {
+            double xi = x[i], yi = y[i];
+            
+            double k1_x = F1(xi, yi);
+            double k1_y = F2(xi, yi);
+            double k2_x = F1(xi + h*k1_x/2, yi + h*k1_y/2);
+            double k2_y = F2(xi + h*k1_x/2, yi + h*k1_y/2);
+            double k3_x = F1(xi + h*k2_x/2, yi + h*k2_y/2);
+            double k3_y = F2(xi + h*k2_x/2, yi + h*k2_y/2);
+            double k4_x = F1(xi + h*k3_x, yi + h*k3_y);
+            double k4_y = F2(xi + h*k3_x, yi + h*k3_y);
+            
+            double x_nuevo = xi + h*(k1_x + 2*k2_x + 2*k3_x + k4_x)/6;
+            double y_nuevo = yi + h*(k1_y + 2*k2_y + 2*k3_y + k4_y)/6;
+            
+            // fabs(NaN) <= 1e100 es falso, igual que para infinito
+            int valido = (fabs(x_nuevo) <= 1e100) & (fabs(y_nuevo) <= 1e100);
+            int sigue = activo[i] & valido;
+            
+            paso_fallo[i] = (activo[i] & !valido) ? paso : paso_fallo[i];
+            x[i] = sigue ? x_nuevo : xi;
+            y[i] = sigue ? y_nuevo : yi;
+            activo[i] = sigue;
+        }
+    }
+}
+
+// Campo vectorial sobre n puntos con la API por lotes de expresion.h
+void evaluar_campo_lote(const double *x, const double *y, double *fx, double *fy, int n) {
+    const double *vars[2] = {x, y};
+    
+    if (expr_f1.activa) expr_evaluar_lote(&expr_f1, vars, fx, n);
+    else for (int i = 0; i < n; i++) fx[i] = F1(x[i], y[i]);
+    
+    if (expr_f2.activa) expr_evaluar_lote(&expr_f2, vars, fy, n);
+    else for (int i = 0; i < n; i++) fy[i] = F2(x[i], y[i]);
+}
+
+// Misma integracion que rk4_ensemble_bloque cuando F1/F2 vienen del entorno:
+// cada etapa de RK4 evalua el bloque completo de una vez, asi el costo de
+// interpretar el bytecode se reparte entre todas las trayectorias.
+void rk4_ensemble_bloque_expr(double *x, double *y, int *activo, int *paso_fallo,
+                              int n, double h, int paso_inicial, int pasos) {
+    double xs[ENSEMBLE_BLOQUE], ys[ENSEMBLE_BLOQUE];
+    double k1_x[ENSEMBLE_BLOQUE], k1_y[ENSEMBLE_BLOQUE], k2_x[ENSEMBLE_BLOQUE], k2_y[ENSEMBLE_BLOQUE];
+    double k3_x[ENSEMBLE_BLOQUE], k3_y[ENSEMBLE_BLOQUE], k4_x[ENSEMBLE_BLOQUE], k4_y[ENSEMBLE_BLOQUE];
+    
+    for (int paso = paso_inicial; paso < paso_inicial + pasos; paso++) {
+        evaluar_campo_lote(x, y, k1_x, k1_y, n);
+        for (int i = 0; i < n; i++) { xs[i] = x[i] + h*k1_x[i]/2; ys[i] = y[i] + h*k1_y[i]/2; }
+        evaluar_campo_lote(xs, ys, k2_x, k2_y, n);
+        for (int i = 0; i < n; i++) { xs[i] = x[i] + h*k2_x[i]/2; ys[i] = y[i] + h*k2_y[i]/2; }
+        evaluar_campo_lote(xs, ys, k3_x, k3_y, n);
+        for (int i = 0; i < n; i++) { xs[i] = x[i] + h*k3_x[i]; ys[i] = y[i] + h*k3_y[i]; }
+        evaluar_campo_lote(xs, ys, k4_x, k4_y, n);
+        
+        #pragma omp simd
+        for (int i = 0; i < n; i++) {
+            double x_nuevo = x[i] + h*(k1_x[i] + 2*k2_x[i] + 2*k3_x[i] + k4_x[i])/6;
+            double y_nuevo = y[i] + h*(k1_y[i] + 2*k2_y[i] + 2*k3_y[i] + k4_y[i])/6;
+            
+            int valido = (fabs(x_nuevo) <= 1e100) & (fabs(y_nuevo) <= 1e100);
+            int sigue = activo[i] & valido;
+            
+            paso_fallo[i] = (activo[i] & !valido) ? paso : paso_fallo[i];
+            x[i] = sigue ? x_nuevo : x[i];
+            y[i] = sigue ? y_nuevo : y[i];
+            activo[i] = sigue;
+        }
+    }
+}
+
+const char* texto_sistema() {
+    static char texto[600];
+    snprintf(texto, sizeof(texto), "dx/dt=%s, dy/dt=%s",
+             expr_f1.activa ? expr_f1.texto : "y", expr_f2.activa ? expr_f2.texto : "-x");
+    return texto;
+}
+
+// Solucion exacta del sistema de las macros (dx/dt = y, dy/dt = -x): el
+// estado (x0, y0) en T_INICIAL rota en sentido horario
+void rotacion_exacta(double t, double x0, double y0, double *estado) {
+    double c = cos(t - T_INICIAL), s = sin(t - T_INICIAL);
+    estado[0] = x0*c + y0*s;
+    estado[1] = -x0*s + y0*c;
+}
+
+int ejecutar_ensemble() {
+    int pasos = (int)round((T_FINAL - T_INICIAL) / PASO_H);
+    Ensemble e;
+    
+    printf("===============================================================\n");
+    printf("          ENSEMBLE RK4: %s\n", texto_sistema());
+    printf("===============================================================\n\n");
+    
+    printf("CONFIGURACION:\n");
+    printf("   Trayectorias:     %d\n", ENSEMBLE_N);
+    printf("   Condiciones:      malla en [%.1f, %.1f]^2\n", -ENSEMBLE_RANGO, ENSEMBLE_RANGO);
+    printf("   Pasos:            %d (h = %.3f)\n", pasos, PASO_H);
+    printf("   Bloque:           %d trayectorias\n\n", ENSEMBLE_BLOQUE);
+    
+    crear_ensemble(&e, ENSEMBLE_N);
+    
+    double inicio = bench_tiempo();
+    
+    #pragma omp parallel for schedule(static)
+    for (int b = 0; b < e.n; b += ENSEMBLE_BLOQUE) {
+        int n_bloque = (e.n - b < ENSEMBLE_BLOQUE) ? e.n - b : ENSEMBLE_BLOQUE;
+        if (expr_f1.activa || expr_f2.activa) {
+            rk4_ensemble_bloque_expr(e.x + b, e.y + b, e.activo + b, e.paso_fallo + b,
+                                     n_bloque, PASO_H, 0, pasos);
+        } else {
+            rk4_ensemble_bloque(e.x + b, e.y + b, e.activo + b, e.paso_fallo + b,
+                                n_bloque, PASO_H, 0, pasos);
+        }
+    }
+    
+    double segundos = bench_tiempo() - inicio;
+    
+    // Resultados por trayectoria
+    SalidaDatos *datos = salida_abrir("ensemble_final.dat", FORMATO_SALIDA,
+                                      "x0 y0 x_final y_final valido paso_fallo",
+                                      "%.6f %.6f %.6f %.6f %.0f %.0f\n");
+    
+    int invalidas = 0;
+    double desvio_max = 0.0;
+    
+    for (int i = 0; i < e.n; i++) {
+        SALIDA_FILA(datos, e.x0[i], e.y0[i], e.x[i], e.y[i], e.activo[i], e.paso_fallo[i]);
+        
+        if (!e.activo[i]) {
+            invalidas++;
+            continue;
+        }
+        
+        double energia_0 = e.x0[i]*e.x0[i] + e.y0[i]*e.y0[i];
+        double energia_f = e.x[i]*e.x[i] + e.y[i]*e.y[i];
+        if (energia_0 > 0) {
+            desvio_max = fmax(desvio_max, fabs(energia_f - energia_0) / energia_0);
+        }
+    }
+    salida_cerrar(datos);
+    
+    double tasa = (double)e.n * pasos / segundos;
+    
+    printf("RESULTADOS:\n");
+    printf("-----------------------------------------------------------------\n");
+    printf("  Tiempo de integracion:     %.4f s\n", segundos);
+    printf("  Rendimiento:               %.3e trayectorias*pasos/s\n", tasa);
+    printf("  Trayectorias invalidas:    %d de %d\n", invalidas, e.n);
+    printf("  Max variacion rel. energia: %.2e\n", desvio_max);
+    printf("  Archivo creado:            %s\n", nombre_salida("ensemble_final.dat", FORMATO_SALIDA));
+    
+    liberar_ensemble(&e);
+    
+    return (invalidas == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// ============================================================================
+// MODO STREAMING (MEMORIA Y DISCO ACOTADOS)
+// ============================================================================
+// Para horizontes de 1e9 pasos no se guarda cada paso: el estado se reduce
+// en linea a
+//   - una muestra cada 'diezmado' pasos       -> sistema_stream.dat
+//   - min/max de x, y, E por ventana          -> sistema_envolvente.dat
+//   - estadisticas de energia y error         -> en pantalla
+//   - el estado final                         -> sistema_estado_final.dat
+// Diezmado y ventana se agrandan para no superar STREAM_MAX_FILAS filas, asi
+// que el disco no depende de STREAM_PASOS; la memoria es constante.
+// ============================================================================
+
+// Paso de RK4 sin VALIDAR ni avisos por paso: el llamador revisa el estado
+void rk4_sistema2_paso(double *x, double *y, double h) {
+    double k1_x = EVAL_F1(*x, *y);
+    double k1_y = EVAL_F2(*x, *y);
+    double k2_x = EVAL_F1(*x + h*k1_x/2, *y + h*k1_y/2);
+    double k2_y = EVAL_F2(*x + h*k1_x/2, *y + h*k1_y/2);
+    double k3_x = EVAL_F1(*x + h*k2_x/2, *y + h*k2_y/2);
+    double k3_y = EVAL_F2(*x + h*k2_x/2, *y + h*k2_y/2);
+    double k4_x = EVAL_F1(*x + h*k3_x, *y + h*k3_y);
+    double k4_y = EVAL_F2(*x + h*k3_x, *y + h*k3_y);
+    
+    *x += h*(k1_x + 2*k2_x + 2*k3_x + k4_x)/6;
+    *y += h*(k1_y + 2*k2_y + 2*k3_y + k4_y)/6;
+}
+
+typedef struct {
+    long inicio;
+    double x_min, x_max, y_min, y_max, e_min, e_max;
+} VentanaEnvolvente;
+
+void ventana_iniciar(VentanaEnvolvente *v, long inicio) {
+    v->inicio = inicio;
+    v->x_min = v->y_min = v->e_min = INFINITY;
+    v->x_max = v->y_max = v->e_max = -INFINITY;
+}
+
+void ventana_agregar(VentanaEnvolvente *v, double x, double y, double e) {
+    v->x_min = fmin(v->x_min, x); v->x_max = fmax(v->x_max, x);
+    v->y_min = fmin(v->y_min, y); v->y_max = fmax(v->y_max, y);
+    v->e_min = fmin(v->e_min, e); v->e_max = fmax(v->e_max, e);
+}
+
+void ventana_escribir(SalidaDatos *s, const VentanaEnvolvente *v, long fin) {
+    SALIDA_FILA(s, T_INICIAL + v->inicio * PASO_H, T_INICIAL + fin * PASO_H,
+                v->x_min, v->x_max, v->y_min, v->y_max, v->e_min, v->e_max);
+}
+
+int ejecutar_streaming() {
+    long pasos = STREAM_PASOS;
+    long diezmado = STREAM_DIEZMADO, ventana = STREAM_VENTANA;
+    long minimo = (pasos + STREAM_MAX_FILAS - 1) / STREAM_MAX_FILAS;
+    if (diezmado < minimo) diezmado = minimo;
+    if (ventana < minimo) ventana = minimo;
+    long cada_progreso = (pasos >= STREAM_PROGRESO) ? pasos / STREAM_PROGRESO : 1;
+    int con_exacta = !expr_f1.activa && !expr_f2.activa;
+    
+    printf("===============================================================\n");
+    printf("          STREAMING RK4: %s\n", texto_sistema());
+    printf("===============================================================\n\n");
+    
+    printf("CONFIGURACION:\n");
+    printf("   Pasos:            %ld (h = %.3f, t final = %.6g)\n", pasos, PASO_H, T_INICIAL + pasos * PASO_H);
+    printf("   Diezmado:         1 de cada %ld pasos%s\n", diezmado,
+           diezmado != STREAM_DIEZMADO ? " (ajustado a STREAM_MAX_FILAS)" : "");
+    printf("   Ventana min/max:  %ld pasos%s\n\n", ventana,
+           ventana != STREAM_VENTANA ? " (ajustada a STREAM_MAX_FILAS)" : "");
+    
+    SalidaDatos *muestras = salida_abrir("sistema_stream.dat", FORMATO_SALIDA, "t x y energia",
+                                         "%.6f %.10g %.10g %.12g\n");
+    SalidaDatos *envolvente = salida_abrir("sistema_envolvente.dat", FORMATO_SALIDA,
+                                           "t_inicio t_fin x_min x_max y_min y_max e_min e_max",
+                                           "%.6f %.6f %.10g %.10g %.10g %.10g %.12g %.12g\n");
+    
+    double x = X_INICIAL, y = Y_INICIAL;
+    double energia_inicial = x*x + y*y;
+    EstadisticaOnline desvios_energia, errores;
+    estad_iniciar(&desvios_energia);
+    estad_iniciar(&errores);
+    VentanaEnvolvente v;
+    ventana_iniciar(&v, 0);
+    long paso_fallo = -1, paso = 0;
+    
+    printf("+---------------+------------+-----------+-----------+-----------+----------+\n");
+    // Con energia inicial nula la columna muestra dE absoluto
+    printf("|     Paso      |     t      |   x(t)    |   y(t)    |%s| Mpasos/s |\n",
+           (energia_inicial > 0) ? "  dE / E0  " : "     dE    ");
+    printf("+---------------+------------+-----------+-----------+-----------+----------+\n");
+    
+    double inicio = bench_tiempo(), ultimo_reporte = inicio;
+    long paso_reporte = 0;
+    
+    for (paso = 0; paso <= pasos; paso++) {
+        double t = T_INICIAL + paso * PASO_H;
+        double energia = x*x + y*y;
+        
+        if (!es_numerico_valido(x) || !es_numerico_valido(y)) {
+            paso_fallo = paso;
+            break;
+        }
+        
+        estad_agregar(&desvios_energia, energia - energia_inicial);
+        if (con_exacta) {
+            double exacta[2];
+            rotacion_exacta(t, X_INICIAL, Y_INICIAL, exacta);
+            estad_agregar(&errores, hypot(x - exacta[0], y - exacta[1]));
+        }
+        ventana_agregar(&v, x, y, energia);
+        
+        if (paso % diezmado == 0) SALIDA_FILA(muestras, t, x, y, energia);
+        if (paso - v.inicio + 1 == ventana) {
+            ventana_escribir(envolvente, &v, paso);
+            ventana_iniciar(&v, paso + 1);
+        }
+        if (paso % cada_progreso == 0 && paso > 0) {
+            double ahora = bench_tiempo();
+            double desvio = energia - energia_inicial;
+            if (energia_inicial > 0) {
+                desvio /= energia_inicial;
+            }
+            printf("| %13ld | %10.2f | %9.5f | %9.5f | %9.2e | %8.2f |\n", paso, t, x, y, desvio,
+                   (paso - paso_reporte) / (ahora - ultimo_reporte) * 1e-6);
+            fflush(stdout);
+            ultimo_reporte = ahora;
+            paso_reporte = paso;
+        }
+        
+        if (paso == pasos) break;
+        rk4_sistema2_paso(&x, &y, PASO_H);
+    }
+    // Ventana parcial al final (o hasta el ultimo paso valido)
+    if (v.e_min <= v.e_max) ventana_escribir(envolvente, &v, (paso_fallo >= 0) ? paso - 1 : paso);
+    
+    double segundos = bench_tiempo() - inicio;
+    printf("+---------------+------------+-----------+-----------+-----------+----------+\n\n");
+    salida_cerrar(muestras);
+    salida_cerrar(envolvente);
+    
+    // Estado final: punto de partida para continuar la integracion
+    double t_final = T_INICIAL + paso * PASO_H;
+    SalidaDatos *final = salida_abrir("sistema_estado_final.dat", FORMATO_SALIDA, "paso t x y energia",
+                                      "%.0f %.17g %.17g %.17g %.17g\n");
+    SALIDA_FILA(final, paso, t_final, x, y, x*x + y*y);
+    salida_cerrar(final);
+    
+    printf("RESULTADOS:\n");
+    printf("-----------------------------------------------------------------\n");
+    if (paso_fallo >= 0) {
+        printf("  ERROR: estado invalido en el paso %ld (t = %.6f)\n", paso_fallo, t_final);
+    }
+    printf("  Pasos integrados:          %ld\n", paso);
+    printf("  Tiempo:                    %.3f s (%.2f Mpasos/s)\n", segundos, paso / segundos * 1e-6);
+    printf("  Estado final:              t = %.6f, x = %.12g, y = %.12g\n", t_final, x, y);
+    printf("  Energia inicial / final:   %.12g / %.12g\n", energia_inicial, x*x + y*y);
+    printf("  dE medio / RMS:            %.2e / %.2e\n",
+           estad_media(&desvios_energia), estad_rms(&desvios_energia));
+    printf("  dE min / max:              %.2e / %.2e\n",
+           estad_minimo(&desvios_energia), estad_maximo(&desvios_energia));
+    if (con_exacta) {
+        printf("  Error |r| max / RMS:       %.2e / %.2e\n", estad_maximo(&errores), estad_rms(&errores));
+    }
+    printf("\n  - %s -> 1 de cada %ld pasos\n", nombre_salida("sistema_stream.dat", FORMATO_SALIDA), diezmado);
+    printf("  - %s -> min/max por ventana de %ld pasos\n",
+           nombre_salida("sistema_envolvente.dat", FORMATO_SALIDA), ventana);
+    printf("  - %s -> estado final\n", nombre_salida("sistema_estado_final.dat", FORMATO_SALIDA));
+    
+    return (paso_fallo < 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// ============================================================================
+// BARRIDO DE PARAMETROS (BARRIDO=... ./ecuacion3, ver barrido.h)
+// ============================================================================
+// Cada conjunto (PASO_H, T_FINAL, X_INICIAL, Y_INICIAL) se integra con RK4
+// sin escribir archivos. Con el sistema de las macros el error es
+// |r - r_exacta| contra la rotacion de (X_INICIAL, Y_INICIAL) del conjunto;
+// con F1/F2 del entorno, contra RK4 de paso h/BARRIDO_REFINAMIENTO.
+#define PARAMETROS_BARRIDO  "PASO_H T_FINAL X_INICIAL Y_INICIAL"
+
+void trabajo_barrido(const double *p, int fase, ResultadoBarrido *r) {
+    double h = p[0], t_final = p[1];
+    double estado[2] = { p[2], p[3] }, estado_ref[2] = { p[2], p[3] };
+    long pasos = barrido_pasos(T_INICIAL, t_final, h);
+    
+    if (pasos == 0) {
+        r->estado = BARRIDO_RECHAZADO;
+        return;
+    }
+    r->con_exacta = !expr_f1.activa && !expr_f2.activa;
+    
+    for (long i = 0; i < pasos; i++) {
+        double t = T_INICIAL + i*h;
+        double h_paso = (i == pasos - 1) ? t_final - t : h;
+        
+        rk4_paso_edo(&problema_sistema, t, estado, h_paso);
+        if (fase == BARRIDO_FASE_METODO) r->pasos++;
+        if (!es_numerico_valido(estado[0]) || !es_numerico_valido(estado[1])) {
+            r->estado = BARRIDO_INVALIDO;
+            break;
+        }
+        if (fase == BARRIDO_FASE_METODO) continue;
+        
+        if (r->con_exacta) {
+            rotacion_exacta(t + h_paso, p[2], p[3], estado_ref);
+        } else {
+            for (int k = 0; k < BARRIDO_REFINAMIENTO; k++) {
+                rk4_paso_edo(&problema_sistema, t + k*h_paso/BARRIDO_REFINAMIENTO, estado_ref,
+                             h_paso/BARRIDO_REFINAMIENTO);
+            }
+        }
+        barrido_error(r, hypot(estado[0] - estado_ref[0], estado[1] - estado_ref[1]));
+    }
+    r->evaluaciones = 8 * r->pasos;
+}
+
+int ejecutar_barrido() {
+    const double por_defecto[] = { PASO_H, T_FINAL, X_INICIAL, Y_INICIAL };
+    
+    printf("Sistema: %s\n\n", texto_sistema());
+    return barrido_correr("ecuacion3", PARAMETROS_BARRIDO, por_defecto, trabajo_barrido);
+}
+
+// ============================================================================
+// ESTUDIO DE CONVERGENCIA (CONVERGENCIA=tol ./ecuacion3, ver convergencia.h)
+// ============================================================================
+// Solucion exacta del sistema de las macros; con F1/F2 del entorno el
+// estudio sigue sin ella
+void exacta_convergencia(double t, double *estado) {
+    rotacion_exacta(t, X_INICIAL, Y_INICIAL, estado);
+}
+
+int ejecutar_convergencia(double tolerancia) {
+    const double y_inicial[2] = { X_INICIAL, Y_INICIAL };
+    int con_exacta = !expr_f1.activa && !expr_f2.activa;
+    EstudioConvergencia estudio = { &problema_sistema, T_INICIAL, T_FINAL, PASO_H, y_inicial, 2, "x y",
+                                    con_exacta ? exacta_convergencia : NULL, FORMATO_SALIDA };
+    
+    printf("Sistema: %s\n\n", texto_sistema());
+    return convergencia_ejecutar(&estudio, tolerancia);
+}
+
+// ============================================================================
+// MICRO-BENCHMARKS (BENCHMARK=1 ./ecuacion3)
+// ============================================================================
+// Escalar: una llamada = un paso de rk4_sistema2_validado (4 evaluaciones de
+// F1 y 4 de F2). Ensemble: una llamada = un paso de un bloque completo.
+ConteoBench bench_rk4_sistema2(void *contexto, long llamadas) {
+    (void)contexto;
+    double t = T_INICIAL, x = X_INICIAL, y = Y_INICIAL;
+    
+    for (long i = 0; i < llamadas; i++) {
+        if (t > T_FINAL) { t = T_INICIAL; x = X_INICIAL; y = Y_INICIAL; }
+        rk4_sistema2_validado(t, &x, &y, PASO_H, 0);
+        t += PASO_H;
+    }
+    bench_sumidero += x + y;
+    return (ConteoBench){ llamadas, 8.0 * llamadas };
+}
+
+ConteoBench bench_ensemble(void *contexto, long llamadas) {
+    Ensemble *e = contexto;
+    int n = (e->n < ENSEMBLE_BLOQUE) ? e->n : ENSEMBLE_BLOQUE;
+    
+    for (long i = 0; i < llamadas; i++) {
+        if (expr_f1.activa || expr_f2.activa) {
+            rk4_ensemble_bloque_expr(e->x, e->y, e->activo, e->paso_fallo, n, PASO_H, 0, 1);
+        } else {
+            rk4_ensemble_bloque(e->x, e->y, e->activo, e->paso_fallo, n, PASO_H, 0, 1);
+        }
+    }
+    bench_sumidero += e->x[0];
+    return (ConteoBench){ (double)n * llamadas, 8.0 * n * llamadas };
+}
+
+int ejecutar_benchmark() {
+    Ensemble e;
+    crear_ensemble(&e, ENSEMBLE_BLOQUE);
+    
+    bench_encabezado("ecuacion3");
+    bench_medir("ecuacion3", "rk4_sistema2_validado", "paso", bench_rk4_sistema2, NULL);
+    bench_medir("ecuacion3", "rk4_ensemble_bloque", "tray*paso", bench_ensemble, &e);
+    bench_pie();
+    
+    liberar_ensemble(&e);
+    return EXIT_SUCCESS;
+}
+
+// ============================================================================
+// GRAFICOS EN MEMORIA (MOTOR_SVG)
+// ============================================================================
+// Los dos graficos de sistema_temporal.gp y sistema_fase_plot.gp, escritos
+// en el mismo proceso en lugar de dos llamadas a gnuplot
+#define SERIE_X             0
+#define SERIE_Y             1
+#define SERIE_X_EXACTA      2
+#define SERIE_Y_EXACTA      3
+
+PanelGrafico grafico_temporal, grafico_fase;
+
+void preparar_graficos() {
+    char titulo[GRAFICO_LARGO_TEXTO];
+    snprintf(titulo, sizeof(titulo), "Evolucion temporal: %.120s", texto_sistema());
+    
+    grafico_iniciar(&grafico_temporal, titulo, "Tiempo t", "x(t), y(t)");
+    grafico_temporal.leyenda = LEYENDA_DERECHA;
+    grafico_rango_x(&grafico_temporal, T_INICIAL, T_FINAL);
+    grafico_serie(&grafico_temporal, "x(t)", "#0066CC", TRAZO_LINEA, 2.0);
+    grafico_serie(&grafico_temporal, "y(t)", "#FF3333", TRAZO_LINEA, 2.0);
+    grafico_serie(&grafico_temporal, "cos(t) (exacta)", "#0066CC", TRAZO_LINEA | TRAZO_DISCONTINUO, 1.0);
+    grafico_serie(&grafico_temporal, "-sin(t) (exacta)", "#FF3333", TRAZO_LINEA | TRAZO_DISCONTINUO, 1.0);
+    
+    grafico_iniciar(&grafico_fase, "Plano de fase: x vs y", "x(t)", "y(t)");
+    grafico_fase.leyenda = LEYENDA_NINGUNA;
+    grafico_fase.proporcion_igual = 1;
+    grafico_rango_x(&grafico_fase, -1.2, 1.2);
+    grafico_rango_y(&grafico_fase, -1.2, 1.2);
+    grafico_serie(&grafico_fase, "Trayectoria", "#00AA00", TRAZO_LINEA, 1.5);
+    grafico_serie(&grafico_fase, "Circulo exacto", "#000000", TRAZO_LINEA | TRAZO_DISCONTINUO, 1.0);
+}
+
+// Curvas exactas muestreadas y escritura de ambos SVG; devuelve 0 o 1 por
+// grafico como los codigos de gnuplot
+void graficar_svg(int *resultado1, int *resultado2) {
+    for (int i = 0; i <= GRAFICO_MUESTRAS; i++) {
+        double t = T_INICIAL + (T_FINAL - T_INICIAL) * i / GRAFICO_MUESTRAS;
+        double s = 2 * M_PI * i / GRAFICO_MUESTRAS;
+        grafico_punto(&grafico_temporal, SERIE_X_EXACTA, t, cos(t));
+        grafico_punto(&grafico_temporal, SERIE_Y_EXACTA, t, -sin(t));
+        grafico_punto(&grafico_fase, 1, cos(s), sin(s));
+    }
+    
+    *resultado1 = grafico_escribir_svg(grafico_nombre_svg(NOMBRE_GRAFICO1), ANCHO_GRAFICO, ALTO_GRAFICO,
+                                       &grafico_temporal, 1);
+    *resultado2 = grafico_escribir_svg(grafico_nombre_svg(NOMBRE_GRAFICO2), ANCHO_GRAFICO, ALTO_GRAFICO,
+                                       &grafico_fase, 1);
+    grafico_liberar(&grafico_temporal);
+    grafico_liberar(&grafico_fase);
+}
+
 // ============================================================================
 // PROGRAMA PRINCIPAL
 // ============================================================================
@@ -154,8 +694,37 @@ int main() {
     printf("VALIDANDO SISTEMA DE ECUACIONES...\n");
     printf("-----------------------------------------------------------------\n");
     
+    validacion_iniciar(NIVEL_VALIDACION);
+    grafico_iniciar_motor(MOTOR_GRAFICO);
+    expr_desde_entorno(&expr_f1, "F1", "x y");
+    expr_desde_entorno(&expr_f2, "F2", "x y");
     validar_parametros();
     
+    if (bench_solicitado()) {
+        return ejecutar_benchmark();
+    }
+    
+    if (barrido_solicitado()) {
+        return ejecutar_barrido();
+    }
+    
+    double tolerancia;
+    if (convergencia_solicitada(&tolerancia)) {
+        return ejecutar_convergencia(tolerancia);
+    }
+    
+    if (MODO_ENSEMBLE) {
+        return ejecutar_ensemble();
+    }
+    
+    if (MODO_STREAMING) {
+        if (STREAM_PASOS <= 0 || STREAM_DIEZMADO <= 0 || STREAM_VENTANA <= 0) {
+            printf("ERROR: STREAM_PASOS, STREAM_DIEZMADO y STREAM_VENTANA deben ser positivos\n");
+            return EXIT_FAILURE;
+        }
+        return ejecutar_streaming();
+    }
+    
     double t = T_INICIAL;
     double x = X_INICIAL;
     double y = Y_INICIAL;
@@ -165,7 +734,7 @@ int main() {
     double energia_inicial = X_INICIAL*X_INICIAL + Y_INICIAL*Y_INICIAL;
     
     printf("Sistema validado correctamente\n");
-    printf("   Ecuaciones: dx/dt = y, dy/dt = -x\n");
+    printf("   Ecuaciones: %s\n", texto_sistema());
     printf("   Condiciones: x(0) = %.1f, y(0) = %.1f\n", X_INICIAL, Y_INICIAL);
     printf("   Tiempo: [%.1f, %.1f]\n", T_INICIAL, T_FINAL);
     printf("   Paso: h = %.3f\n", PASO_H);
@@ -176,14 +745,19 @@ int main() {
     // CONFIGURACION
     // ============================================================================
     printf("===============================================================\n");
-    printf("          SISTEMA DE ECUACIONES: dx/dt=y, dy/dt=-x           \n");
+    printf("          SISTEMA DE ECUACIONES: %s\n", texto_sistema());
     printf("===============================================================\n\n");
     
-    FILE *datos_fase = abrir_archivo("sistema_fase.dat", "w");
-    FILE *datos_x = abrir_archivo("sistema_x.dat", "w");
-    FILE *datos_y = abrir_archivo("sistema_y.dat", "w");
-    FILE *script_gp1 = abrir_archivo("sistema_temporal.gp", "w");
-    FILE *script_gp2 = abrir_archivo("sistema_fase_plot.gp", "w");
+    SalidaDatos *datos_fase = salida_abrir("sistema_fase.dat", FORMATO_SALIDA, "x y", "%.6f %.6f\n");
+    SalidaDatos *datos_x = salida_abrir("sistema_x.dat", FORMATO_SALIDA, "t x", "%.6f %.6f\n");
+    SalidaDatos *datos_y = salida_abrir("sistema_y.dat", FORMATO_SALIDA, "t y", "%.6f %.6f\n");
+    FILE *script_gp1 = NULL, *script_gp2 = NULL;
+    if (motor_grafico == MOTOR_SVG) {
+        preparar_graficos();
+    } else {
+        script_gp1 = abrir_archivo("sistema_temporal.gp", "w");
+        script_gp2 = abrir_archivo("sistema_fase_plot.gp", "w");
+    }
     
     printf("PROCESO DE INTEGRACION:\n");
     printf("+------+--------+-----------+-----------+-----------+-----------+\n");
@@ -191,7 +765,9 @@ int main() {
     printf("+------+--------+-----------+-----------+-----------+-----------+\n");
     
     int errores_numericos = 0;
-    double energia_max_desvio = 0.0;
+    EstadisticaOnline desvios_energia, errores;
+    estad_iniciar(&desvios_energia);
+    estad_iniciar(&errores);
     
     // ============================================================================
     // INTEGRACION DEL SISTEMA
@@ -202,13 +778,11 @@ int main() {
         VALIDAR(energia_actual);
         
         double desvio_energia = fabs(energia_actual - energia_inicial);
-        if (desvio_energia > energia_max_desvio) {
-            energia_max_desvio = desvio_energia;
-        }
         
         // Calcular soluciones exactas
         double x_exacto = cos(t);
         double y_exacto = -sin(t);
+        double error = hypot(x - x_exacto, y - y_exacto);
         
         // Estado de validacion
         const char *estado = "OK";
@@ -224,9 +798,9 @@ int main() {
             printf("\nERROR CRITICO: Valores no numericos en iteracion %d\n", iter);
             printf("   t = %.6f, x = %.6f, y = %.6f\n", t, x, y);
             
-            fclose(datos_fase);
-            fclose(datos_x);
-            fclose(datos_y);
+            salida_cerrar(datos_fase);
+            salida_cerrar(datos_x);
+            salida_cerrar(datos_y);
             return EXIT_FAILURE;
         }
         
@@ -237,15 +811,29 @@ int main() {
         }
         
         // Guardar datos
-        fprintf(datos_fase, "%.6f %.6f\n", x, y);
-        fprintf(datos_x, "%.6f %.6f\n", t, x);
-        fprintf(datos_y, "%.6f %.6f\n", t, y);
+        SALIDA_FILA(datos_fase, x, y);
+        SALIDA_FILA(datos_x, t, x);
+        SALIDA_FILA(datos_y, t, y);
+        if (motor_grafico == MOTOR_SVG) {
+            grafico_punto(&grafico_fase, 0, x, y);
+            grafico_punto(&grafico_temporal, SERIE_X, t, x);
+            grafico_punto(&grafico_temporal, SERIE_Y, t, y);
+        }
+        estad_agregar(&desvios_energia, desvio_energia);
+        estad_agregar(&errores, error);
         
         // Ultimo punto
         if (t >= T_FINAL) break;
         
-        // Calcular siguiente punto
+        // Calcular siguiente punto (en el nivel PASO, un lote por paso)
+        double x_lote = x, y_lote = y;
+        validacion_abrir_lote();
         rk4_sistema2_validado(t, &x, &y, PASO_H, iter);
+        if (validacion_cerrar_lote("iteracion", iter)) {
+            x = x_lote; y = y_lote;
+            rk4_sistema2_validado(t, &x, &y, PASO_H, iter);
+            validacion_fin_repeticion();
+        }
         
         t += PASO_H;
         iter++;
@@ -261,51 +849,55 @@ int main() {
     printf("| INTEGRACION COMPLETADA: %d iteraciones                       |\n", iter);
     printf("+-------------------------------------------------------------+\n\n");
     
-    fclose(datos_fase);
-    fclose(datos_x);
-    fclose(datos_y);
+    salida_cerrar(datos_fase);
+    salida_cerrar(datos_x);
+    salida_cerrar(datos_y);
     
     // ============================================================================
-    // CREAR SCRIPTS GNUPLOT
+    // CREAR SCRIPTS GNUPLOT (con MOTOR_SVG los graficos se arman en memoria)
     // ============================================================================
-    
-    // Script 1: Evolucion temporal
-    fprintf(script_gp1, "# Script para evolucion temporal\n");
-    fprintf(script_gp1, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
-            ANCHO_GRAFICO, ALTO_GRAFICO);
-    fprintf(script_gp1, "set output '%s'\n", NOMBRE_GRAFICO1);
-    fprintf(script_gp1, "set title 'Evolucion temporal: dx/dt = y, dy/dt = -x'\n");
-    fprintf(script_gp1, "set xlabel 'Tiempo t'\n");
-    fprintf(script_gp1, "set ylabel 'x(t), y(t)'\n");
-    fprintf(script_gp1, "set grid\n");
-    fprintf(script_gp1, "set key top right box\n");
-    fprintf(script_gp1, "set xrange [%f:%f]\n", T_INICIAL, T_FINAL);
-    
-    fprintf(script_gp1, "plot 'sistema_x.dat' w l lw 2 lc rgb '#0066CC' title 'x(t)', \\\n");
-    fprintf(script_gp1, "     'sistema_y.dat' w l lw 2 lc rgb '#FF3333' title 'y(t)', \\\n");
-    fprintf(script_gp1, "     cos(x) w l lw 1 lc rgb '#0066CC' dt 2 title 'cos(t) (exacta)', \\\n");
-    fprintf(script_gp1, "     -sin(x) w l lw 1 lc rgb '#FF3333' dt 2 title '-sin(t) (exacta)'\n");
-    
-    fclose(script_gp1);
-    
-    // Script 2: Plano de fase
-    fprintf(script_gp2, "# Script para plano de fase\n");
-    fprintf(script_gp2, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
-            ANCHO_GRAFICO, ALTO_GRAFICO);
-    fprintf(script_gp2, "set output '%s'\n", NOMBRE_GRAFICO2);
-    fprintf(script_gp2, "set title 'Plano de fase: x vs y'\n");
-    fprintf(script_gp2, "set xlabel 'x(t)'\n");
-    fprintf(script_gp2, "set ylabel 'y(t)'\n");
-    fprintf(script_gp2, "set grid\n");
-    fprintf(script_gp2, "set key off\n");
-    fprintf(script_gp2, "set size ratio -1\n");
-    fprintf(script_gp2, "set xrange [-1.2:1.2]\n");
-    fprintf(script_gp2, "set yrange [-1.2:1.2]\n");
-    
-    fprintf(script_gp2, "plot 'sistema_fase.dat' w l lw 1.5 lc rgb '#00AA00' title 'Trayectoria', \\\n");
-    fprintf(script_gp2, "     cos(t), sin(t) w l lw 1 lc rgb '#000000' dt 2 title 'Circulo exacto'\n");
-    
-    fclose(script_gp2);
+    if (motor_grafico == MOTOR_GNUPLOT) {
+        // Script 1: Evolucion temporal
+        fprintf(script_gp1, "# Script para evolucion temporal\n");
+        fprintf(script_gp1, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
+                ANCHO_GRAFICO, ALTO_GRAFICO);
+        fprintf(script_gp1, "set output '%s'\n", NOMBRE_GRAFICO1);
+        fprintf(script_gp1, "set title 'Evolucion temporal: %s'\n", texto_sistema());
+        fprintf(script_gp1, "set xlabel 'Tiempo t'\n");
+        fprintf(script_gp1, "set ylabel 'x(t), y(t)'\n");
+        fprintf(script_gp1, "set grid\n");
+        fprintf(script_gp1, "set key top right box\n");
+        fprintf(script_gp1, "set xrange [%f:%f]\n", T_INICIAL, T_FINAL);
+        
+        fprintf(script_gp1, "plot %s w l lw 2 lc rgb '#0066CC' title 'x(t)', \\\n",
+                fuente_gnuplot("sistema_x.dat", FORMATO_SALIDA));
+        fprintf(script_gp1, "     %s w l lw 2 lc rgb '#FF3333' title 'y(t)', \\\n",
+                fuente_gnuplot("sistema_y.dat", FORMATO_SALIDA));
+        fprintf(script_gp1, "     cos(x) w l lw 1 lc rgb '#0066CC' dt 2 title 'cos(t) (exacta)', \\\n");
+        fprintf(script_gp1, "     -sin(x) w l lw 1 lc rgb '#FF3333' dt 2 title '-sin(t) (exacta)'\n");
+        
+        fclose(script_gp1);
+        
+        // Script 2: Plano de fase
+        fprintf(script_gp2, "# Script para plano de fase\n");
+        fprintf(script_gp2, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
+                ANCHO_GRAFICO, ALTO_GRAFICO);
+        fprintf(script_gp2, "set output '%s'\n", NOMBRE_GRAFICO2);
+        fprintf(script_gp2, "set title 'Plano de fase: x vs y'\n");
+        fprintf(script_gp2, "set xlabel 'x(t)'\n");
+        fprintf(script_gp2, "set ylabel 'y(t)'\n");
+        fprintf(script_gp2, "set grid\n");
+        fprintf(script_gp2, "set key off\n");
+        fprintf(script_gp2, "set size ratio -1\n");
+        fprintf(script_gp2, "set xrange [-1.2:1.2]\n");
+        fprintf(script_gp2, "set yrange [-1.2:1.2]\n");
+        
+        fprintf(script_gp2, "plot %s w l lw 1.5 lc rgb '#00AA00' title 'Trayectoria', \\\n",
+                fuente_gnuplot("sistema_fase.dat", FORMATO_SALIDA));
+        fprintf(script_gp2, "     cos(t), sin(t) w l lw 1 lc rgb '#000000' dt 2 title 'Circulo exacto'\n");
+        
+        fclose(script_gp2);
+    }
     
     // ============================================================================
     // EJECUTAR GNUPLOT
@@ -313,8 +905,13 @@ int main() {
     printf("GENERANDO GRAFICOS...\n");
     printf("-----------------------------------------------------------------\n");
     
-    int resultado1 = system("gnuplot sistema_temporal.gp 2>&1");
-    int resultado2 = system("gnuplot sistema_fase_plot.gp 2>&1");
+    int resultado1, resultado2;
+    if (motor_grafico == MOTOR_SVG) {
+        graficar_svg(&resultado1, &resultado2);
+    } else {
+        resultado1 = system("gnuplot sistema_temporal.gp 2>&1");
+        resultado2 = system("gnuplot sistema_fase_plot.gp 2>&1");
+    }
     
     if (resultado1 != 0 || resultado2 != 0) {
         printf("ADVERTENCIA: Problemas al generar graficos\n");
@@ -326,8 +923,9 @@ int main() {
         }
     } else {
         printf("Graficos generados correctamente:\n");
-        printf("   • %s (evolucion temporal)\n", NOMBRE_GRAFICO1);
-        printf("   • %s (plano de fase)\n", NOMBRE_GRAFICO2);
+        int svg = (motor_grafico == MOTOR_SVG);
+        printf("   • %s (evolucion temporal)\n", svg ? grafico_nombre_svg(NOMBRE_GRAFICO1) : NOMBRE_GRAFICO1);
+        printf("   • %s (plano de fase)\n", svg ? grafico_nombre_svg(NOMBRE_GRAFICO2) : NOMBRE_GRAFICO2);
     }
     
     // ============================================================================
@@ -354,8 +952,11 @@ int main() {
     printf("  Energia final:        %.8f\n", energia_final);
     printf("  Variacion energia:    %.2e (%.4f%%)\n", 
            variacion_energia, variacion_relativa);
+    printf("  Desvio energia max:   %.2e (RMS %.2e)\n",
+           estad_maximo(&desvios_energia), estad_rms(&desvios_energia));
     printf("  Error x final:        %.2e\n", error_x_final);
     printf("  Error y final:        %.2e\n", error_y_final);
+    printf("  Error |r| max / RMS:  %.2e / %.2e\n", estad_maximo(&errores), estad_rms(&errores));
     printf("  Ciclos completos:     %d\n", ciclos_completos);
     printf("  Fase final:           %.4f rad\n", fase_final);
     printf("  Errores numericos:    %d\n", errores_numericos);
@@ -393,20 +994,25 @@ int main() {
     printf("-----------------------------------------------------------------\n");
     
     // Verificar que satisface las ecuaciones
-    double dx_dt = F1(x, y);
-    double dy_dt = F2(x, y);
+    double dx_dt = EVAL_F1(x, y);
+    double dy_dt = EVAL_F2(x, y);
     
     printf("  En t = %.4f:\n", t);
     printf("    x calculado:       %.8f\n", x);
     printf("    y calculado:       %.8f\n", y);
     printf("    dx/dt calculado:   %.8f\n", dx_dt);
     printf("    dy/dt calculado:   %.8f\n", dy_dt);
-    printf("    dx/dt teorico:     y = %.8f\n", y);
-    printf("    dy/dt teorico:     -x = %.8f\n", -x);
     
-    // Verificar ortogonalidad (x·dx/dt + y·dy/dt = 0 para energia constante)
-    double producto = x*dx_dt + y*dy_dt;
-    printf("    x·dx/dt + y·dy/dt: %.2e (deberia ser ~0)\n", producto);
+    // Los valores teoricos y la ortogonalidad son del sistema de las macros
+    double producto = 0.0;
+    if (!expr_f1.activa && !expr_f2.activa) {
+        printf("    dx/dt teorico:     y = %.8f\n", y);
+        printf("    dy/dt teorico:     -x = %.8f\n", -x);
+        
+        // Verificar ortogonalidad (x·dx/dt + y·dy/dt = 0 para energia constante)
+        producto = x*dx_dt + y*dy_dt;
+        printf("    x·dx/dt + y·dy/dt: %.2e (deberia ser ~0)\n", producto);
+    }
     
     if (fabs(producto) > 0.01) {
         printf("  ADVERTENCIA: Producto escalar grande\n");
@@ -426,7 +1032,8 @@ int main() {
     printf("  Error maximo:        %.2e\n", error_maximo);
     printf("  Graficos generados:  %s\n", 
            (resultado1 == 0 && resultado2 == 0) ? "2/2" : "PARCIAL");
-    printf("  Archivos creados:    6 archivos de datos y scripts\n");
+    printf("  Archivos creados:    %s\n", (motor_grafico == MOTOR_SVG)
+           ? "3 archivos de datos y 2 graficos SVG" : "6 archivos de datos y scripts");
     
     printf("\n===============================================================\n");
     printf("                      EJECUCION COMPLETADA                     \n");
@@ -0,0 +1,75 @@
+// estadistica.h
+// Estadisticas en una sola pasada (conteo, media, RMS, extremos, ultimo valor)
+
+#ifndef ESTADISTICA_H
+#define ESTADISTICA_H
+
+#include <math.h>
+
+// ============================================================================
+// ACUMULADOR EN LINEA
+// ============================================================================
+// Se alimenta valor a valor desde el lazo que los produce, sin guardarlos ni
+// releer archivos. Las sumas usan compensacion de Neumaier (variante de Kahan
+// que tambien cubre sumandos mayores que el acumulado), asi la media y el RMS
+// de millones de pasos no pierden digitos por redondeo.
+// ============================================================================
+typedef struct {
+    long n;
+    double suma, compensacion;
+    double suma_cuad, compensacion_cuad;
+    double minimo, maximo;
+    double ultimo;
+} EstadisticaOnline;
+
+void estad_iniciar(EstadisticaOnline *e) {
+    e->n = 0;
+    e->suma = e->compensacion = 0.0;
+    e->suma_cuad = e->compensacion_cuad = 0.0;
+    e->minimo = INFINITY;
+    e->maximo = -INFINITY;
+    e->ultimo = NAN;
+}
+
+// Suma compensada: *suma + valor, acumulando el error de redondeo aparte
+void estad_sumar(double *suma, double *compensacion, double valor) {
+    double t = *suma + valor;
+    if (fabs(*suma) >= fabs(valor)) {
+        *compensacion += (*suma - t) + valor;
+    } else {
+        *compensacion += (valor - t) + *suma;
+    }
+    *suma = t;
+}
+
+void estad_agregar(EstadisticaOnline *e, double valor) {
+    e->n++;
+    estad_sumar(&e->suma, &e->compensacion, valor);
+    estad_sumar(&e->suma_cuad, &e->compensacion_cuad, valor * valor);
+    if (valor < e->minimo) e->minimo = valor;
+    if (valor > e->maximo) e->maximo = valor;
+    e->ultimo = valor;
+}
+
+double estad_media(const EstadisticaOnline *e) {
+    return (e->n > 0) ? (e->suma + e->compensacion) / e->n : 0.0;
+}
+
+double estad_rms(const EstadisticaOnline *e) {
+    return (e->n > 0) ? sqrt((e->suma_cuad + e->compensacion_cuad) / e->n) : 0.0;
+}
+
+// Extremos en 0 si no hubo valores, para imprimir sin infinitos
+double estad_maximo(const EstadisticaOnline *e) {
+    return (e->n > 0) ? e->maximo : 0.0;
+}
+
+double estad_minimo(const EstadisticaOnline *e) {
+    return (e->n > 0) ? e->minimo : 0.0;
+}
+
+double estad_ultimo(const EstadisticaOnline *e) {
+    return (e->n > 0) ? e->ultimo : 0.0;
+}
+
+#endif
@@ -0,0 +1,495 @@
+// expresion.h
+// Expresiones definidas en tiempo de ejecucion compiladas a bytecode de registros
+
+#ifndef EXPRESION_H
+#define EXPRESION_H
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// ============================================================================
+// LENGUAJE
+// ============================================================================
+// Numeros, variables (nombres dados al compilar), constantes pi y e,
+// operadores + - * / ^ (o **), parentesis y las funciones
+//   sin cos tan asin acos atan sinh cosh tanh exp log log10 sqrt abs floor
+//   pow(a,b) atan2(a,b) min(a,b) max(a,b)
+// Ejemplo: "x^3 - 2*x - 5", "min(x, 2*pi - x)", "x*x*sin(y) + exp(x*y)"
+//
+// Compilacion: arbol sintactico con plegado de constantes y simplificaciones
+// (x^2 -> x*x, x^0.5 -> sqrt, x*1, x+0), luego bytecode de 4 bytes por
+// instruccion sobre un banco de registros [variables | constantes | temporales]
+// con asignacion en pila de los temporales.
+// ============================================================================
+#define EXPR_MAX_NODOS      512
+#define EXPR_MAX_INSTR      256
+#define EXPR_MAX_REG        64
+#define EXPR_MAX_VARIABLES  8
+#define EXPR_LOTE           128     // Puntos por bloque en la evaluacion por lotes
+
+enum {
+    EXPR_NUM, EXPR_VAR,
+    EXPR_SUMA, EXPR_RESTA, EXPR_MULT, EXPR_DIV, EXPR_POT, EXPR_ATAN2, EXPR_MIN, EXPR_MAX,
+    EXPR_NEG, EXPR_CUAD, EXPR_SIN, EXPR_COS, EXPR_TAN, EXPR_ASIN, EXPR_ACOS, EXPR_ATAN,
+    EXPR_SINH, EXPR_COSH, EXPR_TANH, EXPR_EXP, EXPR_LOG, EXPR_LOG10, EXPR_SQRT, EXPR_ABS,
+    EXPR_FLOOR
+};
+
+typedef struct {
+    unsigned char op, dst, a, b;
+} InstrExpr;
+
+typedef struct {
+    int tipo;
+    double valor;           // EXPR_NUM
+    int variable;           // EXPR_VAR
+    int hijo[2];
+} NodoExpr;
+
+typedef struct {
+    int activa;             // 1 si se compilo una expresion
+    char texto[256];
+    int n_variables;
+    char variables[EXPR_MAX_VARIABLES][16];
+    int n_constantes;
+    double constantes[EXPR_MAX_REG];
+    int n_registros;
+    int n_instr;
+    InstrExpr codigo[EXPR_MAX_INSTR];
+    int resultado;          // Registro con el valor final
+    char error[128];
+} Expresion;
+
+typedef struct {
+    const char *p;
+    Expresion *e;
+    NodoExpr nodos[EXPR_MAX_NODOS];
+    int n_nodos;
+    int temporales, max_temporales;
+} CompiladorExpr;
+
+// ============================================================================
+// SEMANTICA DE LOS OPERADORES
+// ============================================================================
+double expr_aplicar(int op, double a, double b) {
+    switch (op) {
+        case EXPR_SUMA:  return a + b;
+        case EXPR_RESTA: return a - b;
+        case EXPR_MULT:  return a * b;
+        case EXPR_DIV:   return a / b;
+        case EXPR_POT:   return pow(a, b);
+        case EXPR_ATAN2: return atan2(a, b);
+        case EXPR_MIN:   return fmin(a, b);
+        case EXPR_MAX:   return fmax(a, b);
+        case EXPR_NEG:   return -a;
+        case EXPR_CUAD:  return a * a;
+        case EXPR_SIN:   return sin(a);
+        case EXPR_COS:   return cos(a);
+        case EXPR_TAN:   return tan(a);
+        case EXPR_ASIN:  return asin(a);
+        case EXPR_ACOS:  return acos(a);
+        case EXPR_ATAN:  return atan(a);
+        case EXPR_SINH:  return sinh(a);
+        case EXPR_COSH:  return cosh(a);
+        case EXPR_TANH:  return tanh(a);
+        case EXPR_EXP:   return exp(a);
+        case EXPR_LOG:   return log(a);
+        case EXPR_LOG10: return log10(a);
+        case EXPR_SQRT:  return sqrt(a);
+        case EXPR_ABS:   return fabs(a);
+        case EXPR_FLOOR: return floor(a);
+    }
+    return NAN;
+}
+
+int expr_es_binaria(int op) {
+    return op >= EXPR_SUMA && op <= EXPR_MAX;
+}
+
+// ============================================================================
+// ANALISIS SINTACTICO (descenso recursivo)
+// ============================================================================
+int expr_error(CompiladorExpr *c, const char *mensaje) {
+    if (c->e->error[0] == '\0') {
+        snprintf(c->e->error, sizeof(c->e->error), "%s (posicion %d)",
+                 mensaje, (int)(c->p - c->e->texto));
+    }
+    return -1;
+}
+
+int expr_nodo(CompiladorExpr *c, int tipo, double valor, int a, int b) {
+    int hoja = (tipo == EXPR_NUM || tipo == EXPR_VAR);
+    if (!hoja && (a < 0 || (expr_es_binaria(tipo) && b < 0))) return -1;
+    if (c->n_nodos >= EXPR_MAX_NODOS) return expr_error(c, "Expresion demasiado larga");
+
+    NodoExpr *na = (a >= 0) ? &c->nodos[a] : NULL;
+    NodoExpr *nb = (b >= 0) ? &c->nodos[b] : NULL;
+
+    // Plegado de constantes
+    if (!hoja && na->tipo == EXPR_NUM &&
+        (!expr_es_binaria(tipo) || nb->tipo == EXPR_NUM)) {
+        valor = expr_aplicar(tipo, na->valor, nb ? nb->valor : 0.0);
+        tipo = EXPR_NUM;
+        a = b = -1;
+    }
+
+    // Simplificaciones algebraicas
+    if (tipo == EXPR_MULT && nb->tipo == EXPR_NUM && nb->valor == 1.0) return a;
+    if (tipo == EXPR_MULT && na->tipo == EXPR_NUM && na->valor == 1.0) return b;
+    if ((tipo == EXPR_SUMA || tipo == EXPR_RESTA) && nb->tipo == EXPR_NUM && nb->valor == 0.0) return a;
+    if (tipo == EXPR_SUMA && na->tipo == EXPR_NUM && na->valor == 0.0) return b;
+    if (tipo == EXPR_DIV && nb->tipo == EXPR_NUM && nb->valor == 1.0) return a;
+    if (tipo == EXPR_POT && nb->tipo == EXPR_NUM) {
+        if (nb->valor == 1.0) return a;
+        if (nb->valor == 2.0) { tipo = EXPR_CUAD; b = -1; }
+        else if (nb->valor == 0.5) { tipo = EXPR_SQRT; b = -1; }
+    }
+
+    NodoExpr *n = &c->nodos[c->n_nodos];
+    n->tipo = tipo;
+    n->valor = valor;
+    n->variable = (tipo == EXPR_VAR) ? (int)valor : -1;
+    n->hijo[0] = a;
+    n->hijo[1] = b;
+    return c->n_nodos++;
+}
+
+void expr_espacios(CompiladorExpr *c) {
+    while (isspace((unsigned char)*c->p)) c->p++;
+}
+
+int expr_suma(CompiladorExpr *c);
+int expr_unario(CompiladorExpr *c);
+
+int expr_primario(CompiladorExpr *c) {
+    expr_espacios(c);
+
+    if (*c->p == '(') {
+        c->p++;
+        int n = expr_suma(c);
+        expr_espacios(c);
+        if (*c->p != ')') return expr_error(c, "Falta ')'");
+        c->p++;
+        return n;
+    }
+
+    if (isdigit((unsigned char)*c->p) || *c->p == '.') {
+        char *fin;
+        double valor = strtod(c->p, &fin);
+        if (fin == c->p) return expr_error(c, "Numero invalido");
+        c->p = fin;
+        return expr_nodo(c, EXPR_NUM, valor, -1, -1);
+    }
+
+    if (!isalpha((unsigned char)*c->p) && *c->p != '_') {
+        return expr_error(c, "Se esperaba un numero, variable o funcion");
+    }
+
+    char nombre[32];
+    int largo = 0;
+    while ((isalnum((unsigned char)*c->p) || *c->p == '_') && largo < 31) {
+        nombre[largo++] = *c->p++;
+    }
+    nombre[largo] = '\0';
+
+    for (int v = 0; v < c->e->n_variables; v++) {
+        if (strcmp(nombre, c->e->variables[v]) == 0) {
+            return expr_nodo(c, EXPR_VAR, v, -1, -1);
+        }
+    }
+    if (strcmp(nombre, "pi") == 0) return expr_nodo(c, EXPR_NUM, M_PI, -1, -1);
+    if (strcmp(nombre, "e") == 0) return expr_nodo(c, EXPR_NUM, M_E, -1, -1);
+
+    static const struct { const char *nombre; int op; } funciones[] = {
+        {"sin", EXPR_SIN}, {"cos", EXPR_COS}, {"tan", EXPR_TAN}, {"asin", EXPR_ASIN},
+        {"acos", EXPR_ACOS}, {"atan", EXPR_ATAN}, {"sinh", EXPR_SINH}, {"cosh", EXPR_COSH},
+        {"tanh", EXPR_TANH}, {"exp", EXPR_EXP}, {"log", EXPR_LOG}, {"log10", EXPR_LOG10},
+        {"sqrt", EXPR_SQRT}, {"abs", EXPR_ABS}, {"fabs", EXPR_ABS}, {"floor", EXPR_FLOOR},
+        {"pow", EXPR_POT}, {"atan2", EXPR_ATAN2}, {"min", EXPR_MIN}, {"max", EXPR_MAX}
+    };
+
+    for (size_t f = 0; f < sizeof(funciones) / sizeof(funciones[0]); f++) {
+        if (strcmp(nombre, funciones[f].nombre) != 0) continue;
+
+        expr_espacios(c);
+        if (*c->p != '(') return expr_error(c, "Falta '(' tras la funcion");
+        c->p++;
+
+        int a = expr_suma(c), b = -1;
+        expr_espacios(c);
+        if (expr_es_binaria(funciones[f].op)) {
+            if (*c->p != ',') return expr_error(c, "La funcion requiere dos argumentos");
+            c->p++;
+            b = expr_suma(c);
+            expr_espacios(c);
+        }
+        if (*c->p != ')') return expr_error(c, "Falta ')'");
+        c->p++;
+        return expr_nodo(c, funciones[f].op, 0.0, a, b);
+    }
+
+    return expr_error(c, "Identificador desconocido");
+}
+
+int expr_potencia(CompiladorExpr *c) {
+    int base = expr_primario(c);
+    expr_espacios(c);
+
+    if (*c->p == '^' || (c->p[0] == '*' && c->p[1] == '*')) {
+        c->p += (*c->p == '^') ? 1 : 2;
+        int exponente = expr_unario(c);     // Asociativa a derecha
+        return expr_nodo(c, EXPR_POT, 0.0, base, exponente);
+    }
+    return base;
+}
+
+int expr_unario(CompiladorExpr *c) {
+    expr_espacios(c);
+    if (*c->p == '-') {
+        c->p++;
+        return expr_nodo(c, EXPR_NEG, 0.0, expr_unario(c), -1);
+    }
+    if (*c->p == '+') {
+        c->p++;
+        return expr_unario(c);
+    }
+    return expr_potencia(c);
+}
+
+int expr_producto(CompiladorExpr *c) {
+    int n = expr_unario(c);
+    while (n >= 0) {
+        expr_espacios(c);
+        if (*c->p == '*' && c->p[1] != '*') {
+            c->p++;
+            n = expr_nodo(c, EXPR_MULT, 0.0, n, expr_unario(c));
+        } else if (*c->p == '/') {
+            c->p++;
+            n = expr_nodo(c, EXPR_DIV, 0.0, n, expr_unario(c));
+        } else {
+            break;
+        }
+    }
+    return n;
+}
+
+int expr_suma(CompiladorExpr *c) {
+    int n = expr_producto(c);
+    while (n >= 0) {
+        expr_espacios(c);
+        if (*c->p == '+') {
+            c->p++;
+            n = expr_nodo(c, EXPR_SUMA, 0.0, n, expr_producto(c));
+        } else if (*c->p == '-') {
+            c->p++;
+            n = expr_nodo(c, EXPR_RESTA, 0.0, n, expr_producto(c));
+        } else {
+            break;
+        }
+    }
+    return n;
+}
+
+// ============================================================================
+// GENERACION DE BYTECODE
+// ============================================================================
+void expr_recolectar_constantes(CompiladorExpr *c, int n) {
+    NodoExpr *nodo = &c->nodos[n];
+    if (nodo->tipo == EXPR_NUM) {
+        for (int k = 0; k < c->e->n_constantes; k++) {
+            if (c->e->constantes[k] == nodo->valor) return;
+        }
+        if (c->e->n_constantes < EXPR_MAX_REG) {
+            c->e->constantes[c->e->n_constantes++] = nodo->valor;
+        }
+        return;
+    }
+    for (int h = 0; h < 2; h++) {
+        if (nodo->hijo[h] >= 0) expr_recolectar_constantes(c, nodo->hijo[h]);
+    }
+}
+
+int expr_generar(CompiladorExpr *c, int n) {
+    Expresion *e = c->e;
+    NodoExpr *nodo = &c->nodos[n];
+    int base_temporales = e->n_variables + e->n_constantes;
+
+    if (nodo->tipo == EXPR_VAR) return nodo->variable;
+    if (nodo->tipo == EXPR_NUM) {
+        for (int k = 0; k < e->n_constantes; k++) {
+            if (e->constantes[k] == nodo->valor) return e->n_variables + k;
+        }
+        return expr_error(c, "Demasiadas constantes");
+    }
+
+    int a = expr_generar(c, nodo->hijo[0]);
+    int b = (nodo->hijo[1] >= 0) ? expr_generar(c, nodo->hijo[1]) : 0;
+    if (a < 0 || b < 0) return -1;
+
+    // Los temporales se usan en pila: liberar los de los operandos y
+    // reutilizar el primero para el resultado
+    if (b >= base_temporales && nodo->hijo[1] >= 0) c->temporales--;
+    if (a >= base_temporales) c->temporales--;
+
+    int destino = base_temporales + c->temporales++;
+    if (c->temporales > c->max_temporales) c->max_temporales = c->temporales;
+
+    if (destino >= EXPR_MAX_REG) return expr_error(c, "Expresion demasiado anidada");
+    if (e->n_instr >= EXPR_MAX_INSTR) return expr_error(c, "Demasiadas instrucciones");
+
+    InstrExpr *in = &e->codigo[e->n_instr++];
+    in->op = nodo->tipo;
+    in->dst = destino;
+    in->a = a;
+    in->b = b;
+    return destino;
+}
+
+// variables: nombres separados por espacios, en el orden en que se pasaran
+// al evaluar ("x y"). Devuelve 0 si compila, -1 con el motivo en e->error.
+int expr_compilar(Expresion *e, const char *texto, const char *variables) {
+    static CompiladorExpr c;    // ~16 KB: fuera de la pila
+
+    memset(e, 0, sizeof(*e));
+    memset(&c, 0, sizeof(c));
+    snprintf(e->texto, sizeof(e->texto), "%s", texto);
+
+    char copia[128];
+    snprintf(copia, sizeof(copia), "%s", variables);
+    for (char *tok = strtok(copia, " "); tok != NULL; tok = strtok(NULL, " ")) {
+        if (e->n_variables >= EXPR_MAX_VARIABLES) {
+            snprintf(e->error, sizeof(e->error), "Demasiadas variables");
+            return -1;
+        }
+        snprintf(e->variables[e->n_variables++], 16, "%s", tok);
+    }
+
+    c.e = e;
+    c.p = e->texto;
+
+    int raiz = expr_suma(&c);
+    expr_espacios(&c);
+    if (raiz >= 0 && *c.p != '\0') raiz = expr_error(&c, "Texto sobrante");
+    if (raiz < 0) return -1;
+
+    expr_recolectar_constantes(&c, raiz);
+    e->resultado = expr_generar(&c, raiz);
+    if (e->resultado < 0) return -1;
+
+    e->n_registros = e->n_variables + e->n_constantes + c.max_temporales;
+    e->activa = 1;
+    return 0;
+}
+
+// ============================================================================
+// EVALUACION
+// ============================================================================
+double expr_evaluar(const Expresion *e, const double *vars) {
+    double r[EXPR_MAX_REG];
+    int nv = e->n_variables;
+
+    for (int v = 0; v < nv; v++) r[v] = vars[v];
+    for (int k = 0; k < e->n_constantes; k++) r[nv + k] = e->constantes[k];
+
+    for (int i = 0; i < e->n_instr; i++) {
+        const InstrExpr *in = &e->codigo[i];
+        double a = r[in->a], b = r[in->b], v;
+
+        switch (in->op) {
+            case EXPR_SUMA:  v = a + b; break;
+            case EXPR_RESTA: v = a - b; break;
+            case EXPR_MULT:  v = a * b; break;
+            case EXPR_DIV:   v = a / b; break;
+            case EXPR_NEG:   v = -a; break;
+            case EXPR_CUAD:  v = a * a; break;
+            default:         v = expr_aplicar(in->op, a, b); break;
+        }
+        r[in->dst] = v;
+    }
+    return r[e->resultado];
+}
+
+double expr_evaluar_1(const Expresion *e, double x) {
+    return expr_evaluar(e, &x);
+}
+
+double expr_evaluar_2(const Expresion *e, double x, double y) {
+    double v[2] = {x, y};
+    return expr_evaluar(e, v);
+}
+
+double expr_evaluar_3(const Expresion *e, double x, double y, double z) {
+    double v[3] = {x, y, z};
+    return expr_evaluar(e, v);
+}
+
+// Evalua sobre n puntos: vars[k][i] es la variable k del punto i. Las
+// instrucciones se recorren una vez por bloque de EXPR_LOTE puntos y cada una
+// se aplica en un lazo vectorizable, asi el costo de interpretar se reparte.
+void expr_evaluar_lote(const Expresion *e, const double *const *vars, double *salida, int n) {
+    double r[EXPR_MAX_REG][EXPR_LOTE];
+    int nv = e->n_variables;
+
+    for (int i0 = 0; i0 < n; i0 += EXPR_LOTE) {
+        int m = (n - i0 < EXPR_LOTE) ? n - i0 : EXPR_LOTE;
+
+        for (int v = 0; v < nv; v++) {
+            memcpy(r[v], vars[v] + i0, m * sizeof(double));
+        }
+        for (int k = 0; k < e->n_constantes; k++) {
+            for (int j = 0; j < m; j++) r[nv + k][j] = e->constantes[k];
+        }
+
+        for (int i = 0; i < e->n_instr; i++) {
+            const InstrExpr *in = &e->codigo[i];
+            double *d = r[in->dst];
+            const double *a = r[in->a], *b = r[in->b];
+
+            switch (in->op) {
+                case EXPR_SUMA:  for (int j = 0; j < m; j++) d[j] = a[j] + b[j]; break;
+                case EXPR_RESTA: for (int j = 0; j < m; j++) d[j] = a[j] - b[j]; break;
+                case EXPR_MULT:  for (int j = 0; j < m; j++) d[j] = a[j] * b[j]; break;
+                case EXPR_DIV:   for (int j = 0; j < m; j++) d[j] = a[j] / b[j]; break;
+                case EXPR_NEG:   for (int j = 0; j < m; j++) d[j] = -a[j]; break;
+                case EXPR_CUAD:  for (int j = 0; j < m; j++) d[j] = a[j] * a[j]; break;
+                case EXPR_SIN:   for (int j = 0; j < m; j++) d[j] = sin(a[j]); break;
+                case EXPR_COS:   for (int j = 0; j < m; j++) d[j] = cos(a[j]); break;
+                case EXPR_EXP:   for (int j = 0; j < m; j++) d[j] = exp(a[j]); break;
+                default:
+                    for (int j = 0; j < m; j++) d[j] = expr_aplicar(in->op, a[j], b[j]);
+                    break;
+            }
+        }
+
+        memcpy(salida + i0, r[e->resultado], m * sizeof(double));
+    }
+}
+
+// ============================================================================
+// CARGA DESDE EL ENTORNO
+// ============================================================================
+// Si existe la variable de entorno 'nombre' (p. ej. FUNCION="x^3 - 2*x - 5")
+// compila su texto y devuelve 1; si no existe deja e->activa = 0 y devuelve 0.
+// Una expresion invalida detiene el programa, igual que un parametro invalido.
+int expr_desde_entorno(Expresion *e, const char *nombre, const char *variables) {
+    const char *texto = getenv(nombre);
+    if (texto == NULL || texto[0] == '\0') {
+        e->activa = 0;
+        return 0;
+    }
+
+    if (expr_compilar(e, texto, variables) != 0) {
+        printf("ERROR: Expresion invalida en %s = \"%s\"\n", nombre, texto);
+        printf("   %s\n", e->error);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("Usando %s(%s) = %s  [%d instrucciones, %d registros]\n",
+           nombre, variables, e->texto, e->n_instr, e->n_registros);
+    return 1;
+}
+
+#endif
@@ -5,6 +5,12 @@
 #include <math.h>
 #include <stdlib.h>
 #include <errno.h>
+#include "nucleo.h"
+#include "datos_columnar.h"
+#include "expresion.h"
+#include "benchmark.h"
+#include "estadistica.h"
+#include "grafico.h"
 
 // ============================================================================
 // PARAMETROS CONFIGURABLES
@@ -12,48 +18,40 @@
 #define FUNCION_ORIGINAL(x) ((x) < L ? (x) : (2*L - (x)))
 #define L                   M_PI
 #define N_TERMINOS          10
+#define PUNTOS_INTEGRACION  1000
+#define MODO_COEFICIENTES   COEF_CUADRATURA  // COEF_CUADRATURA o COEF_FFT
+#define MODO_SINTESIS       SINTESIS_RECURRENCIA  // SINTESIS_DIRECTA o SINTESIS_RECURRENCIA
 #define PUNTOS_GRAFICO      500
+#define FORMATO_SALIDA      FORMATO_TEXTO    // FORMATO_TEXTO o FORMATO_BINARIO
+#define NIVEL_VALIDACION    VALIDACION_OPERACION  // _OPERACION, _PASO o _NINGUNA (o entorno VALIDACION)
 #define GRAFICO_INICIO      0.0
 #define GRAFICO_FIN         2*M_PI
-#define NOMBRE_GRAFICO      "fourier_grafico.png"
+#define MOTOR_GRAFICO       MOTOR_GNUPLOT    // MOTOR_GNUPLOT o MOTOR_SVG (o entorno GRAFICO)
+#define NOMBRE_GRAFICO      "fourier_grafico.png" // Con MOTOR_SVG: fourier_grafico.svg
 #define ANCHO_GRAFICO       800
 #define ALTO_GRAFICO        600
 // ============================================================================
 
-// ============================================================================
-// FUNCIONES DE VALIDACION
-// ============================================================================
-int es_numerico_valido(double valor) {
-    return !(isnan(valor) || isinf(valor) || fabs(valor) > 1e100);
-}
+#define COEF_CUADRATURA     0   // Suma directa con cos/sin por termino (referencia)
+#define COEF_FFT            1   // FFT real de una sola muestra de la funcion
 
-void verificar_nan_inf(const char *nombre, double valor, int linea) {
-    if (isnan(valor)) {
-        printf("ERROR en linea %d: %s = NaN\n", linea, nombre);
-        exit(EXIT_FAILURE);
-    }
-    if (isinf(valor)) {
-        printf("ERROR en linea %d: %s = Infinito\n", linea, nombre);
-        exit(EXIT_FAILURE);
-    }
-}
+#define SINTESIS_DIRECTA     0  // cos/sin por termino (referencia)
+#define SINTESIS_RECURRENCIA 1  // Un par sin/cos por punto + suma de angulos
 
-#define VALIDAR(variable) verificar_nan_inf(#variable, variable, __LINE__)
+// Funcion definida en tiempo de ejecucion: la variable de entorno
+// FUNCION_ORIGINAL reemplaza a la macro, p. ej. FUNCION_ORIGINAL="min(x, 2*pi - x)"
+Expresion expr_original;
 
-FILE* abrir_archivo(const char *nombre, const char *modo) {
-    FILE *archivo = fopen(nombre, modo);
-    if (archivo == NULL) {
-        printf("ERROR: No se pudo abrir '%s'\n", nombre);
-        exit(EXIT_FAILURE);
-    }
-    return archivo;
-}
+#define EVAL_ORIGINAL(x)    (expr_original.activa ? expr_evaluar_1(&expr_original, (x)) : FUNCION_ORIGINAL(x))
 
 // ============================================================================
 // VALIDACION DE PARAMETROS
 // ============================================================================
 void validar_parametros() {
     printf("Validando parametros...\n");
+    validacion_iniciar(NIVEL_VALIDACION);
+    grafico_iniciar_motor(MOTOR_GRAFICO);
+    expr_desde_entorno(&expr_original, "FUNCION_ORIGINAL", "x");
     
     if (L <= 0) {
         printf("ERROR: L debe ser positivo (L = %f)\n", L);
@@ -65,6 +63,21 @@ void validar_parametros() {
         exit(EXIT_FAILURE);
     }
     
+    if (PUNTOS_INTEGRACION < 2) {
+        printf("ERROR: PUNTOS_INTEGRACION debe ser >= 2 (%d)\n", PUNTOS_INTEGRACION);
+        exit(EXIT_FAILURE);
+    }
+    
+    if (MODO_COEFICIENTES != COEF_CUADRATURA && MODO_COEFICIENTES != COEF_FFT) {
+        printf("ERROR: MODO_COEFICIENTES desconocido (%d)\n", MODO_COEFICIENTES);
+        exit(EXIT_FAILURE);
+    }
+    
+    if (MODO_SINTESIS != SINTESIS_DIRECTA && MODO_SINTESIS != SINTESIS_RECURRENCIA) {
+        printf("ERROR: MODO_SINTESIS desconocido (%d)\n", MODO_SINTESIS);
+        exit(EXIT_FAILURE);
+    }
+    
     if (PUNTOS_GRAFICO < 10) {
         printf("ERROR: PUNTOS_GRAFICO debe ser >= 10 (%d)\n", PUNTOS_GRAFICO);
         exit(EXIT_FAILURE);
@@ -78,7 +91,7 @@ void validar_parametros() {
     // Validar funcion en algunos puntos
     for (int i = 0; i < 5; i++) {
         double x = GRAFICO_INICIO + i * (GRAFICO_FIN - GRAFICO_INICIO) / 4;
-        double fx = FUNCION_ORIGINAL(x);
+        double fx = EVAL_ORIGINAL(x);
         VALIDAR(fx);
         
         if (!es_numerico_valido(fx)) {
@@ -90,18 +103,421 @@ void validar_parametros() {
     printf("Parametros validados correctamente\n\n");
 }
 
+// ============================================================================
+// CALCULO DE COEFICIENTES
+// ============================================================================
+// Sumas de f*cos y f*sin del termino n. Con VALIDAR inactivo el lazo no tiene
+// llamadas ni salidas tempranas y el overflow se revisa una vez al final.
+int sumas_cuadratura(int n, int puntos, double dx_int, double *suma_an, double *suma_bn) {
+    double sa = 0.0, sb = 0.0;
+    
+    for (int i = 0; i < puntos; i++) {
+        double x = i * dx_int;
+        double f = EVAL_ORIGINAL(x);
+        VALIDAR(f);
+        
+        double cos_val = cos(n * M_PI * x / L);
+        double sin_val = sin(n * M_PI * x / L);
+        VALIDAR(cos_val); VALIDAR(sin_val);
+        
+        sa += f * cos_val;
+        sb += f * sin_val;
+        
+        VALIDAR(sa); VALIDAR(sb);
+        
+        // Detectar overflow en cuanto ocurre (solo en validacion por operacion)
+        if (validar_operaciones && (fabs(sa) > 1e50 || fabs(sb) > 1e50)) break;
+    }
+    
+    *suma_an = sa;
+    *suma_bn = sb;
+    if (fabs(sa) > 1e50 || fabs(sb) > 1e50) {
+        printf("ERROR: Overflow en calculo de coeficientes n=%d\n", n);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// Cuadratura directa sobre [0, 2L): cuesta n_terminos x puntos llamadas a
+// cos/sin. Se conserva como referencia del modo FFT.
+int coeficientes_cuadratura(int puntos, int n_terminos, double *a0, double *an, double *bn) {
+    double dx_int = 2*L / puntos;
+    VALIDAR(dx_int);
+    
+    if (dx_int <= 0) {
+        printf("ERROR: dx_int no valido: %f\n", dx_int);
+        return EXIT_FAILURE;
+    }
+    
+    // Calcular a0
+    double suma_a0 = 0.0;
+    for (int i = 0; i < puntos; i++) {
+        double x = i * dx_int;
+        double f = EVAL_ORIGINAL(x);
+        VALIDAR(f);
+        
+        if (!es_numerico_valido(f)) {
+            printf("ERROR: Funcion invalida en x = %f, f(x) = %f\n", x, f);
+            return EXIT_FAILURE;
+        }
+        
+        suma_a0 += f;
+        VALIDAR(suma_a0);
+    }
+    *a0 = suma_a0 * dx_int / L;
+    VALIDAR(*a0);
+    
+    // Calcular coeficientes an y bn: en el nivel PASO cada termino es un lote
+    for (int n = 1; n <= n_terminos; n++) {
+        double suma_an, suma_bn;
+        
+        validacion_abrir_lote();
+        int estado = sumas_cuadratura(n, puntos, dx_int, &suma_an, &suma_bn);
+        if (validacion_cerrar_lote("termino", n)) {
+            estado = sumas_cuadratura(n, puntos, dx_int, &suma_an, &suma_bn);
+            validacion_fin_repeticion();
+        }
+        if (estado != EXIT_SUCCESS) return EXIT_FAILURE;
+        
+        an[n] = suma_an * dx_int / L;
+        bn[n] = suma_bn * dx_int / L;
+        
+        VALIDAR(an[n]); VALIDAR(bn[n]);
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+int siguiente_potencia_2(int n) {
+    int p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// FFT compleja radix-2 in situ (Cooley-Tukey iterativa). m es potencia de 2 y
+// tw[k] = exp(-2*pi*i*k/(m*paso_tw)) con k < m*paso_tw/2.
+void fft_compleja(double *re, double *im, int m, const double *tw_re, const double *tw_im, int paso_tw) {
+    // Reordenamiento por inversion de bits
+    for (int i = 1, j = 0; i < m; i++) {
+        int bit = m >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        
+        if (i < j) {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    
+    // Mariposas
+    for (int len = 2; len <= m; len <<= 1) {
+        int mitad = len >> 1;
+        int salto = (m / len) * paso_tw;
+        
+        for (int i = 0; i < m; i += len) {
+            for (int k = 0; k < mitad; k++) {
+                double wr = tw_re[k * salto], wi = tw_im[k * salto];
+                int a = i + k, b = i + k + mitad;
+                
+                double tr = re[b]*wr - im[b]*wi;
+                double ti = re[b]*wi + im[b]*wr;
+                
+                re[b] = re[a] - tr; im[b] = im[a] - ti;
+                re[a] += tr;        im[a] += ti;
+            }
+        }
+    }
+}
+
+// Coeficientes via FFT real de m muestras (m potencia de 2, m > 2*n_terminos).
+// Con x_i = i*2L/m se cumple an = (2/m) Re X[n] y bn = -(2/m) Im X[n], es
+// decir, el mismo resultado que la cuadratura con m puntos en O(m log m).
+int coeficientes_fft(int m, int n_terminos, double *a0, double *an, double *bn) {
+    if (m < 4 || (m & (m - 1)) != 0 || n_terminos >= m/2) {
+        printf("ERROR: Tamaño FFT invalido (M = %d, N = %d)\n", m, n_terminos);
+        return EXIT_FAILURE;
+    }
+    
+    int mitad = m / 2;
+    double *re = malloc(mitad * sizeof(double));
+    double *im = malloc(mitad * sizeof(double));
+    double *tw_re = malloc(mitad * sizeof(double));
+    double *tw_im = malloc(mitad * sizeof(double));
+    
+    if (re == NULL || im == NULL || tw_re == NULL || tw_im == NULL) {
+        printf("ERROR: Memoria insuficiente para FFT de %d puntos\n", m);
+        free(re); free(im); free(tw_re); free(tw_im);
+        return EXIT_FAILURE;
+    }
+    
+    // Muestreo unico: pares en la parte real, impares en la imaginaria
+    double dx_int = 2*L / m;
+    for (int i = 0; i < m; i++) {
+        double x = i * dx_int;
+        double f = EVAL_ORIGINAL(x);
+        
+        if (!es_numerico_valido(f)) {
+            printf("ERROR: Funcion invalida en x = %f, f(x) = %f\n", x, f);
+            free(re); free(im); free(tw_re); free(tw_im);
+            return EXIT_FAILURE;
+        }
+        
+        if (i % 2 == 0) re[i/2] = f;
+        else            im[i/2] = f;
+    }
+    
+    for (int k = 0; k < mitad; k++) {
+        tw_re[k] = cos(2*M_PI*k / m);
+        tw_im[k] = -sin(2*M_PI*k / m);
+    }
+    
+    fft_compleja(re, im, mitad, tw_re, tw_im, 2);
+    
+    // Separar el espectro de la señal real: X[k] = E[k] + W^k O[k]
+    double escala = 2.0 / m;
+    for (int k = 0; k <= n_terminos; k++) {
+        int j = (mitad - k) % mitad;
+        double e_re = (re[k] + re[j]) / 2, e_im = (im[k] - im[j]) / 2;
+        double o_re = (im[k] + im[j]) / 2, o_im = -(re[k] - re[j]) / 2;
+        
+        double x_re = e_re + tw_re[k]*o_re - tw_im[k]*o_im;
+        double x_im = e_im + tw_re[k]*o_im + tw_im[k]*o_re;
+        
+        if (k == 0) {
+            *a0 = escala * x_re;
+            VALIDAR(*a0);
+        } else {
+            an[k] = escala * x_re;
+            bn[k] = -escala * x_im;
+            VALIDAR(an[k]); VALIDAR(bn[k]);
+        }
+    }
+    
+    free(re); free(im); free(tw_re); free(tw_im);
+    return EXIT_SUCCESS;
+}
+
+// ============================================================================
+// SINTESIS DE LA SERIE
+// ============================================================================
+#define BLOQUE_SINTESIS     64
+
+// Suma parcial directa: 2*n_terminos llamadas a cos/sin por punto (referencia)
+double sintesis_directa(double x, double a0, const double *an, const double *bn, int n_terminos) {
+    double f = a0 / 2;
+    for (int n = 1; n <= n_terminos; n++) {
+        f += an[n] * cos(n * M_PI * x / L) + bn[n] * sin(n * M_PI * x / L);
+    }
+    return f;
+}
+
+// Suma parcial por recurrencia de suma de angulos con un solo par sin/cos por
+// punto. cos/sin(n*theta) se obtienen rotando por theta dentro de bloques de
+// K ~ sqrt(N) terminos; cada bloque arranca de una semilla que avanza rotando
+// por K*theta y se renormaliza, asi la deriva crece como (K + N/K)*eps en vez
+// de N*eps. Los puntos se procesan en bloques para que el lazo interno sobre
+// puntos sea vectorizable.
+void sintesis_recurrencia(const double *x, double *salida, int n_puntos,
+                          double a0, const double *an, const double *bn, int n_terminos) {
+    int k_bloque = (int)sqrt((double)n_terminos);
+    if (k_bloque < 1) k_bloque = 1;
+    
+    for (int p0 = 0; p0 < n_puntos; p0 += BLOQUE_SINTESIS) {
+        int np = n_puntos - p0 < BLOQUE_SINTESIS ? n_puntos - p0 : BLOQUE_SINTESIS;
+        double c1[BLOQUE_SINTESIS], s1[BLOQUE_SINTESIS];
+        double ck[BLOQUE_SINTESIS], sk[BLOQUE_SINTESIS];
+        double c0[BLOQUE_SINTESIS], s0[BLOQUE_SINTESIS];
+        double c[BLOQUE_SINTESIS], s[BLOQUE_SINTESIS];
+        double suma[BLOQUE_SINTESIS];
+        
+        for (int p = 0; p < np; p++) {
+            double theta = M_PI * x[p0 + p] / L;
+            c1[p] = cos(theta);
+            s1[p] = sin(theta);
+            
+            // Rotacion por K*theta mediante cuadrados sucesivos
+            double rc = 1.0, rs = 0.0, bc = c1[p], bs = s1[p];
+            for (int e = k_bloque; e > 0; e >>= 1) {
+                if (e & 1) {
+                    double t = rc*bc - rs*bs;
+                    rs = rs*bc + rc*bs;
+                    rc = t;
+                }
+                double t = bc*bc - bs*bs;
+                bs = 2*bc*bs;
+                bc = t;
+            }
+            ck[p] = rc; sk[p] = rs;
+            
+            c0[p] = c[p] = 1.0;
+            s0[p] = s[p] = 0.0;
+            suma[p] = a0 / 2;
+        }
+        
+        for (int n0 = 0; n0 < n_terminos; n0 += k_bloque) {
+            int n_fin = n0 + k_bloque < n_terminos ? n0 + k_bloque : n_terminos;
+            
+            for (int n = n0 + 1; n <= n_fin; n++) {
+                double a = an[n], b = bn[n];
+                for (int p = 0; p < np; p++) {
+                    double t = c[p]*c1[p] - s[p]*s1[p];
+                    s[p] = s[p]*c1[p] + c[p]*s1[p];
+                    c[p] = t;
+                    suma[p] += a*c[p] + b*s[p];
+                }
+            }
+            
+            // Reiniciar desde la semilla del siguiente bloque
+            for (int p = 0; p < np; p++) {
+                double t = c0[p]*ck[p] - s0[p]*sk[p];
+                s0[p] = s0[p]*ck[p] + c0[p]*sk[p];
+                c0[p] = t;
+                
+                double norma = 1.0 / sqrt(c0[p]*c0[p] + s0[p]*s0[p]);
+                c0[p] *= norma; s0[p] *= norma;
+                c[p] = c0[p];   s[p] = s0[p];
+            }
+        }
+        
+        for (int p = 0; p < np; p++) {
+            salida[p0 + p] = suma[p];
+        }
+    }
+}
+
+// Evalua la serie en un vector de puntos segun MODO_SINTESIS
+void sintetizar_serie(const double *x, double *salida, int n_puntos,
+                      double a0, const double *an, const double *bn, int n_terminos) {
+    if (MODO_SINTESIS == SINTESIS_RECURRENCIA) {
+        sintesis_recurrencia(x, salida, n_puntos, a0, an, bn, n_terminos);
+    } else {
+        for (int i = 0; i < n_puntos; i++) {
+            salida[i] = sintesis_directa(x[i], a0, an, bn, n_terminos);
+        }
+    }
+}
+
+// ============================================================================
+// MICRO-BENCHMARKS (BENCHMARK=1 ./fourier)
+// ============================================================================
+// Coeficientes: una llamada = el juego completo de N_TERMINOS coeficientes.
+// Sintesis: una unidad = un punto de la serie parcial con N_TERMINOS terminos.
+typedef struct {
+    int puntos_fft;
+    double a0, *an, *bn;
+    double x[PUNTOS_GRAFICO], salida[PUNTOS_GRAFICO];
+} ContextoFourier;
+
+ConteoBench bench_cuadratura(void *contexto, long llamadas) {
+    ContextoFourier *c = contexto;
+    for (long i = 0; i < llamadas; i++) {
+        coeficientes_cuadratura(PUNTOS_INTEGRACION, N_TERMINOS, &c->a0, c->an, c->bn);
+    }
+    bench_sumidero += c->an[1];
+    return (ConteoBench){ llamadas, (double)PUNTOS_INTEGRACION * (N_TERMINOS + 1) * llamadas };
+}
+
+ConteoBench bench_fft(void *contexto, long llamadas) {
+    ContextoFourier *c = contexto;
+    for (long i = 0; i < llamadas; i++) {
+        coeficientes_fft(c->puntos_fft, N_TERMINOS, &c->a0, c->an, c->bn);
+    }
+    bench_sumidero += c->an[1];
+    return (ConteoBench){ llamadas, (double)c->puntos_fft * llamadas };
+}
+
+ConteoBench bench_sintesis_directa(void *contexto, long llamadas) {
+    ContextoFourier *c = contexto;
+    for (long i = 0; i < llamadas; i++) {
+        for (int p = 0; p < PUNTOS_GRAFICO; p++) {
+            c->salida[p] = sintesis_directa(c->x[p], c->a0, c->an, c->bn, N_TERMINOS);
+        }
+    }
+    bench_sumidero += c->salida[0];
+    return (ConteoBench){ (double)PUNTOS_GRAFICO * llamadas, 0 };
+}
+
+ConteoBench bench_sintesis_recurrencia(void *contexto, long llamadas) {
+    ContextoFourier *c = contexto;
+    for (long i = 0; i < llamadas; i++) {
+        sintesis_recurrencia(c->x, c->salida, PUNTOS_GRAFICO, c->a0, c->an, c->bn, N_TERMINOS);
+    }
+    bench_sumidero += c->salida[0];
+    return (ConteoBench){ (double)PUNTOS_GRAFICO * llamadas, 0 };
+}
+
+int ejecutar_benchmark() {
+    static ContextoFourier c;
+    int minimo = PUNTOS_INTEGRACION > 2*N_TERMINOS + 2 ? PUNTOS_INTEGRACION : 2*N_TERMINOS + 2;
+    
+    c.puntos_fft = siguiente_potencia_2(minimo);
+    c.an = malloc((N_TERMINOS + 1) * sizeof(double));
+    c.bn = malloc((N_TERMINOS + 1) * sizeof(double));
+    if (c.an == NULL || c.bn == NULL) {
+        printf("ERROR: Memoria insuficiente para %d coeficientes\n", N_TERMINOS);
+        free(c.an); free(c.bn);
+        return EXIT_FAILURE;
+    }
+    for (int p = 0; p < PUNTOS_GRAFICO; p++) {
+        c.x[p] = GRAFICO_INICIO + p * (GRAFICO_FIN - GRAFICO_INICIO) / (PUNTOS_GRAFICO - 1);
+    }
+    
+    bench_encabezado("fourier");
+    bench_medir("fourier", "coeficientes_cuadratura", "llamada", bench_cuadratura, &c);
+    bench_medir("fourier", "coeficientes_fft", "llamada", bench_fft, &c);
+    bench_medir("fourier", "sintesis_directa", "punto", bench_sintesis_directa, &c);
+    bench_medir("fourier", "sintesis_recurrencia", "punto", bench_sintesis_recurrencia, &c);
+    bench_pie();
+    
+    free(c.an);
+    free(c.bn);
+    return EXIT_SUCCESS;
+}
+
+// ============================================================================
+// GRAFICO EN MEMORIA (MOTOR_SVG)
+// ============================================================================
+// Mismo contenido que fourier_plot.gp, con los puntos de la malla del grafico
+#define SERIE_ORIGINAL      0
+#define SERIE_FOURIER       1
+
+PanelGrafico grafico;
+
+void preparar_grafico() {
+    char titulo[GRAFICO_LARGO_TEXTO];
+    snprintf(titulo, sizeof(titulo), "Serie de Fourier (N = %d terminos)", N_TERMINOS);
+    
+    grafico_iniciar(&grafico, titulo, "x", "f(x)");
+    grafico_rango_x(&grafico, GRAFICO_INICIO, GRAFICO_FIN);
+    // El rango fijo corresponde a la onda triangular de la macro
+    if (!expr_original.activa) grafico_rango_y(&grafico, -0.5, 4.5);
+    grafico_serie(&grafico, "Funcion original", "#0066CC", TRAZO_LINEA, 3.0);
+    grafico_serie(&grafico, "Aproximacion Fourier", "#FF3333", TRAZO_LINEA | TRAZO_DISCONTINUO, 2.0);
+}
+
+int graficar_svg() {
+    int resultado = grafico_escribir_svg(grafico_nombre_svg(NOMBRE_GRAFICO), ANCHO_GRAFICO, ALTO_GRAFICO,
+                                         &grafico, 1);
+    grafico_liberar(&grafico);
+    return resultado;
+}
+
 // ============================================================================
 // FUNCIONES PRINCIPALES
 // ============================================================================
 int main() {
     validar_parametros();
     
+    if (bench_solicitado()) {
+        return ejecutar_benchmark();
+    }
+    
     printf("==============================================================\n");
     printf("                    SERIE DE FOURIER                          \n");
     printf("==============================================================\n\n");
     
     printf("CONFIGURACION:\n");
-    printf("  Funcion:          Triangular en [0, 2pi]\n");
+    printf("  Funcion:          %s\n", expr_original.activa ? expr_original.texto : "Triangular en [0, 2pi]");
     printf("  Periodo:          L = pi\n");
     printf("  Terminos:         %d\n", N_TERMINOS);
     printf("  Puntos grafico:   %d\n\n", PUNTOS_GRAFICO);
@@ -113,158 +529,183 @@ int main() {
     printf("-------------------------------------------------------------\n");
     
     double a0 = 0.0;
-    double an[N_TERMINOS + 1], bn[N_TERMINOS + 1];
-    
-    int puntos_int = 1000;
-    double dx_int = 2*L / puntos_int;
-    VALIDAR(dx_int);
+    double *an = malloc((N_TERMINOS + 1) * sizeof(double));
+    double *bn = malloc((N_TERMINOS + 1) * sizeof(double));
     
-    if (dx_int <= 0) {
-        printf("ERROR: dx_int no valido: %f\n", dx_int);
+    if (an == NULL || bn == NULL) {
+        printf("ERROR: Memoria insuficiente para %d coeficientes\n", N_TERMINOS);
+        free(an); free(bn);
         return EXIT_FAILURE;
     }
     
-    // Calcular a0
-    for (int i = 0; i < puntos_int; i++) {
-        double x = i * dx_int;
-        double f = FUNCION_ORIGINAL(x);
-        VALIDAR(f);
+    if (MODO_COEFICIENTES == COEF_FFT) {
+        // M > 2*N_TERMINOS evita aliasing de los armonicos pedidos
+        int minimo = PUNTOS_INTEGRACION > 2*N_TERMINOS + 2 ? PUNTOS_INTEGRACION : 2*N_TERMINOS + 2;
+        int puntos_fft = siguiente_potencia_2(minimo);
+        printf("  Metodo: FFT real (M = %d muestras)\n", puntos_fft);
         
-        if (!es_numerico_valido(f)) {
-            printf("ERROR: Funcion invalida en x = %f, f(x) = %f\n", x, f);
+        validacion_abrir_lote();
+        int estado = coeficientes_fft(puntos_fft, N_TERMINOS, &a0, an, bn);
+        if (validacion_cerrar_lote("FFT", puntos_fft)) {
+            estado = coeficientes_fft(puntos_fft, N_TERMINOS, &a0, an, bn);
+            validacion_fin_repeticion();
+        }
+        if (estado != EXIT_SUCCESS) {
+            free(an); free(bn);
             return EXIT_FAILURE;
         }
         
-        a0 += f;
-        VALIDAR(a0);
-    }
-    a0 *= dx_int / L;
-    VALIDAR(a0);
-    
-    printf("  Coeficiente a0 = %.6f\n", a0);
-    
-    // Calcular coeficientes an y bn
-    for (int n = 1; n <= N_TERMINOS; n++) {
-        double suma_an = 0.0, suma_bn = 0.0;
-        
-        for (int i = 0; i < puntos_int; i++) {
-            double x = i * dx_int;
-            double f = FUNCION_ORIGINAL(x);
-            VALIDAR(f);
-            
-            double cos_val = cos(n * M_PI * x / L);
-            double sin_val = sin(n * M_PI * x / L);
-            VALIDAR(cos_val); VALIDAR(sin_val);
-            
-            suma_an += f * cos_val;
-            suma_bn += f * sin_val;
-            
-            VALIDAR(suma_an); VALIDAR(suma_bn);
-            
-            // Detectar overflow
-            if (fabs(suma_an) > 1e50 || fabs(suma_bn) > 1e50) {
-                printf("ERROR: Overflow en calculo de coeficientes n=%d\n", n);
-                return EXIT_FAILURE;
-            }
+        // Verificar contra la cuadratura de referencia con las mismas muestras
+        int n_ref = N_TERMINOS < 5 ? N_TERMINOS : 5;
+        double a0_ref, an_ref[6], bn_ref[6];
+        if (coeficientes_cuadratura(puntos_fft, n_ref, &a0_ref, an_ref, bn_ref) != EXIT_SUCCESS) {
+            free(an); free(bn);
+            return EXIT_FAILURE;
         }
         
-        an[n] = suma_an * dx_int / L;
-        bn[n] = suma_bn * dx_int / L;
+        double diferencia = fabs(a0 - a0_ref);
+        for (int n = 1; n <= n_ref; n++) {
+            diferencia = fmax(diferencia, fmax(fabs(an[n] - an_ref[n]), fabs(bn[n] - bn_ref[n])));
+        }
+        printf("  Verificacion vs cuadratura (n <= %d): max |diferencia| = %.2e\n", n_ref, diferencia);
         
-        VALIDAR(an[n]); VALIDAR(bn[n]);
+        if (diferencia > 1e-9) {
+            printf("ADVERTENCIA: FFT y cuadratura discrepan\n");
+        }
+    } else {
+        printf("  Metodo: cuadratura directa (%d puntos)\n", PUNTOS_INTEGRACION);
         
-        if (n <= 5) {
-            printf("  a%d = %9.6f, b%d = %9.6f\n", n, an[n], n, bn[n]);
+        if (coeficientes_cuadratura(PUNTOS_INTEGRACION, N_TERMINOS, &a0, an, bn) != EXIT_SUCCESS) {
+            free(an); free(bn);
+            return EXIT_FAILURE;
         }
     }
     
+    printf("  Coeficiente a0 = %.6f\n", a0);
+    for (int n = 1; n <= N_TERMINOS && n <= 5; n++) {
+        printf("  a%d = %9.6f, b%d = %9.6f\n", n, an[n], n, bn[n]);
+    }
+    
     // ============================================================================
     // GENERAR DATOS CON VALIDACION
     // ============================================================================
     printf("\nGENERANDO DATOS...\n");
     printf("-------------------------------------------------------------\n");
     
-    FILE *orig = abrir_archivo("fourier_original.dat", "w");
-    FILE *serie = abrir_archivo("fourier_serie.dat", "w");
-    FILE *script_gp = abrir_archivo("fourier_plot.gp", "w");
-    
-    fprintf(orig, "# Funcion original\n");
-    fprintf(serie, "# Aproximacion de Fourier\n");
+    SalidaDatos *orig = salida_abrir("fourier_original.dat", FORMATO_SALIDA, "x f", "%.6f %.6f\n");
+    SalidaDatos *serie = salida_abrir("fourier_serie.dat", FORMATO_SALIDA, "x serie", "%.6f %.6f\n");
+    FILE *script_gp = NULL;
+    if (motor_grafico == MOTOR_SVG) {
+        preparar_grafico();
+    } else {
+        script_gp = abrir_archivo("fourier_plot.gp", "w");
+    }
     
     double dx = (GRAFICO_FIN - GRAFICO_INICIO) / PUNTOS_GRAFICO;
     VALIDAR(dx);
     
+    // Evaluar toda la serie de una vez sobre la malla del grafico
+    int n_puntos = PUNTOS_GRAFICO + 1;
+    double *xs = malloc(n_puntos * sizeof(double));
+    double *valores_serie = malloc(n_puntos * sizeof(double));
+    
+    if (xs == NULL || valores_serie == NULL) {
+        printf("ERROR: Memoria insuficiente para %d puntos\n", n_puntos);
+        return EXIT_FAILURE;
+    }
+    
+    for (int i = 0; i < n_puntos; i++) {
+        xs[i] = GRAFICO_INICIO + i * dx;
+    }
+    validacion_abrir_lote();
+    sintetizar_serie(xs, valores_serie, n_puntos, a0, an, bn, N_TERMINOS);
+    
+    // Si la sintesis levanto una excepcion, el recorrido siguiente valida
+    // cada punto para ubicarla
+    int repetir_sintesis = validacion_cerrar_lote("sintesis", n_puntos);
+    
     int errores_puntos = 0;
+    double diferencia_sintesis = 0.0;
     
     for (int i = 0; i <= PUNTOS_GRAFICO; i++) {
-        double x = GRAFICO_INICIO + i * dx;
+        double x = xs[i];
         VALIDAR(x);
         
         // Funcion original
-        double f_orig = FUNCION_ORIGINAL(x);
+        double f_orig = EVAL_ORIGINAL(x);
         VALIDAR(f_orig);
         
         // Serie de Fourier
-        double f_serie = a0 / 2;
+        double f_serie = valores_serie[i];
         VALIDAR(f_serie);
         
-        for (int n = 1; n <= N_TERMINOS; n++) {
-            double termino = an[n] * cos(n * M_PI * x / L) + bn[n] * sin(n * M_PI * x / L);
-            VALIDAR(termino);
-            
-            f_serie += termino;
-            VALIDAR(f_serie);
-            
-            // Detectar divergencia
-            if (!es_numerico_valido(f_serie)) {
-                printf("ADVERTENCIA: Serie divergente en x=%.3f, n=%d\n", x, n);
-                errores_puntos++;
-                f_serie = 0; // Reset para continuar
-                break;
-            }
+        // Detectar divergencia
+        if (!es_numerico_valido(f_serie)) {
+            printf("ADVERTENCIA: Serie divergente en x=%.3f\n", x);
+            errores_puntos++;
+            f_serie = 0;
         }
         
         // Guardar si ambos valores son validos
         if (es_numerico_valido(f_orig) && es_numerico_valido(f_serie)) {
-            fprintf(orig, "%.6f %.6f\n", x, f_orig);
-            fprintf(serie, "%.6f %.6f\n", x, f_serie);
+            SALIDA_FILA(orig, x, f_orig);
+            SALIDA_FILA(serie, x, f_serie);
+            if (motor_grafico == MOTOR_SVG) {
+                grafico_punto(&grafico, SERIE_ORIGINAL, x, f_orig);
+                grafico_punto(&grafico, SERIE_FOURIER, x, f_serie);
+            }
         } else {
             errores_puntos++;
         }
         
-        // Progreso
+        // Progreso (y control de la recurrencia contra la suma directa)
         if (i % (PUNTOS_GRAFICO/10) == 0) {
+            if (MODO_SINTESIS == SINTESIS_RECURRENCIA) {
+                double referencia = sintesis_directa(x, a0, an, bn, N_TERMINOS);
+                diferencia_sintesis = fmax(diferencia_sintesis, fabs(f_serie - referencia));
+            }
             printf("  %3d%%: x=%.3f, f(x)=%.3f, Fourier=%.3f\n", 
                    (i*100)/PUNTOS_GRAFICO, x, f_orig, f_serie);
         }
     }
+    if (repetir_sintesis) validacion_fin_repeticion();
     
-    fclose(orig);
-    fclose(serie);
+    salida_cerrar(orig);
+    salida_cerrar(serie);
+    free(xs);
+    free(valores_serie);
+    
+    if (MODO_SINTESIS == SINTESIS_RECURRENCIA) {
+        printf("  Verificacion vs suma directa: max |diferencia| = %.2e\n", diferencia_sintesis);
+    }
     
     if (errores_puntos > 0) {
         printf("ADVERTENCIA: %d puntos tuvieron problemas numericos\n", errores_puntos);
     }
     
     // ============================================================================
-    // CREAR SCRIPT GNUPLOT
+    // CREAR SCRIPT GNUPLOT (con MOTOR_SVG el grafico se arma en memoria)
     // ============================================================================
-    fprintf(script_gp, "# Script para serie de Fourier\n");
-    fprintf(script_gp, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
-            ANCHO_GRAFICO, ALTO_GRAFICO);
-    fprintf(script_gp, "set output '%s'\n", NOMBRE_GRAFICO);
-    fprintf(script_gp, "set title 'Serie de Fourier (N = %d terminos)'\n", N_TERMINOS);
-    fprintf(script_gp, "set xlabel 'x'\n");
-    fprintf(script_gp, "set ylabel 'f(x)'\n");
-    fprintf(script_gp, "set grid\n");
-    fprintf(script_gp, "set key top left box\n");
-    fprintf(script_gp, "set xrange [%f:%f]\n", GRAFICO_INICIO, GRAFICO_FIN);
-    fprintf(script_gp, "set yrange [-0.5:4.5]\n\n");
-    
-    fprintf(script_gp, "plot 'fourier_original.dat' w l lw 3 lc rgb '#0066CC' title 'Funcion original', \\\n");
-    fprintf(script_gp, "     'fourier_serie.dat' w l lw 2 lc rgb '#FF3333' dt 2 title 'Aproximacion Fourier'\n");
-    
-    fclose(script_gp);
+    if (motor_grafico == MOTOR_GNUPLOT) {
+        fprintf(script_gp, "# Script para serie de Fourier\n");
+        fprintf(script_gp, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
+                ANCHO_GRAFICO, ALTO_GRAFICO);
+        fprintf(script_gp, "set output '%s'\n", NOMBRE_GRAFICO);
+        fprintf(script_gp, "set title 'Serie de Fourier (N = %d terminos)'\n", N_TERMINOS);
+        fprintf(script_gp, "set xlabel 'x'\n");
+        fprintf(script_gp, "set ylabel 'f(x)'\n");
+        fprintf(script_gp, "set grid\n");
+        fprintf(script_gp, "set key top left box\n");
+        fprintf(script_gp, "set xrange [%f:%f]\n", GRAFICO_INICIO, GRAFICO_FIN);
+        fprintf(script_gp, "set yrange [-0.5:4.5]\n\n");
+        
+        fprintf(script_gp, "plot %s w l lw 3 lc rgb '#0066CC' title 'Funcion original', \\\n",
+                fuente_gnuplot("fourier_original.dat", FORMATO_SALIDA));
+        fprintf(script_gp, "     %s w l lw 2 lc rgb '#FF3333' dt 2 title 'Aproximacion Fourier'\n",
+                fuente_gnuplot("fourier_serie.dat", FORMATO_SALIDA));
+        
+        fclose(script_gp);
+    }
     
     // ============================================================================
     // EJECUTAR GNUPLOT
@@ -272,12 +713,14 @@ int main() {
     printf("\nGENERANDO GRAFICO...\n");
     printf("-------------------------------------------------------------\n");
     
-    int resultado = system("gnuplot fourier_plot.gp 2>&1");
+    int resultado = (motor_grafico == MOTOR_SVG) ? graficar_svg()
+                                                 : system("gnuplot fourier_plot.gp 2>&1");
     
     if (resultado != 0) {
         printf("ADVERTENCIA: Problema al generar grafico\n");
     } else {
-        printf("Grafico generado: %s\n", NOMBRE_GRAFICO);
+        printf("Grafico generado: %s\n",
+               (motor_grafico == MOTOR_SVG) ? grafico_nombre_svg(NOMBRE_GRAFICO) : NOMBRE_GRAFICO);
     }
     
     // ============================================================================
@@ -286,33 +729,32 @@ int main() {
     printf("\nANALISIS DE ERROR:\n");
     printf("-------------------------------------------------------------\n");
     
-    double error_cuadratico = 0.0;
-    double error_maximo = 0.0;
+    EstadisticaOnline errores;
+    estad_iniciar(&errores);
     int puntos_error = 100;
-    int puntos_validos = 0;
+    
+    double xs_error[puntos_error + 1], serie_error[puntos_error + 1];
     
     for (int i = 0; i <= puntos_error; i++) {
-        double x = GRAFICO_INICIO + i * (GRAFICO_FIN - GRAFICO_INICIO) / puntos_error;
-        double f_orig = FUNCION_ORIGINAL(x);
-        double f_serie = a0 / 2;
-        
-        for (int n = 1; n <= N_TERMINOS; n++) {
-            f_serie += an[n] * cos(n * M_PI * x / L) + bn[n] * sin(n * M_PI * x / L);
-        }
+        xs_error[i] = GRAFICO_INICIO + i * (GRAFICO_FIN - GRAFICO_INICIO) / puntos_error;
+    }
+    sintetizar_serie(xs_error, serie_error, puntos_error + 1, a0, an, bn, N_TERMINOS);
+    
+    for (int i = 0; i <= puntos_error; i++) {
+        double x = xs_error[i];
+        double f_orig = EVAL_ORIGINAL(x);
+        double f_serie = serie_error[i];
         
         if (es_numerico_valido(f_orig) && es_numerico_valido(f_serie)) {
-            double error = fabs(f_orig - f_serie);
-            error_cuadratico += error * error;
-            if (error > error_maximo) error_maximo = error;
-            puntos_validos++;
+            estad_agregar(&errores, fabs(f_orig - f_serie));
         }
     }
     
-    if (puntos_validos > 0) {
-        error_cuadratico = sqrt(error_cuadratico / puntos_validos);
-        printf("  Error cuadratico medio: %.6f\n", error_cuadratico);
-        printf("  Error maximo:           %.6f\n", error_maximo);
-        printf("  Puntos analizados:      %d/%d\n", puntos_validos, puntos_error + 1);
+    if (errores.n > 0) {
+        printf("  Error cuadratico medio: %.6f\n", estad_rms(&errores));
+        printf("  Error medio:            %.6f\n", estad_media(&errores));
+        printf("  Error maximo:           %.6f\n", estad_maximo(&errores));
+        printf("  Puntos analizados:      %ld/%d\n", errores.n, puntos_error + 1);
     } else {
         printf("ERROR: No se pudieron calcular errores\n");
     }
@@ -332,5 +774,7 @@ int main() {
     printf("                      EJECUCION COMPLETADA                     \n");
     printf("==============================================================\n");
     
+    free(an);
+    free(bn);
     return EXIT_SUCCESS;
 }
\ No newline at end of file
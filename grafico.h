@@ -0,0 +1,418 @@
+// grafico.h
+// Graficos de lineas en SVG dibujados dentro del proceso a partir de los
+// arreglos en memoria, sin lanzar gnuplot ni releer los .dat
+
+#ifndef GRAFICO_H
+#define GRAFICO_H
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// MOTORES
+// ============================================================================
+// MOTOR_GNUPLOT: cada programa escribe su script .gp y llama a gnuplot
+//   (system), que vuelve a leer los archivos de datos.
+// MOTOR_SVG: los puntos se acumulan en memoria mientras se calculan y al
+//   final se escribe un SVG. Sin procesos hijos ni texto re-parseado, para
+//   corridas por lotes de miles de configuraciones.
+//
+// El motor por defecto es el MOTOR_GRAFICO de cada programa; la variable de
+// entorno GRAFICO lo reemplaza sin recompilar:
+//   GRAFICO=svg ./ecuacion1
+// ============================================================================
+#define MOTOR_GNUPLOT           0
+#define MOTOR_SVG               1
+
+// Estilo de una serie (se combinan con |)
+#define TRAZO_LINEA             1
+#define TRAZO_PUNTOS            2
+#define TRAZO_DISCONTINUO       4   // Linea de trazos (dt 2)
+#define TRAZO_EJE_Y2            8   // Escala en el eje derecho (axes x1y2)
+
+// Posicion de la leyenda
+#define LEYENDA_NINGUNA         0
+#define LEYENDA_IZQUIERDA       1
+#define LEYENDA_DERECHA         2
+
+#define GRAFICO_MAX_SERIES      8
+#define GRAFICO_MUESTRAS        200     // Puntos de las curvas analiticas (set samples)
+#define GRAFICO_LARGO_TEXTO     160
+#define GRAFICO_FUENTE          13      // px, similar a 'Arial,10' de pngcairo
+
+int motor_grafico = MOTOR_GNUPLOT;
+
+typedef struct {
+    double *x, *y;
+    long n, capacidad;
+    char titulo[GRAFICO_LARGO_TEXTO];   // Vacio: sin entrada en la leyenda
+    const char *color;
+    int estilo;
+    double grosor;                      // lw de la linea o ps de los puntos
+} SerieGrafico;
+
+typedef struct {
+    char titulo[GRAFICO_LARGO_TEXTO];
+    char etiqueta_x[GRAFICO_LARGO_TEXTO], etiqueta_y[GRAFICO_LARGO_TEXTO];
+    char etiqueta_y2[GRAFICO_LARGO_TEXTO];
+    double x_min, x_max, y_min, y_max;
+    int rango_x, rango_y;               // 1 si el rango es fijo
+    int proporcion_igual;               // set size ratio -1
+    int leyenda;
+    SerieGrafico series[GRAFICO_MAX_SERIES];
+    int n_series;
+} PanelGrafico;
+
+void grafico_iniciar_motor(int por_defecto) {
+    const char *texto = getenv("GRAFICO");
+    motor_grafico = por_defecto;
+
+    if (texto != NULL && texto[0] != '\0') {
+        if (strcmp(texto, "gnuplot") == 0) {
+            motor_grafico = MOTOR_GNUPLOT;
+        } else if (strcmp(texto, "svg") == 0) {
+            motor_grafico = MOTOR_SVG;
+        } else {
+            printf("ERROR: GRAFICO='%s' desconocido (gnuplot o svg)\n", texto);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (motor_grafico != MOTOR_GNUPLOT) {
+        printf("   Graficos: svg (sin gnuplot)\n");
+    }
+}
+
+// Nombre del SVG: la extension de NOMBRE_GRAFICO pasa a .svg
+const char* grafico_nombre_svg(const char *nombre) {
+    static char buffers[2][256];
+    static int turno = 0;
+    char *destino = buffers[turno];
+    turno = (turno + 1) % 2;
+
+    strncpy(destino, nombre, 255);
+    destino[255] = '\0';
+    char *punto = strrchr(destino, '.');
+    if (punto != NULL && strchr(punto, '/') == NULL) *punto = '\0';
+    strncat(destino, ".svg", 255 - strlen(destino));
+    return destino;
+}
+
+// ============================================================================
+// CONSTRUCCION
+// ============================================================================
+void grafico_iniciar(PanelGrafico *p, const char *titulo, const char *etiqueta_x,
+                     const char *etiqueta_y) {
+    memset(p, 0, sizeof(*p));
+    snprintf(p->titulo, GRAFICO_LARGO_TEXTO, "%s", titulo);
+    snprintf(p->etiqueta_x, GRAFICO_LARGO_TEXTO, "%s", etiqueta_x);
+    snprintf(p->etiqueta_y, GRAFICO_LARGO_TEXTO, "%s", etiqueta_y);
+    p->leyenda = LEYENDA_IZQUIERDA;
+}
+
+void grafico_rango_x(PanelGrafico *p, double minimo, double maximo) {
+    p->x_min = minimo;
+    p->x_max = maximo;
+    p->rango_x = 1;
+}
+
+void grafico_rango_y(PanelGrafico *p, double minimo, double maximo) {
+    p->y_min = minimo;
+    p->y_max = maximo;
+    p->rango_y = 1;
+}
+
+// Devuelve el indice de la serie para grafico_punto; titulo NULL = notitle
+int grafico_serie(PanelGrafico *p, const char *titulo, const char *color,
+                  int estilo, double grosor) {
+    if (p->n_series >= GRAFICO_MAX_SERIES) {
+        printf("ERROR: Mas de %d series en el grafico '%s'\n", GRAFICO_MAX_SERIES, p->titulo);
+        exit(EXIT_FAILURE);
+    }
+    SerieGrafico *s = &p->series[p->n_series];
+    memset(s, 0, sizeof(*s));
+    if (titulo != NULL) snprintf(s->titulo, GRAFICO_LARGO_TEXTO, "%s", titulo);
+    s->color = color;
+    s->estilo = estilo;
+    s->grosor = grosor;
+    return p->n_series++;
+}
+
+void grafico_punto(PanelGrafico *p, int serie, double x, double y) {
+    SerieGrafico *s = &p->series[serie];
+
+    if (s->n == s->capacidad) {
+        long capacidad = (s->capacidad == 0) ? 1024 : 2 * s->capacidad;
+        double *nx = realloc(s->x, capacidad * sizeof(double));
+        double *ny = (nx == NULL) ? NULL : realloc(s->y, capacidad * sizeof(double));
+        if (nx == NULL || ny == NULL) {
+            printf("ERROR: Memoria insuficiente para %ld puntos del grafico\n", capacidad);
+            exit(EXIT_FAILURE);
+        }
+        s->x = nx;
+        s->y = ny;
+        s->capacidad = capacidad;
+    }
+    s->x[s->n] = x;
+    s->y[s->n] = y;
+    s->n++;
+}
+
+void grafico_liberar(PanelGrafico *p) {
+    for (int i = 0; i < p->n_series; i++) {
+        free(p->series[i].x);
+        free(p->series[i].y);
+    }
+    p->n_series = 0;
+}
+
+// ============================================================================
+// ESCALAS
+// ============================================================================
+// Paso de marcas 1, 2 o 5 x 10^k para unas 'objetivo' divisiones
+double grafico_paso_marcas(double ancho, int objetivo) {
+    double crudo = ancho / objetivo;
+    double magnitud = pow(10.0, floor(log10(crudo)));
+    double r = crudo / magnitud;
+    double paso = (r < 1.5) ? 1.0 : (r < 3.0) ? 2.0 : (r < 7.0) ? 5.0 : 10.0;
+    return paso * magnitud;
+}
+
+// Rango automatico al estilo de gnuplot: extremos de los datos extendidos
+// hasta la marca siguiente
+void grafico_autorango(const PanelGrafico *p, int eje, int y2, double *minimo, double *maximo) {
+    double lo = INFINITY, hi = -INFINITY;
+
+    for (int i = 0; i < p->n_series; i++) {
+        const SerieGrafico *s = &p->series[i];
+        if (eje == 1 && ((s->estilo & TRAZO_EJE_Y2) != 0) != y2) continue;
+        const double *v = (eje == 0) ? s->x : s->y;
+        for (long k = 0; k < s->n; k++) {
+            if (!isfinite(s->x[k]) || !isfinite(s->y[k])) continue;
+            if (v[k] < lo) lo = v[k];
+            if (v[k] > hi) hi = v[k];
+        }
+    }
+
+    if (lo > hi) { lo = -1.0; hi = 1.0; }
+    if (hi - lo < 1e-300 + 1e-12 * fabs(hi)) {
+        double d = (hi == 0.0) ? 1.0 : 0.1 * fabs(hi);
+        lo -= d;
+        hi += d;
+    }
+    double paso = grafico_paso_marcas(hi - lo, 6);
+    *minimo = paso * floor(lo / paso);
+    *maximo = paso * ceil(hi / paso);
+}
+
+// ============================================================================
+// ESCRITURA SVG
+// ============================================================================
+void grafico_texto_svg(FILE *f, const char *texto) {
+    for (const char *c = texto; *c != '\0'; c++) {
+        switch (*c) {
+            case '&': fputs("&amp;", f); break;
+            case '<': fputs("&lt;", f); break;
+            case '>': fputs("&gt;", f); break;
+            case '"': fputs("&quot;", f); break;
+            default:  fputc(*c, f); break;
+        }
+    }
+}
+
+// Pixel acotado: un valor enorme no debe producir coordenadas absurdas
+double grafico_pixel(double valor, double minimo, double maximo, double origen, double largo) {
+    double px = origen + (valor - minimo) / (maximo - minimo) * largo;
+    return fmax(-1e5, fmin(1e5, px));
+}
+
+void grafico_marcas(FILE *f, double minimo, double maximo, int vertical,
+                    double x0, double y0, double ancho, double alto, int derecha) {
+    double paso = grafico_paso_marcas(maximo - minimo, vertical ? 6 : 8);
+    double primera = paso * ceil(minimo / paso - 1e-9);
+
+    for (int k = 0; k < 40; k++) {
+        double v = primera + k * paso;
+        if (v > maximo + 1e-9 * paso) break;
+        if (fabs(v) < 1e-12 * paso) v = 0.0;
+
+        if (vertical) {
+            double py = grafico_pixel(v, minimo, maximo, y0 + alto, -alto);
+            if (!derecha) {
+                fprintf(f, "<line x1=\"%.1f\" y1=\"%.1f\" x2=\"%.1f\" y2=\"%.1f\" stroke=\"#d8d8d8\"/>\n",
+                        x0, py, x0 + ancho, py);
+            }
+            fprintf(f, "<text x=\"%.1f\" y=\"%.1f\" text-anchor=\"%s\">%g</text>\n",
+                    derecha ? x0 + ancho + 6 : x0 - 6, py + 4, derecha ? "start" : "end", v);
+        } else {
+            double px = grafico_pixel(v, minimo, maximo, x0, ancho);
+            fprintf(f, "<line x1=\"%.1f\" y1=\"%.1f\" x2=\"%.1f\" y2=\"%.1f\" stroke=\"#d8d8d8\"/>\n",
+                    px, y0, px, y0 + alto);
+            fprintf(f, "<text x=\"%.1f\" y=\"%.1f\" text-anchor=\"middle\">%g</text>\n",
+                    px, y0 + alto + 16, v);
+        }
+    }
+}
+
+// Trazo de una serie. Los puntos que caen en el mismo pixel que el anterior
+// se omiten, de modo que el tamano del SVG depende del largo de la curva en
+// pantalla y no de la cantidad de pasos; un valor no finito corta la linea.
+void grafico_serie_svg(FILE *f, const SerieGrafico *s, double x_min, double x_max,
+                       double y_min, double y_max, double x0, double y0,
+                       double ancho, double alto) {
+    if (s->estilo & TRAZO_LINEA) {
+        fprintf(f, "<path fill=\"none\" stroke=\"%s\" stroke-width=\"%.1f\" stroke-linejoin=\"round\"%s d=\"",
+                s->color, s->grosor, (s->estilo & TRAZO_DISCONTINUO) ? " stroke-dasharray=\"8,5\"" : "");
+        int nuevo_tramo = 1;
+        const char *mover = "M";
+        double ultimo_x = 0.0, ultimo_y = 0.0;
+        for (long k = 0; k < s->n; k++) {
+            if (!isfinite(s->x[k]) || !isfinite(s->y[k])) { nuevo_tramo = 1; continue; }
+            double px = grafico_pixel(s->x[k], x_min, x_max, x0, ancho);
+            double py = grafico_pixel(s->y[k], y_min, y_max, y0 + alto, -alto);
+            if (!nuevo_tramo && k != s->n - 1 &&
+                fabs(px - ultimo_x) < 0.5 && fabs(py - ultimo_y) < 0.5) continue;
+            fprintf(f, "%s%.1f,%.1f", nuevo_tramo ? mover : " L", px, py);
+            nuevo_tramo = 0;
+            mover = " M";
+            ultimo_x = px;
+            ultimo_y = py;
+        }
+        fprintf(f, "\"/>\n");
+    }
+
+    if (s->estilo & TRAZO_PUNTOS) {
+        double radio = 2.5 * s->grosor;
+        fprintf(f, "<g fill=\"%s\">\n", s->color);
+        for (long k = 0; k < s->n; k++) {
+            if (!isfinite(s->x[k]) || !isfinite(s->y[k])) continue;
+            fprintf(f, "<circle cx=\"%.1f\" cy=\"%.1f\" r=\"%.1f\"/>\n",
+                    grafico_pixel(s->x[k], x_min, x_max, x0, ancho),
+                    grafico_pixel(s->y[k], y_min, y_max, y0 + alto, -alto), radio);
+        }
+        fprintf(f, "</g>\n");
+    }
+}
+
+void grafico_leyenda_svg(FILE *f, const PanelGrafico *p, double x0, double y0, double ancho) {
+    int entradas = 0;
+    for (int i = 0; i < p->n_series; i++) entradas += (p->series[i].titulo[0] != '\0');
+    if (p->leyenda == LEYENDA_NINGUNA || entradas == 0) return;
+
+    double caja_ancho = 230, caja_alto = 8 + 18.0 * entradas;
+    double bx = (p->leyenda == LEYENDA_DERECHA) ? x0 + ancho - caja_ancho - 8 : x0 + 8;
+    double by = y0 + 8;
+    fprintf(f, "<rect x=\"%.1f\" y=\"%.1f\" width=\"%.1f\" height=\"%.1f\" fill=\"white\" stroke=\"black\"/>\n",
+            bx, by, caja_ancho, caja_alto);
+
+    int fila = 0;
+    for (int i = 0; i < p->n_series; i++) {
+        const SerieGrafico *s = &p->series[i];
+        if (s->titulo[0] == '\0') continue;
+        double cy = by + 13 + 18.0 * fila++;
+        if (s->estilo & TRAZO_LINEA) {
+            fprintf(f, "<line x1=\"%.1f\" y1=\"%.1f\" x2=\"%.1f\" y2=\"%.1f\" stroke=\"%s\" stroke-width=\"%.1f\"%s/>\n",
+                    bx + 8, cy, bx + 38, cy, s->color, s->grosor,
+                    (s->estilo & TRAZO_DISCONTINUO) ? " stroke-dasharray=\"8,5\"" : "");
+        }
+        if (s->estilo & TRAZO_PUNTOS) {
+            fprintf(f, "<circle cx=\"%.1f\" cy=\"%.1f\" r=\"%.1f\" fill=\"%s\"/>\n",
+                    bx + 23, cy, 2.5 * s->grosor, s->color);
+        }
+        fprintf(f, "<text x=\"%.1f\" y=\"%.1f\">", bx + 46, cy + 4);
+        grafico_texto_svg(f, s->titulo);
+        fprintf(f, "</text>\n");
+    }
+}
+
+void grafico_panel_svg(FILE *f, const PanelGrafico *p, int indice, double y_panel,
+                       double ancho_total, double alto_panel) {
+    int usa_y2 = 0;
+    for (int i = 0; i < p->n_series; i++) usa_y2 |= (p->series[i].estilo & TRAZO_EJE_Y2) != 0;
+
+    double x0 = 75, y0 = y_panel + 32;
+    double ancho = ancho_total - x0 - (usa_y2 ? 75 : 25);
+    double alto = alto_panel - 32 - 48;
+
+    double x_min = p->x_min, x_max = p->x_max, y_min = p->y_min, y_max = p->y_max;
+    double y2_min = 0.0, y2_max = 1.0;
+    if (!p->rango_x) grafico_autorango(p, 0, 0, &x_min, &x_max);
+    if (!p->rango_y) grafico_autorango(p, 1, 0, &y_min, &y_max);
+    if (usa_y2) grafico_autorango(p, 1, 1, &y2_min, &y2_max);
+
+    // Misma escala en ambos ejes: se achica el area de dibujo en la direccion
+    // que sobra, centrada
+    if (p->proporcion_igual) {
+        double escala = fmin(ancho / (x_max - x_min), alto / (y_max - y_min));
+        double nuevo_ancho = escala * (x_max - x_min), nuevo_alto = escala * (y_max - y_min);
+        x0 += 0.5 * (ancho - nuevo_ancho);
+        y0 += 0.5 * (alto - nuevo_alto);
+        ancho = nuevo_ancho;
+        alto = nuevo_alto;
+    }
+
+    fprintf(f, "<clipPath id=\"area%d\"><rect x=\"%.1f\" y=\"%.1f\" width=\"%.1f\" height=\"%.1f\"/></clipPath>\n",
+            indice, x0, y0, ancho, alto);
+
+    grafico_marcas(f, x_min, x_max, 0, x0, y0, ancho, alto, 0);
+    grafico_marcas(f, y_min, y_max, 1, x0, y0, ancho, alto, 0);
+    if (usa_y2) grafico_marcas(f, y2_min, y2_max, 1, x0, y0, ancho, alto, 1);
+
+    fprintf(f, "<rect x=\"%.1f\" y=\"%.1f\" width=\"%.1f\" height=\"%.1f\" fill=\"none\" stroke=\"black\"/>\n",
+            x0, y0, ancho, alto);
+
+    fprintf(f, "<text x=\"%.1f\" y=\"%.1f\" text-anchor=\"middle\" font-weight=\"bold\">",
+            ancho_total / 2, y_panel + 20);
+    grafico_texto_svg(f, p->titulo);
+    fprintf(f, "</text>\n<text x=\"%.1f\" y=\"%.1f\" text-anchor=\"middle\">", x0 + ancho / 2, y0 + alto + 36);
+    grafico_texto_svg(f, p->etiqueta_x);
+    fprintf(f, "</text>\n<text transform=\"translate(%.1f,%.1f) rotate(-90)\" text-anchor=\"middle\">",
+            x0 - 55, y0 + alto / 2);
+    grafico_texto_svg(f, p->etiqueta_y);
+    fprintf(f, "</text>\n");
+    if (usa_y2) {
+        fprintf(f, "<text transform=\"translate(%.1f,%.1f) rotate(90)\" text-anchor=\"middle\">",
+                x0 + ancho + 62, y0 + alto / 2);
+        grafico_texto_svg(f, p->etiqueta_y2);
+        fprintf(f, "</text>\n");
+    }
+
+    fprintf(f, "<g clip-path=\"url(#area%d)\">\n", indice);
+    for (int i = 0; i < p->n_series; i++) {
+        const SerieGrafico *s = &p->series[i];
+        int en_y2 = (s->estilo & TRAZO_EJE_Y2) != 0;
+        grafico_serie_svg(f, s, x_min, x_max, en_y2 ? y2_min : y_min, en_y2 ? y2_max : y_max,
+                          x0, y0, ancho, alto);
+    }
+    fprintf(f, "</g>\n");
+
+    grafico_leyenda_svg(f, p, x0, y0, ancho);
+}
+
+// Escribe n_paneles apilados verticalmente (set multiplot layout n,1).
+// Devuelve 0 si el archivo se escribio, como el codigo de salida de gnuplot.
+int grafico_escribir_svg(const char *nombre, int ancho, int alto,
+                         const PanelGrafico *paneles, int n_paneles) {
+    FILE *f = fopen(nombre, "w");
+    if (f == NULL) {
+        printf(" ERROR: No se pudo crear el grafico '%s'\n", nombre);
+        return 1;
+    }
+
+    fprintf(f, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" "
+               "viewBox=\"0 0 %d %d\" font-family=\"Arial, sans-serif\" font-size=\"%d\">\n",
+            ancho, alto, ancho, alto, GRAFICO_FUENTE);
+    fprintf(f, "<rect width=\"100%%\" height=\"100%%\" fill=\"white\"/>\n");
+
+    double alto_panel = (double)alto / n_paneles;
+    for (int i = 0; i < n_paneles; i++) {
+        grafico_panel_svg(f, &paneles[i], i, i * alto_panel, ancho, alto_panel);
+    }
+
+    fprintf(f, "</svg>\n");
+    return (fclose(f) == 0) ? 0 : 1;
+}
+
+#endif
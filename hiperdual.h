@@ -0,0 +1,271 @@
+// hiperdual.h
+// Numeros hiper-duales de tercer orden: derivadas exactas (sin paso h) por
+// diferenciacion automatica en modo directo
+
+#ifndef HIPERDUAL_H
+#define HIPERDUAL_H
+
+#include <math.h>
+#include "expresion.h"
+
+// ============================================================================
+// REPRESENTACION
+// ============================================================================
+// Un hiper-dual es un polinomio en tres infinitesimos e1, e2, e3 con
+// ei^2 = 0. El coeficiente c[m] acompana al producto de los ei cuyos bits
+// estan en la mascara m (c[0] valor, c[1] e1, c[3] e1e2, c[7] e1e2e3, ...).
+//
+// Sembrando cada variable con una mascara de infinitesimos, una sola
+// evaluacion entrega las derivadas hasta tercer orden en esas direcciones:
+//   x = hd_variable(x0, HD_E1|HD_E2|HD_E3)  ->  c[1]=f', c[3]=f'', c[7]=f'''
+//   x = hd_variable(x0, HD_E1), y = hd_variable(y0, HD_E2|HD_E3)
+//                                          ->  c[1]=fx, c[2]=fy, c[3]=fxy, c[6]=fyy
+// No hay diferencias de valores cercanos: el resultado es exacto salvo el
+// redondeo de las propias operaciones.
+// ============================================================================
+#define HD_E1   1
+#define HD_E2   2
+#define HD_E3   4
+#define HD_COMPONENTES 8
+
+typedef struct {
+    double c[HD_COMPONENTES];
+} HiperDual;
+
+HiperDual hd_constante(double valor) {
+    HiperDual r = {{0}};
+    r.c[0] = valor;
+    return r;
+}
+
+HiperDual hd_variable(double valor, int semilla) {
+    HiperDual r = hd_constante(valor);
+    if (semilla & HD_E1) r.c[HD_E1] = 1.0;
+    if (semilla & HD_E2) r.c[HD_E2] = 1.0;
+    if (semilla & HD_E3) r.c[HD_E3] = 1.0;
+    return r;
+}
+
+// ============================================================================
+// ARITMETICA
+// ============================================================================
+HiperDual hd_suma(HiperDual a, HiperDual b) {
+    for (int m = 0; m < HD_COMPONENTES; m++) a.c[m] += b.c[m];
+    return a;
+}
+
+HiperDual hd_resta(HiperDual a, HiperDual b) {
+    for (int m = 0; m < HD_COMPONENTES; m++) a.c[m] -= b.c[m];
+    return a;
+}
+
+HiperDual hd_escalar(HiperDual a, double k) {
+    for (int m = 0; m < HD_COMPONENTES; m++) a.c[m] *= k;
+    return a;
+}
+
+HiperDual hd_neg(HiperDual a) {
+    return hd_escalar(a, -1.0);
+}
+
+// Producto: solo sobreviven los terminos sin infinitesimos repetidos
+HiperDual hd_mult(HiperDual a, HiperDual b) {
+    HiperDual r = {{0}};
+    for (int i = 0; i < HD_COMPONENTES; i++) {
+        if (a.c[i] == 0.0) continue;
+        // j recorre los subconjuntos de los infinitesimos ausentes en i
+        int libres = (HD_COMPONENTES - 1) & ~i;
+        for (int j = libres; ; j = (j - 1) & libres) {
+            r.c[i | j] += a.c[i] * b.c[j];
+            if (j == 0) break;
+        }
+    }
+    return r;
+}
+
+// Regla de la cadena para g(a) conocidas g, g', g'', g''' en a.c[0]:
+// con a = a0 + n (n nilpotente, n^4 = 0)
+//   g(a) = g(a0) + g'(a0) n + g''(a0) n^2/2 + g'''(a0) n^3/6
+HiperDual hd_cadena(HiperDual a, double g0, double g1, double g2, double g3) {
+    HiperDual n = a;
+    n.c[0] = 0.0;
+    HiperDual n2 = hd_mult(n, n);
+    HiperDual n3 = hd_mult(n2, n);
+
+    HiperDual r;
+    for (int m = 0; m < HD_COMPONENTES; m++) {
+        r.c[m] = g1 * n.c[m] + 0.5 * g2 * n2.c[m] + g3 * n3.c[m] / 6.0;
+    }
+    r.c[0] = g0;
+    return r;
+}
+
+HiperDual hd_inversa(HiperDual a) {
+    double u = 1.0 / a.c[0];
+    return hd_cadena(a, u, -u*u, 2*u*u*u, -6*u*u*u*u);
+}
+
+HiperDual hd_div(HiperDual a, HiperDual b) {
+    return hd_mult(a, hd_inversa(b));
+}
+
+// ============================================================================
+// FUNCIONES ELEMENTALES
+// ============================================================================
+HiperDual hd_sin(HiperDual a) {
+    double s = sin(a.c[0]), c = cos(a.c[0]);
+    return hd_cadena(a, s, c, -s, -c);
+}
+
+HiperDual hd_cos(HiperDual a) {
+    double s = sin(a.c[0]), c = cos(a.c[0]);
+    return hd_cadena(a, c, -s, -c, s);
+}
+
+HiperDual hd_tan(HiperDual a) {
+    double t = tan(a.c[0]), s = 1 + t*t;
+    return hd_cadena(a, t, s, 2*t*s, 2*s*(1 + 3*t*t));
+}
+
+HiperDual hd_exp(HiperDual a) {
+    double e = exp(a.c[0]);
+    return hd_cadena(a, e, e, e, e);
+}
+
+HiperDual hd_log(HiperDual a) {
+    double u = 1.0 / a.c[0];
+    return hd_cadena(a, log(a.c[0]), u, -u*u, 2*u*u*u);
+}
+
+HiperDual hd_sinh(HiperDual a) {
+    double s = sinh(a.c[0]), c = cosh(a.c[0]);
+    return hd_cadena(a, s, c, s, c);
+}
+
+HiperDual hd_cosh(HiperDual a) {
+    double s = sinh(a.c[0]), c = cosh(a.c[0]);
+    return hd_cadena(a, c, s, c, s);
+}
+
+HiperDual hd_tanh(HiperDual a) {
+    double t = tanh(a.c[0]), s = 1 - t*t;
+    return hd_cadena(a, t, s, -2*t*s, -2*s*(1 - 3*t*t));
+}
+
+HiperDual hd_asin(HiperDual a) {
+    double x = a.c[0], q = 1.0 / sqrt(1 - x*x);
+    return hd_cadena(a, asin(x), q, x*q*q*q, (1 + 2*x*x)*pow(q, 5));
+}
+
+HiperDual hd_acos(HiperDual a) {
+    double x = a.c[0], q = 1.0 / sqrt(1 - x*x);
+    return hd_cadena(a, acos(x), -q, -x*q*q*q, -(1 + 2*x*x)*pow(q, 5));
+}
+
+HiperDual hd_atan(HiperDual a) {
+    double x = a.c[0], g = 1.0 / (1 + x*x);
+    return hd_cadena(a, atan(x), g, -2*x*g*g, (6*x*x - 2)*g*g*g);
+}
+
+// a^p con exponente real constante. Los coeficientes nulos se saltan para
+// que x^2 en x = 0 no produzca 0 * 0^-1 = NaN.
+HiperDual hd_potencia(HiperDual a, double p) {
+    double x = a.c[0];
+    double k1 = p, k2 = p*(p - 1), k3 = p*(p - 1)*(p - 2);
+    return hd_cadena(a, pow(x, p),
+                     (k1 == 0) ? 0.0 : k1 * pow(x, p - 1),
+                     (k2 == 0) ? 0.0 : k2 * pow(x, p - 2),
+                     (k3 == 0) ? 0.0 : k3 * pow(x, p - 3));
+}
+
+HiperDual hd_sqrt(HiperDual a) {
+    return hd_potencia(a, 0.5);
+}
+
+int hd_es_constante(HiperDual a) {
+    for (int m = 1; m < HD_COMPONENTES; m++) {
+        if (a.c[m] != 0.0) return 0;
+    }
+    return 1;
+}
+
+// a^b: exponente constante por hd_potencia (admite base negativa),
+// si no exp(b log a)
+HiperDual hd_pow(HiperDual a, HiperDual b) {
+    if (hd_es_constante(b)) return hd_potencia(a, b.c[0]);
+    return hd_exp(hd_mult(b, hd_log(a)));
+}
+
+HiperDual hd_abs(HiperDual a) {
+    return (a.c[0] < 0) ? hd_neg(a) : a;
+}
+
+HiperDual hd_floor(HiperDual a) {
+    return hd_constante(floor(a.c[0]));
+}
+
+// atan2(y, x) = atan(y/x) + rama constante: mismas derivadas
+HiperDual hd_atan2(HiperDual y, HiperDual x) {
+    HiperDual r = hd_atan(hd_div(y, x));
+    r.c[0] = atan2(y.c[0], x.c[0]);
+    return r;
+}
+
+// ============================================================================
+// EVALUACION DE EXPRESIONES DE TIEMPO DE EJECUCION
+// ============================================================================
+// Recorre el mismo bytecode que expr_evaluar con registros hiper-duales
+// ============================================================================
+HiperDual expr_evaluar_hd(const Expresion *e, const HiperDual *vars) {
+    HiperDual r[EXPR_MAX_REG];
+    int nv = e->n_variables;
+
+    for (int v = 0; v < nv; v++) r[v] = vars[v];
+    for (int k = 0; k < e->n_constantes; k++) r[nv + k] = hd_constante(e->constantes[k]);
+
+    for (int i = 0; i < e->n_instr; i++) {
+        const InstrExpr *in = &e->codigo[i];
+        HiperDual a = r[in->a], b = r[in->b], v;
+
+        switch (in->op) {
+            case EXPR_SUMA:  v = hd_suma(a, b); break;
+            case EXPR_RESTA: v = hd_resta(a, b); break;
+            case EXPR_MULT:  v = hd_mult(a, b); break;
+            case EXPR_DIV:   v = hd_div(a, b); break;
+            case EXPR_POT:   v = hd_pow(a, b); break;
+            case EXPR_ATAN2: v = hd_atan2(a, b); break;
+            case EXPR_MIN:   v = (b.c[0] < a.c[0]) ? b : a; break;
+            case EXPR_MAX:   v = (b.c[0] > a.c[0]) ? b : a; break;
+            case EXPR_NEG:   v = hd_neg(a); break;
+            case EXPR_CUAD:  v = hd_mult(a, a); break;
+            case EXPR_SIN:   v = hd_sin(a); break;
+            case EXPR_COS:   v = hd_cos(a); break;
+            case EXPR_TAN:   v = hd_tan(a); break;
+            case EXPR_ASIN:  v = hd_asin(a); break;
+            case EXPR_ACOS:  v = hd_acos(a); break;
+            case EXPR_ATAN:  v = hd_atan(a); break;
+            case EXPR_SINH:  v = hd_sinh(a); break;
+            case EXPR_COSH:  v = hd_cosh(a); break;
+            case EXPR_TANH:  v = hd_tanh(a); break;
+            case EXPR_EXP:   v = hd_exp(a); break;
+            case EXPR_LOG:   v = hd_log(a); break;
+            case EXPR_LOG10: v = hd_escalar(hd_log(a), 1.0 / log(10.0)); break;
+            case EXPR_SQRT:  v = hd_sqrt(a); break;
+            case EXPR_ABS:   v = hd_abs(a); break;
+            default:         v = hd_floor(a); break;
+        }
+        r[in->dst] = v;
+    }
+    return r[e->resultado];
+}
+
+HiperDual expr_evaluar_hd_1(const Expresion *e, HiperDual x) {
+    return expr_evaluar_hd(e, &x);
+}
+
+HiperDual expr_evaluar_hd_2(const Expresion *e, HiperDual x, HiperDual y) {
+    HiperDual v[2] = {x, y};
+    return expr_evaluar_hd(e, v);
+}
+
+#endif
@@ -5,70 +5,152 @@
 #include <math.h>
 #include <stdlib.h>
 #include <errno.h>
+#include "nucleo.h"
+#include "datos_columnar.h"
+#include "expresion.h"
+#include "benchmark.h"
+#include "hiperdual.h"
+#include "grafico.h"
 
 // ============================================================================
 
 // ============================================================================
 #define FUNCION(x)          ((x)*(x)*(x) - 2*(x) - 5)
 #define DERIVADA(x)         (3*(x)*(x) - 2)
+#define DERIVADA2(x)        (6*(x))
+#define DERIVADA3(x)        (6.0)
+#define FUNCION_AD(x)       hd_resta(hd_resta(hd_mult(x, hd_mult(x, x)), hd_escalar(x, 2)), hd_constante(5))
 #define X_INICIAL           2.0
 #define TOLERANCIA          1e-6
 #define MAX_ITER            100
 #define GRAFICO_INICIO      -3.0
 #define GRAFICO_FIN         5.0
 #define GRAFICO_PASO        0.1
-#define NOMBRE_GRAFICO      "newton_grafico.png"
+#define FORMATO_SALIDA      FORMATO_TEXTO    // FORMATO_TEXTO o FORMATO_BINARIO
+#define NIVEL_VALIDACION    VALIDACION_OPERACION  // _OPERACION, _PASO o _NINGUNA (o entorno VALIDACION)
+#define MODO_MULTIARRANQUE  0          // 1 = Newton desde una malla densa de x0
+#define MULTI_PUNTOS        1000000    // Puntos iniciales en [GRAFICO_INICIO, GRAFICO_FIN]
+#define MODO_HIBRIDO        0          // 1 = Newton con biseccion de respaldo en intervalos con cambio de signo
+#define MODO_ORDEN_SUPERIOR 0          // 1 = compara Newton, Halley y Householder de 4o orden desde X_INICIAL
+#define DERIVADAS_SUPERIORES SUPERIORES_MACRO  // SUPERIORES_MACRO, SUPERIORES_AD o SUPERIORES_DIFERENCIAS
+#define MOTOR_GRAFICO       MOTOR_GNUPLOT    // MOTOR_GNUPLOT o MOTOR_SVG (o entorno GRAFICO)
+#define NOMBRE_GRAFICO      "newton_grafico.png" // Con MOTOR_SVG: newton_grafico.svg
 #define ANCHO_GRAFICO       800
 #define ALTO_GRAFICO        600
 // ============================================================================
 
-// ============================================================================
+#define MULTI_BLOQUE        1024       // Arranques por bloque de trabajo
+#define MULTI_MAX_RAICES    64         // Raices distintas que se catalogan
 
-// ============================================================================
-int es_numerico_valido(double valor) {
-    return !(isnan(valor) || isinf(valor) || fabs(valor) > 1e100);
-}
+// Estado final de cada arranque
+#define NEWTON_ACTIVO        0
+#define NEWTON_CONVERGE      1
+#define NEWTON_DERIVADA_CERO 2
+#define NEWTON_DIVERGE       3
+#define NEWTON_MAX_ITER      4
 
-void verificar_nan_inf(const char *nombre, double valor, int linea) {
-    if (isnan(valor)) {
-        printf(" ERROR en linea %d: %s = NaN (Not a Number)\n", linea, nombre);
-        exit(EXIT_FAILURE);
-    }
-    if (isinf(valor)) {
-        printf(" ERROR en linea %d: %s = Infinito\n", linea, nombre);
+// Origen de f'' y f''' en los metodos de orden superior
+#define SUPERIORES_MACRO       0    // DERIVADA2 / DERIVADA3 (o sus variables de entorno)
+#define SUPERIORES_AD          1    // Una pasada hiper-dual de FUNCION_AD da f, f', f'', f'''
+#define SUPERIORES_DIFERENCIAS 2    // Diferencias centrales de FUNCION
+
+// Metodos de Householder: orden d usa hasta f^(d) y converge con orden d+1
+#define HOUSEHOLDER_NEWTON     1
+#define HOUSEHOLDER_HALLEY     2
+#define HOUSEHOLDER_CUARTO     3
+#define ORDEN_TIEMPO_MINIMO    0.05 // Segundos de repeticiones para medir cada metodo
+
+// Funciones definidas en tiempo de ejecucion: si existen las variables de
+// entorno FUNCION y DERIVADA reemplazan a las macros sin recompilar, p. ej.
+//   FUNCION="x^3 - 2*x - 5" DERIVADA="3*x^2 - 2" ./newtonrhapson
+// DERIVADA2 y DERIVADA3 son opcionales: si FUNCION viene del entorno sin
+// ellas, f'' y f''' se obtienen por diferenciacion automatica.
+Expresion expr_funcion, expr_derivada, expr_derivada2, expr_derivada3;
+
+#define EVAL_FUNCION(x)     (expr_funcion.activa ? expr_evaluar_1(&expr_funcion, (x)) : FUNCION(x))
+#define EVAL_DERIVADA(x)    (expr_derivada.activa ? expr_evaluar_1(&expr_derivada, (x)) : DERIVADA(x))
+#define EVAL_DERIVADA2(x)   (expr_derivada2.activa ? expr_evaluar_1(&expr_derivada2, (x)) : DERIVADA2(x))
+#define EVAL_DERIVADA3(x)   (expr_derivada3.activa ? expr_evaluar_1(&expr_derivada3, (x)) : DERIVADA3(x))
+#define EVAL_FUNCION_AD(x)  (expr_funcion.activa ? expr_evaluar_hd_1(&expr_funcion, (x)) : FUNCION_AD(x))
+
+// ============================================================================
+// FUNCIONES PRINCIPALES
+// ============================================================================
+void cargar_expresiones() {
+    expr_desde_entorno(&expr_funcion, "FUNCION", "x");
+    expr_desde_entorno(&expr_derivada, "DERIVADA", "x");
+    expr_desde_entorno(&expr_derivada2, "DERIVADA2", "x");
+    expr_desde_entorno(&expr_derivada3, "DERIVADA3", "x");
+    
+    if (expr_funcion.activa != expr_derivada.activa) {
+        printf("ERROR: FUNCION y DERIVADA deben definirse juntas en el entorno\n");
         exit(EXIT_FAILURE);
     }
-    if (!es_numerico_valido(valor)) {
-        printf(" ERROR en linea %d: %s = Valor numerico invalido\n", linea, nombre);
+    
+    if (expr_derivada2.activa != expr_derivada3.activa) {
+        printf("ERROR: DERIVADA2 y DERIVADA3 deben definirse juntas en el entorno\n");
         exit(EXIT_FAILURE);
     }
 }
 
-#define VALIDAR(variable) verificar_nan_inf(#variable, variable, __LINE__)
-
-FILE* abrir_archivo(const char *nombre, const char *modo) {
-    FILE *archivo = fopen(nombre, modo);
-    if (archivo == NULL) {
-        printf(" ERROR: No se pudo abrir archivo '%s'\n", nombre);
-        printf("   Verifique permisos o espacio en disco\n");
-        exit(EXIT_FAILURE);
-    }
-    return archivo;
+const char* texto_funcion() {
+    return expr_funcion.activa ? expr_funcion.texto : "x^3 - 2x - 5";
 }
 
 // ============================================================================
-// FUNCIONES PRINCIPALES
+// GRAFICO EN MEMORIA (MOTOR_SVG)
 // ============================================================================
+// Mismo contenido que newton_plot.gp: f(x) de generar_datos_funcion y los
+// iterados que main agrega al guardarlos
+#define SERIE_FUNCION       0
+#define SERIE_ITERACIONES   1
+
+PanelGrafico grafico;
+
+void preparar_grafico() {
+    char titulo[GRAFICO_LARGO_TEXTO];
+    snprintf(titulo, sizeof(titulo), "Metodo de Newton-Raphson: f(x) = %.120s", texto_funcion());
+    
+    grafico_iniciar(&grafico, titulo, "x", "f(x)");
+    grafico_serie(&grafico, "f(x)", "blue", TRAZO_LINEA, 2.0);
+    grafico_serie(&grafico, "Iteraciones", "red", TRAZO_PUNTOS, 1.5);
+}
+
+// Devuelve 1 si el grafico se genero, como ejecutar_gnuplot
+int graficar_svg(double raiz) {
+    char titulo[GRAFICO_LARGO_TEXTO];
+    snprintf(titulo, sizeof(titulo), "Raiz: %.6f", raiz);
+    
+    int cero = grafico_serie(&grafico, NULL, "black", TRAZO_LINEA, 1.0);
+    grafico_punto(&grafico, cero, GRAFICO_INICIO, 0.0);
+    grafico_punto(&grafico, cero, GRAFICO_FIN, 0.0);
+    int punto_raiz = grafico_serie(&grafico, titulo, "green", TRAZO_PUNTOS, 2.0);
+    grafico_punto(&grafico, punto_raiz, raiz, 0.0);
+    
+    printf("\n Generando grafico...\n");
+    const char *nombre = grafico_nombre_svg(NOMBRE_GRAFICO);
+    int resultado = grafico_escribir_svg(nombre, ANCHO_GRAFICO, ALTO_GRAFICO, &grafico, 1);
+    grafico_liberar(&grafico);
+    
+    if (resultado != 0) {
+        printf(" ADVERTENCIA: No se pudo escribir el grafico SVG\n");
+        return 0;
+    }
+    
+    printf(" Grafico generado exitosamente: %s\n", nombre);
+    return 1;
+}
+
 void generar_datos_funcion() {
-    FILE *func = abrir_archivo("funcion.dat", "w");
-    fprintf(func, "# x f(x)\n");
+    SalidaDatos *func = salida_abrir("funcion.dat", FORMATO_SALIDA, "x f(x)", "%.3f %.3f\n");
     
     for (double xi = GRAFICO_INICIO; xi <= GRAFICO_FIN; xi += GRAFICO_PASO) {
-        double fx = FUNCION(xi);
+        double fx = EVAL_FUNCION(xi);
         VALIDAR(fx);
-        fprintf(func, "%.3f %.3f\n", xi, fx);
+        SALIDA_FILA(func, xi, fx);
+        if (motor_grafico == MOTOR_SVG) grafico_punto(&grafico, SERIE_FUNCION, xi, fx);
     }
-    fclose(func);
+    salida_cerrar(func);
 }
 
 void crear_script_gnuplot(double raiz) {
@@ -78,16 +160,18 @@ void crear_script_gnuplot(double raiz) {
     fprintf(gp, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
             ANCHO_GRAFICO, ALTO_GRAFICO);
     fprintf(gp, "set output '%s'\n", NOMBRE_GRAFICO);
-    fprintf(gp, "set title 'Metodo de Newton-Raphson: f(x) = x^3 - 2x - 5'\n");
+    fprintf(gp, "set title 'Metodo de Newton-Raphson: f(x) = %s'\n", texto_funcion());
     fprintf(gp, "set xlabel 'x'\n");
     fprintf(gp, "set ylabel 'f(x)'\n");
     fprintf(gp, "set grid\n");
     fprintf(gp, "set key top left box\n");
     fprintf(gp, "set zeroaxis lt -1\n\n");
     
-    fprintf(gp, "plot 'funcion.dat' with lines lw 2 lc rgb 'blue' title 'f(x)', \\\n");
+    fprintf(gp, "plot %s with lines lw 2 lc rgb 'blue' title 'f(x)', \\\n",
+            fuente_gnuplot("funcion.dat", FORMATO_SALIDA));
     fprintf(gp, "     0 with lines lc rgb 'black' notitle, \\\n");
-    fprintf(gp, "     'iteraciones.dat' using 2:3 with points \\\n");
+    fprintf(gp, "     %s using 2:3 with points \\\n",
+            fuente_gnuplot("iteraciones.dat", FORMATO_SALIDA));
     fprintf(gp, "        pt 7 ps 1.5 lc rgb 'red' title 'Iteraciones', \\\n");
     fprintf(gp, "     %lf, 0 with points pt 9 ps 2 lc rgb 'green' title 'Raiz: %.6f'\n", 
             raiz, raiz);
@@ -111,6 +195,613 @@ int ejecutar_gnuplot() {
     return 1;
 }
 
+// ============================================================================
+// NEWTON MULTI-ARRANQUE VECTORIZADO
+// ============================================================================
+// Itera un bloque de arranques a la vez. Los carriles activos estan empacados
+// al inicio de x[]/idx[] para que el lazo sea vectorizable sin mascaras; tras
+// cada iteracion los carriles terminados se retiran y el resto se compacta,
+// asi el trabajo es proporcional a los arranques que aun no convergen.
+void newton_bloque(const double *x0, double *raiz, int *iteraciones, int *estado, int n) {
+    double x[MULTI_BLOQUE];
+    int idx[MULTI_BLOQUE], fin[MULTI_BLOQUE];
+    int n_activos = n;
+    
+    for (int i = 0; i < n; i++) {
+        x[i] = x0[i];
+        idx[i] = i;
+    }
+    
+    double fx[MULTI_BLOQUE], dfx[MULTI_BLOQUE];
+    const double *vars[1] = {x};
+    
+    for (int iter = 0; iter < MAX_ITER && n_activos > 0; iter++) {
+        // Evaluacion separada del paso: con expresiones de tiempo de
+        // ejecucion se usa la API por lotes sobre los carriles activos
+        if (expr_funcion.activa) {
+            expr_evaluar_lote(&expr_funcion, vars, fx, n_activos);
+        } else {
+            #pragma omp simd
+            for (int j = 0; j < n_activos; j++) fx[j] = FUNCION(x[j]);
+        }
+        if (expr_derivada.activa) {
+            expr_evaluar_lote(&expr_derivada, vars, dfx, n_activos);
+        } else {
+            #pragma omp simd
+            for (int j = 0; j < n_activos; j++) dfx[j] = DERIVADA(x[j]);
+        }
+        
+        #pragma omp simd
+        for (int j = 0; j < n_activos; j++) {
+            int derivada_cero = fabs(dfx[j]) < 1e-15;
+            double x_nuevo = x[j] - fx[j] / (dfx[j] + derivada_cero);
+            double error = fabs(x_nuevo - x[j]);
+            int invalido = !(fabs(x_nuevo) <= 1e100);
+            
+            // Mismos criterios que el lazo escalar de main(). El codigo se
+            // arma con aritmetica (NEWTON_ACTIVO = 0): los ternarios
+            // encadenados impiden que gcc vectorice el lazo.
+            int diverge = invalido | ((error > 1e10) & (iter > 5));
+            int convergio = error < TOLERANCIA;
+            fin[j] = NEWTON_DERIVADA_CERO*derivada_cero
+                   + (1 - derivada_cero)*(NEWTON_DIVERGE*diverge + NEWTON_CONVERGE*(1 - diverge)*convergio);
+            x[j] = (derivada_cero | invalido) ? x[j] : x_nuevo;
+        }
+        
+        // Retirar carriles terminados y compactar los activos
+        int k = 0;
+        for (int j = 0; j < n_activos; j++) {
+            if (fin[j] != NEWTON_ACTIVO) {
+                raiz[idx[j]] = x[j];
+                iteraciones[idx[j]] = iter + 1;
+                estado[idx[j]] = fin[j];
+            } else {
+                x[k] = x[j];
+                idx[k] = idx[j];
+                k++;
+            }
+        }
+        n_activos = k;
+    }
+    
+    for (int j = 0; j < n_activos; j++) {
+        raiz[idx[j]] = x[j];
+        iteraciones[idx[j]] = MAX_ITER;
+        estado[idx[j]] = NEWTON_MAX_ITER;
+    }
+}
+
+// Devuelve el indice de la raiz en el catalogo (agregandola si es nueva) o -1
+int catalogar_raiz(double r, double *raices, int *n_raices) {
+    double tol = 100 * TOLERANCIA * fmax(1.0, fabs(r));
+    for (int k = 0; k < *n_raices; k++) {
+        if (fabs(raices[k] - r) <= tol) return k;
+    }
+    if (*n_raices >= MULTI_MAX_RAICES) return -1;
+    raices[*n_raices] = r;
+    return (*n_raices)++;
+}
+
+int ejecutar_multiarranque() {
+    int n = MULTI_PUNTOS;
+    double *x0 = malloc(n * sizeof(double));
+    double *raiz = malloc(n * sizeof(double));
+    int *iteraciones = malloc(n * sizeof(int));
+    int *estado = malloc(n * sizeof(int));
+    
+    if (x0 == NULL || raiz == NULL || iteraciones == NULL || estado == NULL) {
+        printf("ERROR: Memoria insuficiente para %d arranques\n", n);
+        return EXIT_FAILURE;
+    }
+    
+    printf(" NEWTON-RAPHSON MULTI-ARRANQUE \n\n");
+    printf("CONFIGURACION:\n");
+    printf("  Funcion:          f(x) = %s\n", texto_funcion());
+    printf("  Arranques:        %d en [%.1f, %.1f]\n", n, GRAFICO_INICIO, GRAFICO_FIN);
+    printf("  Tolerancia:       %.1e\n", TOLERANCIA);
+    printf("  Max iteraciones:  %d\n\n", MAX_ITER);
+    
+    double dx0 = (n > 1) ? (GRAFICO_FIN - GRAFICO_INICIO) / (n - 1) : 0.0;
+    for (int i = 0; i < n; i++) {
+        x0[i] = GRAFICO_INICIO + i * dx0;
+    }
+    
+    double inicio = bench_tiempo();
+    
+    #pragma omp parallel for schedule(dynamic)
+    for (int b = 0; b < n; b += MULTI_BLOQUE) {
+        int n_bloque = (n - b < MULTI_BLOQUE) ? n - b : MULTI_BLOQUE;
+        newton_bloque(x0 + b, raiz + b, iteraciones + b, estado + b, n_bloque);
+    }
+    
+    double segundos = bench_tiempo() - inicio;
+    
+    // Catalogo de raices y mapa de cuencas comprimido por tramos: cada linea
+    // cubre arranques consecutivos con la misma raiz y el mismo numero de
+    // iteraciones (indice -1 = sin convergencia)
+    double raices[MULTI_MAX_RAICES];
+    int n_raices = 0;
+    int conteo_estado[5] = {0};
+    long iteraciones_totales = 0;
+    
+    SalidaDatos *mapa = salida_abrir("newton_cuencas.dat", FORMATO_SALIDA,
+                                     "x0_inicio x0_fin indice_raiz iteraciones",
+                                     "%.9f %.9f %.0f %.0f\n");
+    
+    int tramo_inicio = 0, tramo_indice = 0, tramo_iter = 0;
+    
+    for (int i = 0; i < n; i++) {
+        int indice = (estado[i] == NEWTON_CONVERGE) ? catalogar_raiz(raiz[i], raices, &n_raices) : -1;
+        conteo_estado[estado[i]]++;
+        iteraciones_totales += iteraciones[i];
+        
+        if (i == 0) {
+            tramo_indice = indice;
+            tramo_iter = iteraciones[i];
+        } else if (indice != tramo_indice || iteraciones[i] != tramo_iter) {
+            SALIDA_FILA(mapa, x0[tramo_inicio], x0[i - 1], tramo_indice, tramo_iter);
+            tramo_inicio = i;
+            tramo_indice = indice;
+            tramo_iter = iteraciones[i];
+        }
+    }
+    SALIDA_FILA(mapa, x0[tramo_inicio], x0[n - 1], tramo_indice, tramo_iter);
+    salida_cerrar(mapa);
+    
+    printf("RESULTADOS:\n");
+    printf("-------------------------------------------------------------\n");
+    printf("  Tiempo:             %.4f s (%.3e arranques/s)\n", segundos, n / segundos);
+    printf("  Iteraciones medias: %.2f\n", (double)iteraciones_totales / n);
+    printf("  Convergieron:       %d\n", conteo_estado[NEWTON_CONVERGE]);
+    printf("  Derivada cero:      %d\n", conteo_estado[NEWTON_DERIVADA_CERO]);
+    printf("  Divergieron:        %d\n", conteo_estado[NEWTON_DIVERGE]);
+    printf("  Limite iteraciones: %d\n", conteo_estado[NEWTON_MAX_ITER]);
+    
+    printf("\n RAICES ENCONTRADAS:\n");
+    for (int k = 0; k < n_raices; k++) {
+        printf("  [%d] x = %.8f, f(x) = %.2e\n", k, raices[k], EVAL_FUNCION(raices[k]));
+    }
+    printf("\n  - %s -> Mapa de cuencas/iteraciones por tramos\n",
+           nombre_salida("newton_cuencas.dat", FORMATO_SALIDA));
+    
+    free(x0); free(raiz); free(iteraciones); free(estado);
+    return EXIT_SUCCESS;
+}
+
+// ============================================================================
+// NEWTON-BISECCION CON INTERVALO (HIBRIDO)
+// ============================================================================
+// Con un intervalo [a, b] donde f cambia de signo, el paso de Newton solo se
+// acepta si cae dentro del intervalo vigente y reduce |f| lo bastante (el
+// paso es menor que la mitad del anterior); si no, se biseca. El intervalo
+// se achica en cada iteracion, asi que converge siempre, con la velocidad de
+// Newton cerca de la raiz. Una derivada nula solo fuerza una biseccion.
+// ============================================================================
+typedef struct {
+    double a, b;                // Intervalo inicial
+    double raiz, fx;
+    int iteraciones, pasos_newton, pasos_biseccion;
+    long evaluaciones_f, evaluaciones_df;
+    int convergio;
+} ResultadoHibrido;
+
+ResultadoHibrido newton_biseccion(double a, double b, double fa, double fb,
+                                  SalidaDatos *historial, int intervalo) {
+    ResultadoHibrido r = {a, b, 0.0, 0.0, 0, 0, 0, 0, 0, 0};
+    
+    if (fa == 0.0 || fb == 0.0) {
+        r.raiz = (fa == 0.0) ? a : b;
+        r.convergio = 1;
+        return r;
+    }
+    
+    // Orientar para que f(bajo) < 0 < f(alto)
+    double bajo = (fa < 0) ? a : b;
+    double alto = (fa < 0) ? b : a;
+    double x = 0.5 * (a + b);
+    double paso = fabs(b - a), paso_anterior = paso;
+    double fx = EVAL_FUNCION(x), dfx = EVAL_DERIVADA(x);
+    r.evaluaciones_f++;
+    r.evaluaciones_df++;
+    
+    for (int iter = 1; iter <= MAX_ITER; iter++) {
+        int fuera = ((x - alto) * dfx - fx) * ((x - bajo) * dfx - fx) > 0;
+        int lento = fabs(2 * fx) > fabs(paso_anterior * dfx);
+        int biseccion = fuera || lento || !es_numerico_valido(dfx);
+        
+        paso_anterior = paso;
+        if (biseccion) {
+            paso = 0.5 * (alto - bajo);
+            x = bajo + paso;
+            r.pasos_biseccion++;
+        } else {
+            paso = fx / dfx;
+            x -= paso;
+            r.pasos_newton++;
+        }
+        r.iteraciones = iter;
+        
+        fx = EVAL_FUNCION(x);
+        dfx = EVAL_DERIVADA(x);
+        r.evaluaciones_f++;
+        r.evaluaciones_df++;
+        
+        if (historial != NULL) {
+            SALIDA_FILA(historial, intervalo, iter, x, fx, biseccion);
+        }
+        
+        if (fabs(paso) < TOLERANCIA || fx == 0.0) {
+            r.convergio = 1;
+            break;
+        }
+        
+        if (fx < 0) bajo = x; else alto = x;
+    }
+    
+    r.raiz = x;
+    r.fx = fx;
+    return r;
+}
+
+// Recorre [GRAFICO_INICIO, GRAFICO_FIN] con paso GRAFICO_PASO y guarda los
+// intervalos con cambio de signo (o un cero exacto en un nodo). Devuelve
+// cuantos encontro; *evaluaciones suma las evaluaciones de f del barrido.
+int buscar_intervalos(double *a, double *b, double *fa, double *fb, int max, long *evaluaciones) {
+    int n_nodos = (int)((GRAFICO_FIN - GRAFICO_INICIO) / GRAFICO_PASO + 0.5);
+    int n = 0, i;
+    double x_ant = GRAFICO_INICIO, f_ant = EVAL_FUNCION(x_ant);
+    (*evaluaciones)++;
+    
+    for (i = 1; i <= n_nodos && n < max; i++) {
+        double x = (i == n_nodos) ? GRAFICO_FIN : GRAFICO_INICIO + i * GRAFICO_PASO;
+        double fx = EVAL_FUNCION(x);
+        (*evaluaciones)++;
+        
+        // Cero exacto en el nodo izquierdo, o cambio de signo estricto
+        if (es_numerico_valido(f_ant) && es_numerico_valido(fx) &&
+            (f_ant == 0.0 || (f_ant < 0 && fx > 0) || (f_ant > 0 && fx < 0))) {
+            a[n] = x_ant; b[n] = x;
+            fa[n] = f_ant; fb[n] = fx;
+            n++;
+        }
+        x_ant = x;
+        f_ant = fx;
+    }
+    
+    if (i <= n_nodos) {
+        printf(" ADVERTENCIA: Se alcanzo el maximo de %d intervalos en x = %.4f\n", max, x_ant);
+        printf("   [%.4f, %.1f] queda sin explorar; aumente MULTI_MAX_RAICES o reduzca el intervalo\n\n",
+               x_ant, GRAFICO_FIN);
+    } else if (f_ant == 0.0 && n < max) {
+        // El bucle solo mira ceros en el nodo izquierdo: falta el extremo final
+        a[n] = b[n] = x_ant;
+        fa[n] = fb[n] = 0.0;
+        n++;
+    } else if (f_ant == 0.0) {
+        printf(" ADVERTENCIA: Se alcanzo el maximo de %d intervalos; se omite la raiz en x = %.4f\n\n",
+               max, x_ant);
+    }
+    return n;
+}
+
+int ejecutar_hibrido() {
+    double a[MULTI_MAX_RAICES], b[MULTI_MAX_RAICES];
+    double fa[MULTI_MAX_RAICES], fb[MULTI_MAX_RAICES];
+    long evaluaciones_barrido = 0, evaluaciones_f = 0, evaluaciones_df = 0;
+    
+    printf(" NEWTON-BISECCION CON INTERVALO \n\n");
+    printf("CONFIGURACION:\n");
+    printf("  Funcion:          f(x) = %s\n", texto_funcion());
+    printf("  Barrido:          [%.1f, %.1f] con paso %.3g\n", GRAFICO_INICIO, GRAFICO_FIN, GRAFICO_PASO);
+    printf("  Tolerancia:       %.1e\n", TOLERANCIA);
+    printf("  Max iteraciones:  %d\n\n", MAX_ITER);
+    
+    int n = buscar_intervalos(a, b, fa, fb, MULTI_MAX_RAICES, &evaluaciones_barrido);
+    if (n == 0) {
+        printf(" ADVERTENCIA: f no cambia de signo en [%.1f, %.1f] con paso %.3g\n",
+               GRAFICO_INICIO, GRAFICO_FIN, GRAFICO_PASO);
+        printf("   Reduzca GRAFICO_PASO o amplie el intervalo\n");
+        return EXIT_FAILURE;
+    }
+    
+    SalidaDatos *historial = salida_abrir("hibrido_iteraciones.dat", FORMATO_SALIDA,
+                                          "intervalo iter x f(x) biseccion",
+                                          "%.0f %.0f %.10f %.6e %.0f\n");
+    
+    printf("+----+-----------------------+----------------+-----------+------+------+------+\n");
+    printf("| #  |       Intervalo       |      Raiz      |   f(raiz) | Iter |Newton| Bisec|\n");
+    printf("+----+-----------------------+----------------+-----------+------+------+------+\n");
+    
+    int convergieron = 0;
+    for (int k = 0; k < n; k++) {
+        ResultadoHibrido r = newton_biseccion(a[k], b[k], fa[k], fb[k], historial, k);
+        evaluaciones_f += r.evaluaciones_f;
+        evaluaciones_df += r.evaluaciones_df;
+        convergieron += r.convergio;
+        
+        printf("| %2d | [%9.4f, %9.4f] | %14.10f | %9.2e | %4d | %4d | %4d |%s\n",
+               k, r.a, r.b, r.raiz, r.fx, r.iteraciones, r.pasos_newton, r.pasos_biseccion,
+               r.convergio ? "" : " SIN CONVERGENCIA");
+    }
+    printf("+----+-----------------------+----------------+-----------+------+------+------+\n");
+    salida_cerrar(historial);
+    
+    printf("\n RESULTADOS:\n");
+    printf("-------------------------------------------------------------\n");
+    printf("  Raices:           %d de %d intervalos\n", convergieron, n);
+    printf("  Evaluaciones:     %ld de FUNCION (%ld barrido + %ld refinamiento), %ld de DERIVADA\n",
+           evaluaciones_barrido + evaluaciones_f, evaluaciones_barrido, evaluaciones_f, evaluaciones_df);
+    printf("  Total:            %ld evaluaciones\n", evaluaciones_barrido + evaluaciones_f + evaluaciones_df);
+    printf("\n  - %s -> Iteraciones por intervalo\n",
+           nombre_salida("hibrido_iteraciones.dat", FORMATO_SALIDA));
+    
+    return (convergieron == n) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// ============================================================================
+// METODOS DE ORDEN SUPERIOR (HOUSEHOLDER)
+// ============================================================================
+// Con f y sus derivadas en x:
+//   Newton      (orden 2): dx = -f / f'
+//   Halley      (orden 3): dx = -2 f f' / (2 f'^2 - f f'')
+//   Householder (orden 4): dx = -(6 f f'^2 - 3 f^2 f'') / (6 f'^3 - 6 f f' f'' + f^2 f''')
+// Cada iteracion cuesta mas evaluaciones, pero hacen falta menos; si f'' y
+// f''' son baratas (macro o una pasada hiper-dual) el total suele bajar.
+// ============================================================================
+typedef struct {
+    long f, df, superiores;     // Evaluaciones de f, f' y de f''/f''' (una pasada AD cuenta en las tres)
+} ConteoEvaluaciones;
+
+typedef struct {
+    double raiz, error;
+    int iteraciones, convergio;
+    ConteoEvaluaciones ev;
+} ResultadoOrden;
+
+// FUNCION_AD debe describir la misma funcion que FUNCION
+void validar_funcion_ad(double x) {
+    double f_ad = EVAL_FUNCION_AD(hd_constante(x)).c[0];
+    double f = EVAL_FUNCION(x);
+    
+    if (fabs(f_ad - f) > 1e-12 * fmax(1.0, fabs(f))) {
+        printf(" ERROR: FUNCION_AD no coincide con FUNCION en x = %g\n", x);
+        printf("   f(x): %.15g vs %.15g\n", f_ad, f);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Origen efectivo de f'' y f''': con FUNCION del entorno y sin DERIVADA2 /
+// DERIVADA3 las macros no corresponden, asi que se pasa a AD
+int origen_superiores() {
+    if (DERIVADAS_SUPERIORES == SUPERIORES_MACRO && expr_funcion.activa && !expr_derivada2.activa) {
+        return SUPERIORES_AD;
+    }
+    return DERIVADAS_SUPERIORES;
+}
+
+const char* nombre_origen(int origen) {
+    switch (origen) {
+        case SUPERIORES_AD:          return "diferenciacion automatica (hiper-dual)";
+        case SUPERIORES_DIFERENCIAS: return "diferencias centrales";
+        default:                     return "macros DERIVADA2 / DERIVADA3";
+    }
+}
+
+// d[0..orden] = f, f', ..., f^(orden) en x. Newton usa siempre FUNCION y
+// DERIVADA; en AD una sola pasada reemplaza a todas las evaluaciones, pero se
+// cuenta como una de f, una de f' y una por cada derivada superior que usa el
+// metodo, para no presentarla mas barata que Newton.
+void evaluar_derivadas(double x, int orden, int origen, double *d, ConteoEvaluaciones *ev) {
+    if (orden >= 2 && origen == SUPERIORES_AD) {
+        HiperDual f = EVAL_FUNCION_AD(hd_variable(x, HD_E1|HD_E2|HD_E3));
+        d[0] = f.c[0];
+        d[1] = f.c[HD_E1];
+        d[2] = f.c[HD_E1|HD_E2];
+        d[3] = f.c[HD_E1|HD_E2|HD_E3];
+        ev->f++;
+        ev->df++;
+        ev->superiores += orden - 1;
+        return;
+    }
+    
+    d[0] = EVAL_FUNCION(x);
+    d[1] = EVAL_DERIVADA(x);
+    ev->f++;
+    ev->df++;
+    if (orden < 2) return;
+    
+    if (origen == SUPERIORES_DIFERENCIAS) {
+        // Pasos cercanos al optimo redondeo/truncamiento: ~eps^(1/4) y ~eps^(1/5)
+        double h2 = 1e-4 * fmax(1.0, fabs(x));
+        d[2] = (EVAL_FUNCION(x + h2) - 2 * d[0] + EVAL_FUNCION(x - h2)) / (h2 * h2);
+        ev->f += 2;
+        if (orden >= 3) {
+            double h3 = 1e-3 * fmax(1.0, fabs(x));
+            d[3] = (EVAL_FUNCION(x + 2*h3) - 2 * EVAL_FUNCION(x + h3)
+                    + 2 * EVAL_FUNCION(x - h3) - EVAL_FUNCION(x - 2*h3)) / (2 * h3 * h3 * h3);
+            ev->f += 4;
+        }
+        return;
+    }
+    
+    d[2] = EVAL_DERIVADA2(x);
+    ev->superiores++;
+    if (orden >= 3) {
+        d[3] = EVAL_DERIVADA3(x);
+        ev->superiores++;
+    }
+}
+
+// Paso de Householder de orden d; 0 si el denominador se anula
+double paso_householder(int orden, const double *d) {
+    double f = d[0], f1 = d[1];
+    double num, den;
+    
+    switch (orden) {
+        case HOUSEHOLDER_HALLEY:
+            num = 2 * f * f1;
+            den = 2 * f1 * f1 - f * d[2];
+            break;
+        case HOUSEHOLDER_CUARTO:
+            num = 6 * f * f1 * f1 - 3 * f * f * d[2];
+            den = 6 * f1 * f1 * f1 - 6 * f * f1 * d[2] + f * f * d[3];
+            break;
+        default:
+            num = f;
+            den = f1;
+            break;
+    }
+    return (fabs(den) < 1e-15) ? 0.0 : -num / den;
+}
+
+ResultadoOrden iterar_householder(double x0, int orden, int origen, SalidaDatos *historial) {
+    ResultadoOrden r = {x0, INFINITY, 0, 0, {0, 0, 0}};
+    double x = x0, d[4];
+    
+    for (int iter = 1; iter <= MAX_ITER; iter++) {
+        evaluar_derivadas(x, orden, origen, d, &r.ev);
+        if (fabs(d[1]) < 1e-15 || !es_numerico_valido(d[0])) break;
+        
+        double dx = paso_householder(orden, d);
+        if (dx == 0.0 && d[0] != 0.0) break;
+        x += dx;
+        r.error = fabs(dx);
+        r.iteraciones = iter;
+        
+        if (historial != NULL) {
+            SALIDA_FILA(historial, orden, iter, x, r.error);
+        }
+        if (!es_numerico_valido(x)) break;
+        if (r.error < TOLERANCIA) {
+            r.convergio = 1;
+            break;
+        }
+    }
+    r.raiz = x;
+    return r;
+}
+
+// Nanosegundos por resolucion completa, repitiendo hasta ORDEN_TIEMPO_MINIMO
+double medir_householder(int orden, int origen) {
+    long repeticiones = 1;
+    double transcurrido;
+    
+    for (;;) {
+        double inicio = bench_tiempo();
+        for (long i = 0; i < repeticiones; i++) {
+            bench_sumidero += iterar_householder(X_INICIAL, orden, origen, NULL).raiz;
+        }
+        transcurrido = bench_tiempo() - inicio;
+        if (transcurrido >= ORDEN_TIEMPO_MINIMO) break;
+        repeticiones *= 2;
+    }
+    return transcurrido / repeticiones * 1e9;
+}
+
+int ejecutar_orden_superior() {
+    const char *nombres[] = {"", "Newton", "Halley", "Householder"};
+    int origen = origen_superiores();
+    
+    if (origen == SUPERIORES_AD) validar_funcion_ad(X_INICIAL);
+    
+    printf(" METODOS DE ORDEN SUPERIOR (HOUSEHOLDER) \n\n");
+    printf("CONFIGURACION:\n");
+    printf("  Funcion:          f(x) = %s\n", texto_funcion());
+    printf("  Valor inicial:    x0 = %.1f\n", X_INICIAL);
+    printf("  f'' y f''':       %s\n", nombre_origen(origen));
+    printf("  Tolerancia:       %.1e\n", TOLERANCIA);
+    printf("  Max iteraciones:  %d\n\n", MAX_ITER);
+    
+    SalidaDatos *historial = salida_abrir("orden_superior.dat", FORMATO_SALIDA, "orden iter x error",
+                                          "%.0f %.0f %.15f %.6e\n");
+    ResultadoOrden r[HOUSEHOLDER_CUARTO + 1];
+    double ns[HOUSEHOLDER_CUARTO + 1];
+    for (int orden = HOUSEHOLDER_NEWTON; orden <= HOUSEHOLDER_CUARTO; orden++) {
+        r[orden] = iterar_householder(X_INICIAL, orden, origen, historial);
+        ns[orden] = medir_householder(orden, origen);
+    }
+    salida_cerrar(historial);
+    
+    // Referencia: la raiz del metodo de mayor orden que convergio
+    double referencia = r[HOUSEHOLDER_NEWTON].raiz;
+    int convergieron = 1;
+    for (int orden = HOUSEHOLDER_NEWTON; orden <= HOUSEHOLDER_CUARTO; orden++) {
+        if (r[orden].convergio) referencia = r[orden].raiz;
+        convergieron &= r[orden].convergio;
+    }
+    
+    printf("+-------------+-------+------+-------+-------+-----------+-------+------------+-----------+\n");
+    printf("|   Metodo    | Orden | Iter | Ev. f | Ev. f'|  f''/f''' | Total | Tiempo (ns)| |x - ref| |\n");
+    printf("+-------------+-------+------+-------+-------+-----------+-------+------------+-----------+\n");
+    for (int orden = HOUSEHOLDER_NEWTON; orden <= HOUSEHOLDER_CUARTO; orden++) {
+        ConteoEvaluaciones *ev = &r[orden].ev;
+        printf("| %-11s | %5d | %4d | %5ld | %5ld | %9ld | %5ld | %10.1f | %9.2e |%s\n",
+               nombres[orden], orden + 1, r[orden].iteraciones, ev->f, ev->df, ev->superiores,
+               ev->f + ev->df + ev->superiores, ns[orden], fabs(r[orden].raiz - referencia),
+               r[orden].convergio ? "" : " SIN CONVERGENCIA");
+    }
+    printf("+-------------+-------+------+-------+-------+-----------+-------+------------+-----------+\n");
+    
+    printf("\n RESULTADOS:\n");
+    printf("-------------------------------------------------------------\n");
+    printf("  Raiz de referencia: x = %.15f\n", referencia);
+    printf("  Tiempo:             por resolucion completa desde x0 (>= %.0f ms de repeticiones)\n",
+           ORDEN_TIEMPO_MINIMO * 1e3);
+    printf("\n  - %s -> Iteraciones por metodo\n",
+           nombre_salida("orden_superior.dat", FORMATO_SALIDA));
+    
+    return convergieron ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// ============================================================================
+// MICRO-BENCHMARKS (BENCHMARK=1 ./newtonrhapson)
+// ============================================================================
+// Una unidad = una iteracion de Newton (una evaluacion de FUNCION y una de
+// DERIVADA). Los arranques cubren [GRAFICO_INICIO, GRAFICO_FIN]. Con n = 1 el
+// bloque recorre el mismo camino que un arranque escalar.
+typedef struct {
+    int n;
+    double x0[MULTI_BLOQUE], raiz[MULTI_BLOQUE];
+    int iteraciones[MULTI_BLOQUE], estado[MULTI_BLOQUE];
+} ContextoNewton;
+
+ConteoBench bench_newton(void *contexto, long llamadas) {
+    ContextoNewton *c = contexto;
+    double iteraciones = 0;
+    
+    for (long i = 0; i < llamadas; i++) {
+        const double *x0 = c->x0 + (c->n == 1 ? i % MULTI_BLOQUE : 0);
+        newton_bloque(x0, c->raiz, c->iteraciones, c->estado, c->n);
+        for (int j = 0; j < c->n; j++) iteraciones += c->iteraciones[j];
+    }
+    bench_sumidero += c->raiz[0];
+    return (ConteoBench){ iteraciones, 2 * iteraciones };
+}
+
+int ejecutar_benchmark() {
+    static ContextoNewton c;
+    
+    for (int i = 0; i < MULTI_BLOQUE; i++) {
+        c.x0[i] = GRAFICO_INICIO + (i + 0.5) * (GRAFICO_FIN - GRAFICO_INICIO) / MULTI_BLOQUE;
+    }
+    
+    bench_encabezado("newtonrhapson");
+    c.n = 1;
+    bench_medir("newtonrhapson", "newton_bloque(n=1)", "iteracion", bench_newton, &c);
+    c.n = MULTI_BLOQUE;
+    bench_medir("newtonrhapson", "newton_bloque", "iteracion", bench_newton, &c);
+    bench_pie();
+    return EXIT_SUCCESS;
+}
+
+// f y f' de una iteracion del programa principal
+void evaluar_iteracion(double x, double *fx, double *dfx) {
+    *fx = EVAL_FUNCION(x);
+    *dfx = EVAL_DERIVADA(x);
+    VALIDAR(*fx);
+    VALIDAR(*dfx);
+}
+
 int main() {
     double x = X_INICIAL, x_nuevo, error;
     int iter = 0;
@@ -119,6 +810,14 @@ int main() {
     // VALIDACION INICIAL DE PARAMS
     // ============================================================================
     printf(" Validando parametros iniciales...\n");
+    validacion_iniciar(NIVEL_VALIDACION);
+    validar_magnitud = 1;
+    grafico_iniciar_motor(MOTOR_GRAFICO);
+    cargar_expresiones();
+    
+    if (bench_solicitado()) {
+        return ejecutar_benchmark();
+    }
     
     if (!es_numerico_valido(X_INICIAL)) {
         printf("ERROR: Valor inicial X_INICIAL invalido: %f\n", X_INICIAL);
@@ -135,8 +834,24 @@ int main() {
         return EXIT_FAILURE;
     }
     
-    double fx_inicial = FUNCION(x);
-    double dfx_inicial = DERIVADA(x);
+    if (MODO_HIBRIDO) {
+        return ejecutar_hibrido();
+    }
+    
+    if (MODO_ORDEN_SUPERIOR) {
+        return ejecutar_orden_superior();
+    }
+    
+    if (MODO_MULTIARRANQUE) {
+        if (MULTI_PUNTOS <= 0) {
+            printf("ERROR: MULTI_PUNTOS debe ser positivo: %d\n", MULTI_PUNTOS);
+            return EXIT_FAILURE;
+        }
+        return ejecutar_multiarranque();
+    }
+    
+    double fx_inicial = EVAL_FUNCION(x);
+    double dfx_inicial = EVAL_DERIVADA(x);
     
     VALIDAR(fx_inicial);
     VALIDAR(dfx_inicial);
@@ -149,16 +864,17 @@ int main() {
     printf(" METODO DE NEWTON-RAPHSON \n\n");
     
     printf("CONFIGURACION:\n");
-    printf("  Funcion:          f(x) = x3 - 2x - 5\n");
+    printf("  Funcion:          f(x) = %s\n", texto_funcion());
     printf("  Valor inicial:    x0 = %.1f, f(x0) = %.3f\n", X_INICIAL, fx_inicial);
     printf("  Derivada inicial: f'(x0) = %.3f\n", dfx_inicial);
     printf("  Tolerancia:       %.1e\n", TOLERANCIA);
     printf("  Max iteraciones:  %d\n\n", MAX_ITER);
     
     // Archivos
-    FILE *datos = abrir_archivo("iteraciones.dat", "w");
-    fprintf(datos, "# iter x f(x) error\n");
+    SalidaDatos *datos = salida_abrir("iteraciones.dat", FORMATO_SALIDA, "iter x f(x) error",
+                                      "%.0f %.6f %.6f %.6f\n");
     
+    if (motor_grafico == MOTOR_SVG) preparar_grafico();
     generar_datos_funcion();
     
     printf("PROCESO DE CALCULO:\n");
@@ -170,11 +886,14 @@ int main() {
     // NEWTON-RAPHSON CON VALIDACIONES
     // ============================================================================
     do {
-        double fx = FUNCION(x);
-        double dfx = DERIVADA(x);
-        
-        VALIDAR(fx);
-        VALIDAR(dfx);
+        // f y f' (en el nivel PASO, un lote por iteracion)
+        double fx, dfx;
+        validacion_abrir_lote();
+        evaluar_iteracion(x, &fx, &dfx);
+        if (validacion_cerrar_lote("iteracion", iter)) {
+            evaluar_iteracion(x, &fx, &dfx);
+            validacion_fin_repeticion();
+        }
         
         // Validacion de derivada
         if (fabs(dfx) < 1e-15) {
@@ -184,7 +903,7 @@ int main() {
             printf("|   f(x) = %.6f                                        |\n", fx);
             printf("|   El metodo no puede continuar                        |\n");
             printf("+-----------------------------------------------------+\n");
-            fclose(datos);
+            salida_cerrar(datos);
             return EXIT_FAILURE;
         }
         
@@ -209,7 +928,8 @@ int main() {
         printf("| %3d | %9.6f | %9.6f | %9.6f | %9.6f |\n", 
                iter, x, fx, dfx, error);
         
-        fprintf(datos, "%d %.6f %.6f %.6f\n", iter, x, fx, error);
+        SALIDA_FILA(datos, iter, x, fx, error);
+        if (motor_grafico == MOTOR_SVG) grafico_punto(&grafico, SERIE_ITERACIONES, x, fx);
         
         // Actualizar
         x = x_nuevo;
@@ -237,10 +957,10 @@ int main() {
         
     } while (1);
     
-    fclose(datos);
+    salida_cerrar(datos);
     
     // Validar resultado final
-    double fx_final = FUNCION(x);
+    double fx_final = EVAL_FUNCION(x);
     VALIDAR(fx_final);
     
     if (fabs(fx_final) > 0.1) {
@@ -251,8 +971,13 @@ int main() {
     // ============================================================================
     // GENERAR 
     // ============================================================================
-    crear_script_gnuplot(x);
-    int grafico_ok = ejecutar_gnuplot();
+    int grafico_ok;
+    if (motor_grafico == MOTOR_SVG) {
+        grafico_ok = graficar_svg(x);
+    } else {
+        crear_script_gnuplot(x);
+        grafico_ok = ejecutar_gnuplot();
+    }
     
     // ============================================================================
     // RESULTADOS FINALES
@@ -270,11 +995,14 @@ int main() {
     
     printf("\n ARCHIVOS GENERADOS:\n");
     printf("-------------------------------------------------------------\n");
-    printf("  - iteraciones.dat   -> %d iteraciones guardadas\n", iter);
-    printf("  - funcion.dat       -> Puntos para graficar\n");
-    printf("  - newton_plot.gp    -> Script de Gnuplot\n");
+    printf("  - %s   -> %d iteraciones guardadas\n", nombre_salida("iteraciones.dat", FORMATO_SALIDA), iter);
+    printf("  - %s       -> Puntos para graficar\n", nombre_salida("funcion.dat", FORMATO_SALIDA));
+    if (motor_grafico == MOTOR_GNUPLOT) {
+        printf("  - newton_plot.gp    -> Script de Gnuplot\n");
+    }
     if (grafico_ok) {
-        printf("  - %s -> Grafico final\n", NOMBRE_GRAFICO);
+        printf("  - %s -> Grafico final\n",
+               (motor_grafico == MOTOR_SVG) ? grafico_nombre_svg(NOMBRE_GRAFICO) : NOMBRE_GRAFICO);
     }
     
     return EXIT_SUCCESS;
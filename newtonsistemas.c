@@ -5,6 +5,12 @@
 #include <math.h>
 #include <stdlib.h>
 #include <errno.h>
+#include "nucleo.h"
+#include "datos_columnar.h"
+#include "expresion.h"
+#include "hiperdual.h"
+#include "benchmark.h"
+#include "grafico.h"
 
 // ============================================================================
 // PARAMETROS CONFIGURABLES
@@ -22,74 +28,306 @@
 #define GRAFICO_RANGO_X     3.0
 #define GRAFICO_RANGO_Y     3.0
 #define GRAFICO_PUNTOS      200
-#define NOMBRE_GRAFICO      "sistema_grafico.png"
+#define FORMATO_SALIDA      FORMATO_TEXTO    // FORMATO_TEXTO o FORMATO_BINARIO
+#define NIVEL_VALIDACION    VALIDACION_OPERACION  // _OPERACION, _PASO o _NINGUNA (o entorno VALIDACION)
+#define MODO_CUENCAS        0          // 1 = mapa de cuencas de atraccion
+#define CUENCAS_RESOLUCION  1024       // Pixeles por lado (p. ej. 4096)
+#define MODO_SISTEMA_N      0          // 1 = sistema de DIMENSION_N ecuaciones (FN, DFN)
+#define DIMENSION_N         200        // Incognitas del sistema de N ecuaciones
+#define METODO_N            METODO_NEWTON  // METODO_NEWTON o METODO_BROYDEN
+// Ecuacion i del sistema de N (funcion tridiagonal de Broyden) y su Jacobiano
+#define FN(i,x,n)           ((3 - 2*(x)[i])*(x)[i] - ((i) > 0 ? (x)[(i)-1] : 0) \
+                             - 2*((i) < (n)-1 ? (x)[(i)+1] : 0) + 1)
+#define DFN(i,j,x,n)        ((j) == (i) ? 3 - 4*(x)[i] : (j) == (i)-1 ? -1.0 : (j) == (i)+1 ? -2.0 : 0.0)
+#define XN_INICIAL(i)       (-1.0)
+#define JACOBIANO           JACOBIANO_ANALITICO  // JACOBIANO_ANALITICO, JACOBIANO_DIFERENCIAS o JACOBIANO_COLOREADO
+#define MOTOR_GRAFICO       MOTOR_GNUPLOT    // MOTOR_GNUPLOT o MOTOR_SVG (o entorno GRAFICO)
+#define NOMBRE_GRAFICO      "sistema_grafico.png" // Con MOTOR_SVG: sistema_grafico.svg
 #define ANCHO_GRAFICO       900
 #define ALTO_GRAFICO        700
 // ============================================================================
 
+#define CUENCAS_TILE        64         // Lado del bloque de pixeles por tarea
+#define CUENCAS_MAX_RAICES  254        // Indices 1..254 en la imagen (0 = sin convergencia)
+
+#define METODO_NEWTON       0          // Jacobiano y LU en cada iteracion
+#define METODO_BROYDEN      1          // Actualizacion de rango uno de la inversa
+#define BROYDEN_REDUCCION   0.5        // Reevaluar J si ||F|| no baja al menos este factor
+
+#define JACOBIANO_ANALITICO     0      // DF1_DX ... DF2_DY / DFN
+#define JACOBIANO_DIFERENCIAS   1      // Diferencias finitas, una columna por evaluacion de F
+#define JACOBIANO_COLOREADO     2      // Patron de dispersion + coloreo de columnas + LU en banda
+
+// Funciones definidas en tiempo de ejecucion: las variables de entorno F1, F2,
+// DF1_DX, DF1_DY, DF2_DX y DF2_DY (todas juntas) reemplazan a las macros, p. ej.
+//   F1="x^2 + y^2 - 4" F2="exp(x) + y - 1" DF1_DX="2*x" ... ./newtonsistemas
+// Con solo F1 y F2 el Jacobiano se obtiene por diferenciacion automatica.
+Expresion expr_f1, expr_f2, expr_df1_dx, expr_df1_dy, expr_df2_dx, expr_df2_dy;
+
+#define EVAL_F1(x,y)        (expr_f1.activa ? expr_evaluar_2(&expr_f1, (x), (y)) : F1(x,y))
+#define EVAL_F2(x,y)        (expr_f2.activa ? expr_evaluar_2(&expr_f2, (x), (y)) : F2(x,y))
+#define EVAL_DF1_DX(x,y)    (expr_df1_dx.activa ? expr_evaluar_2(&expr_df1_dx, (x), (y)) : DF1_DX(x,y))
+#define EVAL_DF1_DY(x,y)    (expr_df1_dy.activa ? expr_evaluar_2(&expr_df1_dy, (x), (y)) : DF1_DY(x,y))
+#define EVAL_DF2_DX(x,y)    (expr_df2_dx.activa ? expr_evaluar_2(&expr_df2_dx, (x), (y)) : DF2_DX(x,y))
+#define EVAL_DF2_DY(x,y)    (expr_df2_dy.activa ? expr_evaluar_2(&expr_df2_dy, (x), (y)) : DF2_DY(x,y))
+
 // ============================================================================
 // FUNCIONES DE VALIDACION
 // ============================================================================
-int es_numerico_valido(double valor) {
-    return !(isnan(valor) || isinf(valor) || fabs(valor) > 1e100);
+void validar_punto(double x, double y, const char *contexto) {
+    if (!es_numerico_valido(x) || !es_numerico_valido(y)) {
+        printf("ERROR en %s: Punto invalido (%.6f, %.6f)\n", contexto, x, y);
+        exit(EXIT_FAILURE);
+    }
 }
 
-void verificar_nan_inf(const char *nombre, double valor, int linea) {
-    if (isnan(valor)) {
-        printf("ERROR en linea %d: %s = NaN\n", linea, nombre);
-        exit(EXIT_FAILURE);
+// ============================================================================
+// ALGEBRA LINEAL (LU CON PIVOTEO PARCIAL)
+// ============================================================================
+// a es n x n por filas y se sobrescribe con L (diagonal unitaria, implicita)
+// y U. piv[k] es la fila intercambiada con la k en el paso k. Devuelve 0, o
+// -1 si un pivote queda por debajo de 1e-15 (matriz singular).
+int factorizar_lu(int n, double *a, int *piv) {
+    for (int k = 0; k < n; k++) {
+        int p = k;
+        for (int i = k + 1; i < n; i++) {
+            if (fabs(a[i*n + k]) > fabs(a[p*n + k])) p = i;
+        }
+        piv[k] = p;
+        if (!(fabs(a[p*n + k]) >= 1e-15)) return -1;
+        
+        if (p != k) {
+            for (int j = 0; j < n; j++) {
+                double t = a[k*n + j];
+                a[k*n + j] = a[p*n + j];
+                a[p*n + j] = t;
+            }
+        }
+        
+        double inv = 1.0 / a[k*n + k];
+        for (int i = k + 1; i < n; i++) {
+            double l = a[i*n + k] * inv;
+            a[i*n + k] = l;
+            if (l == 0.0) continue;
+            #pragma omp simd
+            for (int j = k + 1; j < n; j++) a[i*n + j] -= l * a[k*n + j];
+        }
     }
-    if (isinf(valor)) {
-        printf("ERROR en linea %d: %s = Infinito\n", linea, nombre);
-        exit(EXIT_FAILURE);
+    return 0;
+}
+
+// Resuelve A x = b con la factorizacion anterior; b se sobrescribe con x
+void sustituir_lu(int n, const double *lu, const int *piv, double *b) {
+    for (int k = 0; k < n; k++) {
+        if (piv[k] != k) {
+            double t = b[k];
+            b[k] = b[piv[k]];
+            b[piv[k]] = t;
+        }
     }
-    if (!es_numerico_valido(valor)) {
-        printf("ERROR en linea %d: %s = Valor invalido\n", linea, nombre);
-        exit(EXIT_FAILURE);
+    for (int i = 1; i < n; i++) {
+        double suma = b[i];
+        for (int j = 0; j < i; j++) suma -= lu[i*n + j] * b[j];
+        b[i] = suma;
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        double suma = b[i];
+        for (int j = i + 1; j < n; j++) suma -= lu[i*n + j] * b[j];
+        b[i] = suma / lu[i*n + i];
     }
 }
 
-#define VALIDAR(variable) verificar_nan_inf(#variable, variable, __LINE__)
+double determinante_lu(int n, const double *lu, const int *piv) {
+    double det = 1.0;
+    for (int k = 0; k < n; k++) {
+        det *= lu[k*n + k];
+        if (piv[k] != k) det = -det;
+    }
+    return det;
+}
 
-void validar_punto(double x, double y, const char *contexto) {
-    if (!es_numerico_valido(x) || !es_numerico_valido(y)) {
-        printf("ERROR en %s: Punto invalido (%.6f, %.6f)\n", contexto, x, y);
-        exit(EXIT_FAILURE);
+// Matriz en banda con kl subdiagonales y ku superdiagonales, por columnas como
+// en LAPACK: A(i,j) en ab[kl + ku + i - j + j*ldab], ldab = 2*kl + ku + 1. Las
+// kl filas extra guardan el relleno de los intercambios. Coste O(n kl (kl+ku)).
+#define BANDA(ab, ldab, kv, i, j)   (ab)[(kv) + (i) - (j) + (long)(j) * (ldab)]
+
+int factorizar_lu_banda(int n, int kl, int ku, double *ab, int *piv) {
+    int kv = kl + ku, ldab = 2*kl + ku + 1;
+    int ju = 0;     // Ultima columna alcanzada por los intercambios
+    
+    for (int j = 0; j < n; j++) {
+        int km = (kl < n - 1 - j) ? kl : n - 1 - j;
+        int p = 0;
+        for (int i = 1; i <= km; i++) {
+            if (fabs(BANDA(ab, ldab, kv, j + i, j)) > fabs(BANDA(ab, ldab, kv, j + p, j))) p = i;
+        }
+        piv[j] = j + p;
+        if (!(fabs(BANDA(ab, ldab, kv, j + p, j)) >= 1e-15)) return -1;
+        
+        int limite = (j + ku + p < n - 1) ? j + ku + p : n - 1;
+        if (limite > ju) ju = limite;
+        
+        if (p != 0) {
+            for (int c = j; c <= ju; c++) {
+                double t = BANDA(ab, ldab, kv, j, c);
+                BANDA(ab, ldab, kv, j, c) = BANDA(ab, ldab, kv, j + p, c);
+                BANDA(ab, ldab, kv, j + p, c) = t;
+            }
+        }
+        
+        double inv = 1.0 / BANDA(ab, ldab, kv, j, j);
+        for (int i = 1; i <= km; i++) BANDA(ab, ldab, kv, j + i, j) *= inv;
+        
+        for (int c = j + 1; c <= ju; c++) {
+            double t = BANDA(ab, ldab, kv, j, c);
+            if (t == 0.0) continue;
+            for (int i = 1; i <= km; i++) {
+                BANDA(ab, ldab, kv, j + i, c) -= BANDA(ab, ldab, kv, j + i, j) * t;
+            }
+        }
     }
+    return 0;
 }
 
-FILE* abrir_archivo(const char *nombre, const char *modo) {
-    FILE *archivo = fopen(nombre, modo);
-    if (archivo == NULL) {
-        printf("ERROR: No se pudo abrir '%s' (modo: %s)\n", nombre, modo);
-        printf("   errno: %d\n", errno);
-        exit(EXIT_FAILURE);
+void sustituir_lu_banda(int n, int kl, int ku, const double *ab, const int *piv, double *b) {
+    int kv = kl + ku, ldab = 2*kl + ku + 1;
+    
+    for (int j = 0; j < n - 1; j++) {
+        int km = (kl < n - 1 - j) ? kl : n - 1 - j;
+        if (piv[j] != j) {
+            double t = b[j];
+            b[j] = b[piv[j]];
+            b[piv[j]] = t;
+        }
+        for (int i = 1; i <= km; i++) b[j + i] -= BANDA(ab, ldab, kv, j + i, j) * b[j];
+    }
+    for (int j = n - 1; j >= 0; j--) {
+        b[j] /= BANDA(ab, ldab, kv, j, j);
+        int inicio = (j - kv > 0) ? j - kv : 0;
+        for (int i = inicio; i < j; i++) b[i] -= BANDA(ab, ldab, kv, i, j) * b[j];
     }
-    return archivo;
 }
 
 // ============================================================================
 // FUNCIONES PRINCIPALES
 // ============================================================================
+void cargar_expresiones() {
+    int n = expr_desde_entorno(&expr_f1, "F1", "x y")
+          + expr_desde_entorno(&expr_f2, "F2", "x y")
+          + expr_desde_entorno(&expr_df1_dx, "DF1_DX", "x y")
+          + expr_desde_entorno(&expr_df1_dy, "DF1_DY", "x y")
+          + expr_desde_entorno(&expr_df2_dx, "DF2_DX", "x y")
+          + expr_desde_entorno(&expr_df2_dy, "DF2_DY", "x y");
+    
+    int solo_funciones = (n == 2 && expr_f1.activa && expr_f2.activa);
+    
+    if (n != 0 && n != 6 && !solo_funciones) {
+        printf("ERROR: Defina F1 y F2, o F1, F2 y sus cuatro derivadas (%d de 6)\n", n);
+        exit(EXIT_FAILURE);
+    }
+    if (solo_funciones) {
+        printf("Jacobiano por diferenciacion automatica de F1 y F2\n");
+    }
+}
+
+// Jacobiano 2x2 {dF1/dx, dF1/dy, dF2/dx, dF2/dy}: derivadas dadas (macros o
+// expresiones), diferenciacion automatica si F1 y F2 son expresiones sin
+// derivadas, o diferencias centrales si JACOBIANO no es JACOBIANO_ANALITICO
+void jacobiano_2d(double x, double y, double *jac) {
+    if (expr_f1.activa && !expr_df1_dx.activa) {
+        HiperDual hx = hd_variable(x, HD_E1), hy = hd_variable(y, HD_E2);
+        HiperDual g1 = expr_evaluar_hd_2(&expr_f1, hx, hy);
+        HiperDual g2 = expr_evaluar_hd_2(&expr_f2, hx, hy);
+        jac[0] = g1.c[HD_E1]; jac[1] = g1.c[HD_E2];
+        jac[2] = g2.c[HD_E1]; jac[3] = g2.c[HD_E2];
+    } else if (JACOBIANO == JACOBIANO_ANALITICO || expr_df1_dx.activa) {
+        jac[0] = EVAL_DF1_DX(x, y); jac[1] = EVAL_DF1_DY(x, y);
+        jac[2] = EVAL_DF2_DX(x, y); jac[3] = EVAL_DF2_DY(x, y);
+    } else {
+        // Paso ~ eps^(1/3) relativo: error de truncamiento y de redondeo parejos
+        double hx = 6e-6 * fmax(1.0, fabs(x)), hy = 6e-6 * fmax(1.0, fabs(y));
+        jac[0] = (EVAL_F1(x + hx, y) - EVAL_F1(x - hx, y)) / (2*hx);
+        jac[1] = (EVAL_F1(x, y + hy) - EVAL_F1(x, y - hy)) / (2*hy);
+        jac[2] = (EVAL_F2(x + hx, y) - EVAL_F2(x - hx, y)) / (2*hx);
+        jac[3] = (EVAL_F2(x, y + hy) - EVAL_F2(x, y - hy)) / (2*hy);
+    }
+}
+
+// ============================================================================
+// GRAFICO EN MEMORIA (MOTOR_SVG)
+// ============================================================================
+// Mismo contenido que sistema_plot.gp: trayectoria de Newton y, para el
+// sistema de las macros, las dos curvas de generar_datos_curvas
+#define SERIE_TRAYECTORIA   0
+#define SERIE_CURVA1        1
+#define SERIE_CURVA2        2
+
+PanelGrafico grafico;
+
+void preparar_grafico() {
+    char titulo[GRAFICO_LARGO_TEXTO];
+    if (expr_f1.activa) {
+        snprintf(titulo, sizeof(titulo), "Sistema: %.60s = 0 y %.60s = 0", expr_f1.texto, expr_f2.texto);
+    } else {
+        snprintf(titulo, sizeof(titulo), "Sistema: x^2+y^2=4 y e^x+y=1");
+    }
+    
+    grafico_iniciar(&grafico, titulo, "x", "y");
+    grafico.leyenda = LEYENDA_DERECHA;
+    grafico.proporcion_igual = 1;
+    grafico_rango_x(&grafico, -GRAFICO_RANGO_X, GRAFICO_RANGO_X);
+    grafico_rango_y(&grafico, -GRAFICO_RANGO_Y, GRAFICO_RANGO_Y);
+    grafico_serie(&grafico, "Trayectoria Newton", "#00AA00", TRAZO_LINEA | TRAZO_PUNTOS, 1.5);
+    if (!expr_f1.activa) {
+        grafico_serie(&grafico, "x^2 + y^2 = 4", "#0066CC", TRAZO_LINEA, 2.0);
+        grafico_serie(&grafico, "e^x + y = 1", "#CC0066", TRAZO_LINEA, 2.0);
+    }
+}
+
+// Devuelve 1 si el grafico se genero, como ejecutar_gnuplot
+int graficar_svg(double sol_x, double sol_y) {
+    char titulo[GRAFICO_LARGO_TEXTO];
+    snprintf(titulo, sizeof(titulo), "Solucion: (%.4f, %.4f)", sol_x, sol_y);
+    int solucion = grafico_serie(&grafico, titulo, "#000000", TRAZO_PUNTOS, 2.0);
+    grafico_punto(&grafico, solucion, sol_x, sol_y);
+    
+    printf("\nGenerando grafico...\n");
+    const char *nombre = grafico_nombre_svg(NOMBRE_GRAFICO);
+    int resultado = grafico_escribir_svg(nombre, ANCHO_GRAFICO, ALTO_GRAFICO, &grafico, 1);
+    grafico_liberar(&grafico);
+    
+    if (resultado != 0) {
+        printf("ADVERTENCIA: No se pudo escribir el grafico SVG\n");
+        return 0;
+    }
+    
+    printf("EXITO: Grafico generado: %s\n", nombre);
+    return 1;
+}
+
+// Curva 1 (x^2 + y^2 = 4) en las columnas x1 y1 y curva 2 (e^x + y = 1) en
+// x2 y2: las dos tienen GRAFICO_PUNTOS + 1 puntos, una fila por punto
 void generar_datos_curvas() {
-    FILE *curvas = abrir_archivo("sistema_curvas.dat", "w");
+    SalidaDatos *curvas = salida_abrir("sistema_curvas.dat", FORMATO_SALIDA, "x1 y1 x2 y2",
+                                       "%.6f %.6f %.6f %.6f\n");
     
-    fprintf(curvas, "# Curva 1: x^2 + y^2 = 4\n");
     for (int i = 0; i <= GRAFICO_PUNTOS; i++) {
         double t = 2 * M_PI * i / GRAFICO_PUNTOS;
         double x = 2 * cos(t);
         double y = 2 * sin(t);
         VALIDAR(x); VALIDAR(y);
-        fprintf(curvas, "%.6f %.6f\n", x, y);
-    }
-    fprintf(curvas, "\n\n# Curva 2: e^x + y = 1\n");
-    for (int i = 0; i <= GRAFICO_PUNTOS; i++) {
+        
         double xi = -GRAFICO_RANGO_X + (2*GRAFICO_RANGO_X * i / GRAFICO_PUNTOS);
         double yi = 1 - exp(xi);
         VALIDAR(xi); VALIDAR(yi);
-        fprintf(curvas, "%.6f %.6f\n", xi, yi);
+        
+        SALIDA_FILA(curvas, x, y, xi, yi);
+        if (motor_grafico == MOTOR_SVG && !expr_f1.activa) {
+            grafico_punto(&grafico, SERIE_CURVA1, x, y);
+            grafico_punto(&grafico, SERIE_CURVA2, xi, yi);
+        }
     }
-    fclose(curvas);
+    salida_cerrar(curvas);
 }
 
 void crear_script_gnuplot(double sol_x, double sol_y) {
@@ -99,7 +337,11 @@ void crear_script_gnuplot(double sol_x, double sol_y) {
     fprintf(gp, "set terminal pngcairo size %d,%d enhanced font 'Arial,10'\n", 
             ANCHO_GRAFICO, ALTO_GRAFICO);
     fprintf(gp, "set output '%s'\n", NOMBRE_GRAFICO);
-    fprintf(gp, "set title 'Sistema: x^2+y^2=4 y e^x+y=1'\n");
+    if (expr_f1.activa) {
+        fprintf(gp, "set title 'Sistema: %s = 0 y %s = 0'\n", expr_f1.texto, expr_f2.texto);
+    } else {
+        fprintf(gp, "set title 'Sistema: x^2+y^2=4 y e^x+y=1'\n");
+    }
     fprintf(gp, "set xlabel 'x'\n");
     fprintf(gp, "set ylabel 'y'\n");
     fprintf(gp, "set grid\n");
@@ -108,10 +350,20 @@ void crear_script_gnuplot(double sol_x, double sol_y) {
     fprintf(gp, "set yrange [%lf:%lf]\n", -GRAFICO_RANGO_Y, GRAFICO_RANGO_Y);
     fprintf(gp, "set key box opaque\n\n");
     
-    fprintf(gp, "plot 'sistema_curvas.dat' index 0 w l lw 2 lc rgb '#0066CC' title 'x^2 + y^2 = 4', \\\n");
-    fprintf(gp, "     'sistema_curvas.dat' index 1 w l lw 2 lc rgb '#CC0066' title 'e^x + y = 1', \\\n");
-    fprintf(gp, "     'sistema_trayectoria.dat' w l lw 1.5 lc rgb '#00AA00' title 'Trayectoria Newton', \\\n");
-    fprintf(gp, "     'sistema_trayectoria.dat' w p pt 7 ps 1 lc rgb '#00AA00' notitle, \\\n");
+    // Las curvas de sistema_curvas.dat corresponden al sistema de las macros
+    if (expr_f1.activa) {
+        fprintf(gp, "plot %s w l lw 1.5 lc rgb '#00AA00' title 'Trayectoria Newton', \\\n",
+                fuente_gnuplot("sistema_trayectoria.dat", FORMATO_SALIDA));
+    } else {
+        fprintf(gp, "plot %s u 1:2 w l lw 2 lc rgb '#0066CC' title 'x^2 + y^2 = 4', \\\n",
+                fuente_gnuplot("sistema_curvas.dat", FORMATO_SALIDA));
+        fprintf(gp, "     %s u 3:4 w l lw 2 lc rgb '#CC0066' title 'e^x + y = 1', \\\n",
+                fuente_gnuplot("sistema_curvas.dat", FORMATO_SALIDA));
+        fprintf(gp, "     %s w l lw 1.5 lc rgb '#00AA00' title 'Trayectoria Newton', \\\n",
+                fuente_gnuplot("sistema_trayectoria.dat", FORMATO_SALIDA));
+    }
+    fprintf(gp, "     %s w p pt 7 ps 1 lc rgb '#00AA00' notitle, \\\n",
+            fuente_gnuplot("sistema_trayectoria.dat", FORMATO_SALIDA));
     fprintf(gp, "     %lf, %lf w p pt 9 ps 2 lc rgb '#000000' title 'Solucion: (%.4f, %.4f)'\n", 
             sol_x, sol_y, sol_x, sol_y);
     
@@ -132,6 +384,680 @@ int ejecutar_gnuplot() {
     return 1;
 }
 
+// ============================================================================
+// MAPA DE CUENCAS DE ATRACCION
+// ============================================================================
+// Newton completo desde (x, y) con los mismos criterios que main() pero sin
+// E/S ni salidas abortivas: todo el estado vive en registros. Devuelve 1 si
+// converge y deja el punto final en (*x_fin, *y_fin).
+int newton_pixel(double x, double y, double *x_fin, double *y_fin, int *iteraciones) {
+    for (int iter = 1; iter <= MAX_ITER; iter++) {
+        double f1 = EVAL_F1(x, y);
+        double f2 = EVAL_F2(x, y);
+        double jac[4];
+        jacobiano_2d(x, y, jac);
+        double df1_dx = jac[0], df1_dy = jac[1];
+        double df2_dx = jac[2], df2_dy = jac[3];
+        
+        double det = df1_dx*df2_dy - df1_dy*df2_dx;
+        if (!(fabs(det) >= 1e-15)) {
+            *iteraciones = iter;
+            return 0;
+        }
+        
+        double dx = (-f1*df2_dy + f2*df1_dy) / det;
+        double dy = (-df1_dx*f2 + f1*df2_dx) / det;
+        double error = sqrt(dx*dx + dy*dy);
+        
+        x += dx;
+        y += dy;
+        
+        if (!es_numerico_valido(x) || !es_numerico_valido(y) || (error > 1e5 && iter > 3)) {
+            *iteraciones = iter;
+            return 0;
+        }
+        
+        if (error < TOLERANCIA) {
+            *x_fin = x;
+            *y_fin = y;
+            *iteraciones = iter;
+            return 1;
+        }
+    }
+    
+    *iteraciones = MAX_ITER;
+    return 0;
+}
+
+// Devuelve el indice (1..n) de la raiz en el catalogo, agregandola si es nueva.
+// Cada raiz guarda el menor (x, y) de sus pixeles, que no depende del orden
+// de llegada.
+int catalogar_raiz(double x, double y, double *raices_x, double *raices_y, int *n_raices) {
+    double tol = 1000 * TOLERANCIA;
+    for (int k = 0; k < *n_raices; k++) {
+        if (fabs(raices_x[k] - x) <= tol && fabs(raices_y[k] - y) <= tol) {
+            if (x < raices_x[k] || (x == raices_x[k] && y < raices_y[k])) {
+                raices_x[k] = x;
+                raices_y[k] = y;
+            }
+            return k + 1;
+        }
+    }
+    if (*n_raices >= CUENCAS_MAX_RAICES) return 0;
+    raices_x[*n_raices] = x;
+    raices_y[*n_raices] = y;
+    return ++(*n_raices);
+}
+
+// Ordena el catalogo lexicograficamente por (x, y) y deja en remap[] el nuevo
+// indice de cada raiz (remap[0] = 0), para que la numeracion no dependa del
+// orden en que los hilos terminaron sus tiles
+void ordenar_raices(double *raices_x, double *raices_y, int n_raices, unsigned char *remap) {
+    int orden[CUENCAS_MAX_RAICES];
+    for (int k = 0; k < n_raices; k++) orden[k] = k;
+    
+    for (int i = 1; i < n_raices; i++) {
+        int actual = orden[i];
+        int j = i - 1;
+        while (j >= 0 && (raices_x[orden[j]] > raices_x[actual] ||
+                          (raices_x[orden[j]] == raices_x[actual] &&
+                           raices_y[orden[j]] > raices_y[actual]))) {
+            orden[j + 1] = orden[j];
+            j--;
+        }
+        orden[j + 1] = actual;
+    }
+    
+    double copia_x[CUENCAS_MAX_RAICES], copia_y[CUENCAS_MAX_RAICES];
+    remap[0] = 0;
+    for (int k = 0; k < n_raices; k++) {
+        copia_x[k] = raices_x[orden[k]];
+        copia_y[k] = raices_y[orden[k]];
+        remap[orden[k] + 1] = (unsigned char)(k + 1);
+    }
+    for (int k = 0; k < n_raices; k++) {
+        raices_x[k] = copia_x[k];
+        raices_y[k] = copia_y[k];
+    }
+}
+
+// Reescribe fila a fila los indices de raiz de una imagen PGM ya volcada
+void remapear_pgm(FILE *img, long cabecera, int n, const unsigned char *remap) {
+    unsigned char fila[CUENCAS_RESOLUCION];
+    for (int f = 0; f < n; f++) {
+        long posicion = cabecera + (long)f * n;
+        fseek(img, posicion, SEEK_SET);
+        if (fread(fila, 1, n, img) != (size_t)n) {
+            printf(" ERROR: No se pudo releer sistema_cuencas_raiz.pgm\n");
+            exit(EXIT_FAILURE);
+        }
+        for (int c = 0; c < n; c++) fila[c] = remap[fila[c]];
+        fseek(img, posicion, SEEK_SET);
+        fwrite(fila, 1, n, img);
+    }
+}
+
+// Escribe las filas de un tile terminado en una imagen PGM ya abierta
+void escribir_tile_pgm(FILE *img, long cabecera, const unsigned char *tile,
+                       int col0, int fila0, int ancho_tile, int alto_tile) {
+    for (int f = 0; f < alto_tile; f++) {
+        fseek(img, cabecera + (long)(fila0 + f) * CUENCAS_RESOLUCION + col0, SEEK_SET);
+        fwrite(tile + f * CUENCAS_TILE, 1, ancho_tile, img);
+    }
+}
+
+// Imagen de N x N sobre [-GRAFICO_RANGO_X, GRAFICO_RANGO_X] x
+// [-GRAFICO_RANGO_Y, GRAFICO_RANGO_Y], repartida en tiles entre hilos (OpenMP).
+// Cada tile se calcula en memoria local y solo al terminar se cataloga y se
+// vuelca a disco: sistema_cuencas_raiz.pgm (indice de raiz, 0 = no converge)
+// y sistema_cuencas_iter.pgm (iteraciones, saturadas en 255). Al final el
+// catalogo se ordena y los indices se renumeran en disco, asi la imagen es
+// la misma con cualquier numero de hilos.
+int ejecutar_cuencas() {
+    int n = CUENCAS_RESOLUCION;
+    int tiles_lado = (n + CUENCAS_TILE - 1) / CUENCAS_TILE;
+    double paso_x = 2*GRAFICO_RANGO_X / n;
+    double paso_y = 2*GRAFICO_RANGO_Y / n;
+    
+    double raices_x[CUENCAS_MAX_RAICES], raices_y[CUENCAS_MAX_RAICES];
+    int n_raices = 0;
+    long pixeles_convergentes = 0, iteraciones_totales = 0;
+    
+    printf("===============================================================\n");
+    printf("          CUENCAS DE ATRACCION DE NEWTON (2D)                 \n");
+    printf("===============================================================\n\n");
+    printf("  Resolucion:  %d x %d pixeles\n", n, n);
+    printf("  Ventana:     [%.1f, %.1f] x [%.1f, %.1f]\n",
+           -GRAFICO_RANGO_X, GRAFICO_RANGO_X, -GRAFICO_RANGO_Y, GRAFICO_RANGO_Y);
+    printf("  Tiles:       %d x %d de %d pixeles\n\n", tiles_lado, tiles_lado, CUENCAS_TILE);
+    
+    FILE *img_raiz = abrir_archivo("sistema_cuencas_raiz.pgm", "w+b");
+    FILE *img_iter = abrir_archivo("sistema_cuencas_iter.pgm", "wb");
+    fprintf(img_raiz, "P5\n%d %d\n255\n", n, n);
+    fprintf(img_iter, "P5\n%d %d\n255\n", n, n);
+    long cabecera_raiz = ftell(img_raiz);
+    long cabecera_iter = ftell(img_iter);
+    
+    double inicio = bench_tiempo();
+    
+    #pragma omp parallel for schedule(dynamic)
+    for (int t = 0; t < tiles_lado * tiles_lado; t++) {
+        int col0 = (t % tiles_lado) * CUENCAS_TILE;
+        int fila0 = (t / tiles_lado) * CUENCAS_TILE;
+        int ancho = (n - col0 < CUENCAS_TILE) ? n - col0 : CUENCAS_TILE;
+        int alto = (n - fila0 < CUENCAS_TILE) ? n - fila0 : CUENCAS_TILE;
+        
+        unsigned char tile_raiz[CUENCAS_TILE * CUENCAS_TILE];
+        unsigned char tile_iter[CUENCAS_TILE * CUENCAS_TILE];
+        double fin_x[CUENCAS_TILE * CUENCAS_TILE], fin_y[CUENCAS_TILE * CUENCAS_TILE];
+        long iter_tile = 0;
+        
+        for (int f = 0; f < alto; f++) {
+            double y0 = GRAFICO_RANGO_Y - (fila0 + f + 0.5) * paso_y;
+            for (int c = 0; c < ancho; c++) {
+                double x0 = -GRAFICO_RANGO_X + (col0 + c + 0.5) * paso_x;
+                int k = f * CUENCAS_TILE + c;
+                int iteraciones;
+                
+                tile_raiz[k] = newton_pixel(x0, y0, &fin_x[k], &fin_y[k], &iteraciones);
+                tile_iter[k] = (iteraciones > 255) ? 255 : iteraciones;
+                iter_tile += iteraciones;
+            }
+        }
+        
+        // Tile terminado: catalogar raices y volcar a disco
+        #pragma omp critical
+        {
+            for (int f = 0; f < alto; f++) {
+                for (int c = 0; c < ancho; c++) {
+                    int k = f * CUENCAS_TILE + c;
+                    if (tile_raiz[k]) {
+                        tile_raiz[k] = catalogar_raiz(fin_x[k], fin_y[k], raices_x, raices_y, &n_raices);
+                        pixeles_convergentes++;
+                    }
+                }
+            }
+            iteraciones_totales += iter_tile;
+            escribir_tile_pgm(img_raiz, cabecera_raiz, tile_raiz, col0, fila0, ancho, alto);
+            escribir_tile_pgm(img_iter, cabecera_iter, tile_iter, col0, fila0, ancho, alto);
+        }
+    }
+    
+    // Numeracion determinista: catalogo ordenado por (x, y)
+    unsigned char remap[CUENCAS_MAX_RAICES + 1];
+    ordenar_raices(raices_x, raices_y, n_raices, remap);
+    remapear_pgm(img_raiz, cabecera_raiz, n, remap);
+    
+    double segundos = bench_tiempo() - inicio;
+    
+    fclose(img_raiz);
+    fclose(img_iter);
+    
+    long total = (long)n * n;
+    printf("RESULTADOS:\n");
+    printf("-----------------------------------------------------------------\n");
+    printf("  Tiempo:               %.3f s (%.3e pixeles/s)\n", segundos, total / segundos);
+    printf("  Pixeles convergentes: %ld de %ld (%.2f%%)\n",
+           pixeles_convergentes, total, 100.0 * pixeles_convergentes / total);
+    printf("  Iteraciones medias:   %.2f\n", (double)iteraciones_totales / total);
+    
+    printf("\n  RAICES ENCONTRADAS:\n");
+    for (int k = 0; k < n_raices; k++) {
+        printf("    [%d] (%.8f, %.8f)\n", k + 1, raices_x[k], raices_y[k]);
+    }
+    
+    printf("\n  EXITO: sistema_cuencas_raiz.pgm -> Indice de raiz por pixel\n");
+    printf("  EXITO: sistema_cuencas_iter.pgm -> Iteraciones por pixel\n");
+    
+    return EXIT_SUCCESS;
+}
+
+// ============================================================================
+// SISTEMAS DE N ECUACIONES
+// ============================================================================
+// Jacobiano segun JACOBIANO:
+//   ANALITICO    DFN en cada entrada, LU densa
+//   DIFERENCIAS  J(:,j) = (F(x + h e_j) - F(x)) / h: n evaluaciones de F, LU densa
+//   COLOREADO    el patron de dispersion se detecta una vez al inicio; las
+//                columnas sin filas en comun comparten color y se perturban
+//                juntas, asi cada Jacobiano cuesta tantas evaluaciones de F
+//                como colores (3 para una tridiagonal). Se factoriza en banda.
+// ============================================================================
+// METODO_NEWTON evalua el Jacobiano (DFN, n^2 entradas) y lo factoriza en
+// cada iteracion. METODO_BROYDEN factoriza J una sola vez y aplica las
+// actualizaciones de rango uno de J^-1 guardando solo los pasos (forma de
+// Kelley): cada iteracion cuesta una sustitucion LU mas O(n k), sin evaluar
+// DFN ni refactorizar. El Jacobiano se reevalua solo si ||F|| no baja al
+// menos BROYDEN_REDUCCION en un paso.
+// ============================================================================
+typedef struct {
+    int iteraciones;
+    long evaluaciones_f;        // Evaluaciones del vector F completo
+    long evaluaciones_j;        // Evaluaciones del Jacobiano completo
+    long evaluaciones_f_jacobiano;  // Evaluaciones de F para ensamblarlos (diferencias)
+    double norma_f, norma_paso;
+    int convergio;
+} ResultadoN;
+
+void evaluar_sistema_n(const double *x, double *f, int n) {
+    for (int i = 0; i < n; i++) f[i] = FN(i, x, n);
+}
+
+void evaluar_jacobiano_n(const double *x, double *jac, int n) {
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) jac[i*n + j] = DFN(i, j, x, n);
+    }
+}
+
+double producto_n(const double *a, const double *b, int n) {
+    double suma = 0.0;
+    for (int i = 0; i < n; i++) suma += a[i] * b[i];
+    return suma;
+}
+
+typedef struct {
+    int n, tipo;
+    double *a;                  // Densa n x n por filas, o banda (ldab x n)
+    int *piv;
+    double *x_pert, *f_pert;    // Trabajo de las diferencias finitas
+    long evaluaciones_f;        // Evaluaciones de F gastadas en Jacobianos
+    // Modo coloreado
+    int *col_inicio, *filas;    // Patron por columnas (CSC)
+    int *color, n_colores;
+    int kl, ku, ldab;
+    long no_nulos;
+} JacobianoN;
+
+// Paso de diferencias hacia adelante ~ sqrt(eps) relativo
+double paso_jacobiano(double x) {
+    return 1.5e-8 * fmax(1.0, fabs(x));
+}
+
+void* reservar_n(size_t bytes) {
+    void *p = calloc(1, bytes);
+    if (p == NULL) {
+        printf("ERROR: Memoria insuficiente (%zu bytes)\n", bytes);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+// Detecta el patron con dos Jacobianos por diferencias (en x0 y en un punto
+// desplazado, para no perder entradas que se anulen por casualidad), y
+// colorea las columnas con el algoritmo voraz.
+void detectar_patron(JacobianoN *J, const double *x0) {
+    int n = J->n;
+    unsigned char *patron = reservar_n((size_t)n * n);
+    double *x = reservar_n(n * sizeof(double));
+    double *f0 = reservar_n(n * sizeof(double));
+    
+    for (int punto = 0; punto < 2; punto++) {
+        for (int i = 0; i < n; i++) x[i] = x0[i] + punto * 0.1 * sin(i + 1.0);
+        evaluar_sistema_n(x, f0, n);
+        J->evaluaciones_f++;
+        for (int j = 0; j < n; j++) {
+            double h = paso_jacobiano(x[j]), guardado = x[j];
+            x[j] += h;
+            evaluar_sistema_n(x, J->f_pert, n);
+            J->evaluaciones_f++;
+            x[j] = guardado;
+            for (int i = 0; i < n; i++) {
+                if (J->f_pert[i] != f0[i]) patron[(size_t)i * n + j] = 1;
+            }
+        }
+    }
+    
+    // CSC del patron, anchos de banda y conteo
+    J->col_inicio = reservar_n((n + 1) * sizeof(int));
+    J->kl = J->ku = 0;
+    J->no_nulos = 0;
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < n; i++) J->no_nulos += patron[(size_t)i * n + j];
+    }
+    J->filas = reservar_n((J->no_nulos > 0 ? J->no_nulos : 1) * sizeof(int));
+    long k = 0;
+    for (int j = 0; j < n; j++) {
+        J->col_inicio[j] = k;
+        for (int i = 0; i < n; i++) {
+            if (!patron[(size_t)i * n + j]) continue;
+            J->filas[k++] = i;
+            if (i - j > J->kl) J->kl = i - j;
+            if (j - i > J->ku) J->ku = j - i;
+        }
+    }
+    J->col_inicio[n] = k;
+    
+    // Coloreo voraz: el color de j es el menor que no usa ninguna columna
+    // anterior con una fila en comun
+    J->color = reservar_n(n * sizeof(int));
+    int *prohibido = reservar_n((n + 1) * sizeof(int));
+    for (int c = 0; c <= n; c++) prohibido[c] = -1;
+    J->n_colores = 0;
+    
+    for (int j = 0; j < n; j++) {
+        for (int p = J->col_inicio[j]; p < J->col_inicio[j+1]; p++) {
+            int i = J->filas[p];
+            for (int q = 0; q < j; q++) {
+                if (patron[(size_t)i * n + q]) prohibido[J->color[q]] = j;
+            }
+        }
+        int c = 0;
+        while (prohibido[c] == j) c++;
+        J->color[j] = c;
+        if (c + 1 > J->n_colores) J->n_colores = c + 1;
+    }
+    
+    free(prohibido);
+    free(patron);
+    free(x);
+    free(f0);
+}
+
+void crear_jacobiano_n(JacobianoN *J, int n, int tipo, const double *x0) {
+    J->n = n;
+    J->tipo = tipo;
+    J->evaluaciones_f = 0;
+    J->piv = reservar_n(n * sizeof(int));
+    J->x_pert = reservar_n(n * sizeof(double));
+    J->f_pert = reservar_n(n * sizeof(double));
+    J->col_inicio = J->filas = J->color = NULL;
+    
+    if (tipo == JACOBIANO_COLOREADO) {
+        detectar_patron(J, x0);
+        J->ldab = 2*J->kl + J->ku + 1;
+        J->a = reservar_n((size_t)J->ldab * n * sizeof(double));
+    } else {
+        J->a = reservar_n((size_t)n * n * sizeof(double));
+    }
+}
+
+void liberar_jacobiano_n(JacobianoN *J) {
+    free(J->a); free(J->piv); free(J->x_pert); free(J->f_pert);
+    free(J->col_inicio); free(J->filas); free(J->color);
+}
+
+// Ensambla J en x (f = F(x)) y lo factoriza. Devuelve 0, o -1 si es singular.
+int actualizar_jacobiano_n(JacobianoN *J, const double *x, const double *f) {
+    int n = J->n;
+    
+    if (J->tipo == JACOBIANO_ANALITICO) {
+        evaluar_jacobiano_n(x, J->a, n);
+        return factorizar_lu(n, J->a, J->piv);
+    }
+    
+    if (J->tipo == JACOBIANO_DIFERENCIAS) {
+        for (int i = 0; i < n; i++) J->x_pert[i] = x[i];
+        for (int j = 0; j < n; j++) {
+            double h = paso_jacobiano(x[j]);
+            J->x_pert[j] = x[j] + h;
+            evaluar_sistema_n(J->x_pert, J->f_pert, n);
+            J->evaluaciones_f++;
+            J->x_pert[j] = x[j];
+            for (int i = 0; i < n; i++) J->a[(size_t)i * n + j] = (J->f_pert[i] - f[i]) / h;
+        }
+        return factorizar_lu(n, J->a, J->piv);
+    }
+    
+    // Coloreado: una evaluacion de F por color, directo a la banda
+    int kv = J->kl + J->ku;
+    for (long k = 0; k < (long)J->ldab * n; k++) J->a[k] = 0.0;
+    
+    for (int c = 0; c < J->n_colores; c++) {
+        for (int j = 0; j < n; j++) {
+            J->x_pert[j] = x[j] + ((J->color[j] == c) ? paso_jacobiano(x[j]) : 0.0);
+        }
+        evaluar_sistema_n(J->x_pert, J->f_pert, n);
+        J->evaluaciones_f++;
+        
+        for (int j = 0; j < n; j++) {
+            if (J->color[j] != c) continue;
+            double h = J->x_pert[j] - x[j];
+            for (int p = J->col_inicio[j]; p < J->col_inicio[j+1]; p++) {
+                int i = J->filas[p];
+                BANDA(J->a, J->ldab, kv, i, j) = (J->f_pert[i] - f[i]) / h;
+            }
+        }
+    }
+    return factorizar_lu_banda(n, J->kl, J->ku, J->a, J->piv);
+}
+
+void resolver_jacobiano_n(const JacobianoN *J, double *b) {
+    if (J->tipo == JACOBIANO_COLOREADO) {
+        sustituir_lu_banda(J->n, J->kl, J->ku, J->a, J->piv, b);
+    } else {
+        sustituir_lu(J->n, J->a, J->piv, b);
+    }
+}
+
+// Resuelve F(x) = 0 desde x (se sobrescribe con la solucion). Si historial
+// no es NULL guarda iter, ||F||, ||dx|| y si se reevaluo J en cada paso.
+ResultadoN resolver_sistema_n(double *x, JacobianoN *J, int metodo, SalidaDatos *historial, int mostrar) {
+    ResultadoN r = {0, 0, 0, 0, 0.0, 0.0, 0};
+    int n = J->n;
+    long evaluaciones_jacobiano = J->evaluaciones_f;
+    double *f = reservar_n(n * sizeof(double));
+    double *pasos = reservar_n((size_t)n * MAX_ITER * sizeof(double));   // Broyden: s_0 .. s_k
+    double normas2[MAX_ITER];
+    
+    evaluar_sistema_n(x, f, n);
+    r.evaluaciones_f++;
+    r.norma_f = sqrt(producto_n(f, f, n));
+    int k = 0;                  // Pasos de Broyden guardados desde el ultimo J
+    int reevaluar = 1;
+    
+    for (int iter = 1; iter <= MAX_ITER; iter++) {
+        int jacobiano_nuevo = (metodo == METODO_NEWTON) || reevaluar;
+        
+        if (jacobiano_nuevo) {
+            r.evaluaciones_j++;
+            if (actualizar_jacobiano_n(J, x, f) != 0) {
+                if (mostrar) printf("ERROR: Jacobiano singular en la iteracion %d\n", iter);
+                break;
+            }
+            reevaluar = 0;
+            k = 0;
+        }
+        
+        // z = -J0^-1 F
+        double *paso = pasos + (size_t)k * n;
+        for (int i = 0; i < n; i++) paso[i] = -f[i];
+        resolver_jacobiano_n(J, paso);
+        
+        // Broyden: z += s_{j+1} (s_j . z) / |s_j|^2 y s_k = z / (1 - s_{k-1} . z / |s_{k-1}|^2)
+        if (metodo == METODO_BROYDEN && k > 0) {
+            for (int j = 0; j < k - 1; j++) {
+                double c = producto_n(pasos + (size_t)j * n, paso, n) / normas2[j];
+                const double *siguiente = pasos + (size_t)(j + 1) * n;
+                for (int i = 0; i < n; i++) paso[i] += c * siguiente[i];
+            }
+            double denominador = 1.0 - producto_n(pasos + (size_t)(k - 1) * n, paso, n) / normas2[k - 1];
+            for (int i = 0; i < n; i++) paso[i] /= denominador;
+        }
+        
+        double norma2 = producto_n(paso, paso, n);
+        for (int i = 0; i < n; i++) x[i] += paso[i];
+        evaluar_sistema_n(x, f, n);
+        r.evaluaciones_f++;
+        
+        double norma_nueva = sqrt(producto_n(f, f, n));
+        r.norma_paso = sqrt(norma2);
+        r.iteraciones = iter;
+        
+        if (!es_numerico_valido(r.norma_paso) || !es_numerico_valido(norma_nueva)) {
+            if (mostrar) printf("ERROR: Valores invalidos en la iteracion %d\n", iter);
+            r.norma_f = norma_nueva;
+            break;
+        }
+        
+        if (metodo == METODO_BROYDEN) {
+            normas2[k++] = norma2;
+            if (norma_nueva > BROYDEN_REDUCCION * r.norma_f || k == MAX_ITER) reevaluar = 1;
+        }
+        r.norma_f = norma_nueva;
+        
+        if (historial != NULL) {
+            SALIDA_FILA(historial, iter, r.norma_f, r.norma_paso, jacobiano_nuevo);
+        }
+        if (mostrar) {
+            printf("| %4d | %12.4e | %12.4e | %s |\n",
+                   iter, r.norma_f, r.norma_paso, jacobiano_nuevo ? "  si  " : "      ");
+        }
+        
+        if (r.norma_paso < TOLERANCIA) {
+            r.convergio = 1;
+            break;
+        }
+    }
+    
+    r.evaluaciones_f_jacobiano = J->evaluaciones_f - evaluaciones_jacobiano;
+    free(f); free(pasos);
+    return r;
+}
+
+int ejecutar_sistema_n() {
+    int n = DIMENSION_N;
+    double *x = malloc(n * sizeof(double));
+    if (x == NULL) {
+        printf("ERROR: Memoria insuficiente para %d incognitas\n", n);
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < n; i++) x[i] = XN_INICIAL(i);
+    
+    printf("===============================================================\n");
+    printf("          SISTEMA DE %d ECUACIONES NO LINEALES              \n", n);
+    printf("===============================================================\n\n");
+    printf("  Metodo:      %s\n", (METODO_N == METODO_BROYDEN)
+           ? "Broyden (actualizacion de rango uno de J^-1)" : "Newton (Jacobiano + LU con pivoteo parcial)");
+    printf("  Tolerancia:  %.1e en ||dx||, maximo %d iteraciones\n", TOLERANCIA, MAX_ITER);
+    
+    JacobianoN J;
+    crear_jacobiano_n(&J, n, JACOBIANO, x);
+    if (JACOBIANO == JACOBIANO_ANALITICO) {
+        printf("  Jacobiano:   analitico (DFN), LU densa\n\n");
+    } else if (JACOBIANO == JACOBIANO_DIFERENCIAS) {
+        printf("  Jacobiano:   diferencias finitas (%d evaluaciones de F), LU densa\n\n", n);
+    } else {
+        printf("  Jacobiano:   coloreado, %ld no nulos (%.2f%%), banda kl = %d, ku = %d\n",
+               J.no_nulos, 100.0 * J.no_nulos / ((double)n * n), J.kl, J.ku);
+        printf("               %d colores -> %d evaluaciones de F por Jacobiano, LU en banda\n",
+               J.n_colores, J.n_colores);
+        printf("               deteccion del patron: %ld evaluaciones de F\n\n", J.evaluaciones_f);
+    }
+    
+    printf("+------+--------------+--------------+--------+\n");
+    printf("| Iter |    ||F||     |    ||dx||    | J nuevo|\n");
+    printf("+------+--------------+--------------+--------+\n");
+    
+    SalidaDatos *historial = salida_abrir("sistema_n.dat", FORMATO_SALIDA, "iter norma_f norma_paso jacobiano",
+                                          "%.0f %.6e %.6e %.0f\n");
+    
+    double inicio = bench_tiempo();
+    ResultadoN r = resolver_sistema_n(x, &J, METODO_N, historial, 1);
+    double segundos = bench_tiempo() - inicio;
+    
+    salida_cerrar(historial);
+    printf("+------+--------------+--------------+--------+\n\n");
+    
+    printf("RESULTADOS:\n");
+    printf("-----------------------------------------------------------------\n");
+    printf("  Estado:               %s\n", r.convergio ? "CONVERGENCIA" : "SIN CONVERGENCIA");
+    printf("  Iteraciones:          %d de %d\n", r.iteraciones, MAX_ITER);
+    printf("  ||F|| final:          %.2e\n", r.norma_f);
+    printf("  Evaluaciones de F:    %ld (%ld funciones escalares)\n",
+           r.evaluaciones_f, r.evaluaciones_f * n);
+    if (JACOBIANO == JACOBIANO_ANALITICO) {
+        printf("  Jacobianos:           %ld (%ld derivadas parciales)\n",
+               r.evaluaciones_j, r.evaluaciones_j * n * n);
+    } else {
+        printf("  Jacobianos:           %ld (%ld evaluaciones de F)\n",
+               r.evaluaciones_j, r.evaluaciones_f_jacobiano);
+    }
+    printf("  Tiempo:               %.3f ms\n", segundos * 1e3);
+    printf("  x[0..%d]:             ", (n < 4 ? n : 4) - 1);
+    for (int i = 0; i < n && i < 4; i++) printf("%.8f ", x[i]);
+    printf("\n\n  EXITO: %s -> Historial de convergencia\n", nombre_salida("sistema_n.dat", FORMATO_SALIDA));
+    
+    liberar_jacobiano_n(&J);
+    free(x);
+    return r.convergio ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// ============================================================================
+// MICRO-BENCHMARKS (BENCHMARK=1 ./newtonsistemas)
+// ============================================================================
+// Una unidad = una iteracion de newton_pixel (seis evaluaciones: F1, F2 y el
+// Jacobiano). Los arranques recorren una malla de 32x32 en el rango grafico.
+ConteoBench bench_newton_pixel(void *contexto, long llamadas) {
+    (void)contexto;
+    double iteraciones = 0, suma = 0;
+    
+    for (long i = 0; i < llamadas; i++) {
+        int ix = i % 32, iy = (i / 32) % 32;
+        double x0 = -GRAFICO_RANGO_X + (ix + 0.5) * 2*GRAFICO_RANGO_X / 32;
+        double y0 = -GRAFICO_RANGO_Y + (iy + 0.5) * 2*GRAFICO_RANGO_Y / 32;
+        double x_fin = 0, y_fin = 0;
+        int iter;
+        
+        newton_pixel(x0, y0, &x_fin, &y_fin, &iter);
+        iteraciones += iter;
+        suma += x_fin + y_fin;
+    }
+    bench_sumidero += suma;
+    return (ConteoBench){ iteraciones, 6 * iteraciones };
+}
+
+// Una unidad = una resolucion completa del sistema de DIMENSION_N ecuaciones
+// desde XN_INICIAL; contexto apunta al metodo
+ConteoBench bench_sistema_n(void *contexto, long llamadas) {
+    int metodo = *(int*)contexto;
+    int n = DIMENSION_N;
+    double *x = malloc(n * sizeof(double));
+    double evaluaciones = 0, suma = 0;
+    
+    if (x == NULL) {
+        printf("ERROR: Memoria insuficiente para %d incognitas\n", n);
+        exit(EXIT_FAILURE);
+    }
+    
+    for (int i = 0; i < n; i++) x[i] = XN_INICIAL(i);
+    JacobianoN J;
+    crear_jacobiano_n(&J, n, JACOBIANO, x);
+    
+    for (long l = 0; l < llamadas; l++) {
+        for (int i = 0; i < n; i++) x[i] = XN_INICIAL(i);
+        ResultadoN r = resolver_sistema_n(x, &J, metodo, NULL, 0);
+        evaluaciones += (double)(r.evaluaciones_f + r.evaluaciones_f_jacobiano) * n;
+        if (JACOBIANO == JACOBIANO_ANALITICO) evaluaciones += (double)r.evaluaciones_j * n * n;
+        suma += x[0];
+    }
+    liberar_jacobiano_n(&J);
+    free(x);
+    bench_sumidero += suma;
+    return (ConteoBench){ llamadas, evaluaciones };
+}
+
+int ejecutar_benchmark() {
+    int newton = METODO_NEWTON, broyden = METODO_BROYDEN;
+    
+    bench_encabezado("newtonsistemas");
+    bench_medir("newtonsistemas", "newton_pixel", "iteracion", bench_newton_pixel, NULL);
+    bench_medir("newtonsistemas", "sistema_n_newton", "resolucion", bench_sistema_n, &newton);
+    bench_medir("newtonsistemas", "sistema_n_broyden", "resolucion", bench_sistema_n, &broyden);
+    bench_pie();
+    return EXIT_SUCCESS;
+}
+
+// f1, f2 y Jacobiano de una iteracion del programa principal
+void evaluar_iteracion_2d(double x, double y, double *f1, double *f2, double jacobiano[4]) {
+    *f1 = EVAL_F1(x, y);
+    *f2 = EVAL_F2(x, y);
+    VALIDAR(*f1); VALIDAR(*f2);
+    
+    jacobiano_2d(x, y, jacobiano);
+    VALIDAR(jacobiano[0]); VALIDAR(jacobiano[1]);
+    VALIDAR(jacobiano[2]); VALIDAR(jacobiano[3]);
+}
+
 int main() {
     double x = X_INICIAL, y = Y_INICIAL, error;
     int iteracion = 0;
@@ -140,11 +1066,19 @@ int main() {
     // VALIDACION INICIAL
     // ============================================================================
     printf("Validando parametros iniciales...\n");
+    validacion_iniciar(NIVEL_VALIDACION);
+    validar_magnitud = 1;
+    grafico_iniciar_motor(MOTOR_GRAFICO);
+    cargar_expresiones();
+    
+    if (bench_solicitado()) {
+        return ejecutar_benchmark();
+    }
     
     validar_punto(x, y, "punto inicial");
     
-    double f1_inicial = F1(x, y);
-    double f2_inicial = F2(x, y);
+    double f1_inicial = EVAL_F1(x, y);
+    double f2_inicial = EVAL_F2(x, y);
     VALIDAR(f1_inicial);
     VALIDAR(f2_inicial);
     
@@ -153,6 +1087,14 @@ int main() {
         return EXIT_FAILURE;
     }
     
+    if (MODO_CUENCAS) {
+        return ejecutar_cuencas();
+    }
+    
+    if (MODO_SISTEMA_N) {
+        return ejecutar_sistema_n();
+    }
+    
     printf("EXITO: Validacion inicial exitosa\n");
     printf("   f1(%.1f, %.1f) = %.3f\n", x, y, f1_inicial);
     printf("   f2(%.1f, %.1f) = %.3f\n\n", x, y, f2_inicial);
@@ -170,47 +1112,49 @@ int main() {
     printf("================================================================================\n");
     
     // Archivos
-    FILE *datos_iter = abrir_archivo("sistema_iteraciones.dat", "w");
-    FILE *datos_tray = abrir_archivo("sistema_trayectoria.dat", "w");
+    SalidaDatos *datos_iter = salida_abrir("sistema_iteraciones.dat", FORMATO_SALIDA, "iter x y f1 f2 det_j error",
+                                           "%.0f %.6f %.6f %.6f %.6f %.6e %.6f\n");
+    SalidaDatos *datos_tray = salida_abrir("sistema_trayectoria.dat", FORMATO_SALIDA, "x y", "%.6f %.6f\n");
     
-    fprintf(datos_iter, "# iter x y f1 f2 det_j error\n");
-    fprintf(datos_tray, "%.6f %.6f\n", x, y);
+    if (motor_grafico == MOTOR_SVG) preparar_grafico();
+    SALIDA_FILA(datos_tray, x, y);
+    if (motor_grafico == MOTOR_SVG) grafico_punto(&grafico, SERIE_TRAYECTORIA, x, y);
     
     // ============================================================================
     // METODO DE NEWTON CON VALIDACIONES
     // ============================================================================
     do {
-        double f1 = F1(x, y);
-        double f2 = F2(x, y);
-        VALIDAR(f1); VALIDAR(f2);
-        
-        // Jacobiano
-        double df1_dx = DF1_DX(x, y);
-        double df1_dy = DF1_DY(x, y);
-        double df2_dx = DF2_DX(x, y);
-        double df2_dy = DF2_DY(x, y);
-        
-        VALIDAR(df1_dx); VALIDAR(df1_dy);
-        VALIDAR(df2_dx); VALIDAR(df2_dy);
+        // Funciones y Jacobiano (en el nivel PASO, un lote por iteracion)
+        double f1, f2, jacobiano[4];
+        validacion_abrir_lote();
+        evaluar_iteracion_2d(x, y, &f1, &f2, jacobiano);
+        if (validacion_cerrar_lote("iteracion", iteracion)) {
+            evaluar_iteracion_2d(x, y, &f1, &f2, jacobiano);
+            validacion_fin_repeticion();
+        }
         
-        double det = df1_dx*df2_dy - df1_dy*df2_dx;
+        int pivotes[2];
+        int singular = factorizar_lu(2, jacobiano, pivotes);
+        double det = singular ? 0.0 : determinante_lu(2, jacobiano, pivotes);
         VALIDAR(det);
         
         // Validacion de Jacobiano
-        if (fabs(det) < 1e-15) {
+        if (singular || fabs(det) < 1e-15) {
             printf("================================================================================\n");
             printf("| ERROR CRITICO: Jacobiano singular                                          |\n");
             printf("|   det(J) = %.2e en (%.6f, %.6f)                             |\n", det, x, y);
             printf("|   f1 = %.6f, f2 = %.6f                                       |\n", f1, f2);
             printf("================================================================================\n");
-            fclose(datos_iter);
-            fclose(datos_tray);
+            salida_cerrar(datos_iter);
+            salida_cerrar(datos_tray);
             return EXIT_FAILURE;
         }
         
-        // Resolver sistema
-        double dx = (-f1*df2_dy + f2*df1_dy) / det;
-        double dy = (-df1_dx*f2 + f1*df2_dx) / det;
+        // Resolver J [dx dy] = -[f1 f2]
+        double paso[2] = {-f1, -f2};
+        sustituir_lu(2, jacobiano, pivotes, paso);
+        double dx = paso[0];
+        double dy = paso[1];
         
         VALIDAR(dx); VALIDAR(dy);
         
@@ -222,8 +1166,7 @@ int main() {
                iteracion, x, y, f1, f2, det, error);
         
         // Guardar
-        fprintf(datos_iter, "%d %.6f %.6f %.6f %.6f %.6e %.6f\n", 
-                iteracion, x, y, f1, f2, det, error);
+        SALIDA_FILA(datos_iter, iteracion, x, y, f1, f2, det, error);
         
         // Actualizar con validacion
         double x_nuevo = x + dx;
@@ -234,7 +1177,8 @@ int main() {
         x = x_nuevo;
         y = y_nuevo;
         
-        fprintf(datos_tray, "%.6f %.6f\n", x, y);
+        SALIDA_FILA(datos_tray, x, y);
+        if (motor_grafico == MOTOR_SVG) grafico_punto(&grafico, SERIE_TRAYECTORIA, x, y);
         iteracion++;
         
         // Deteccion de divergencia
@@ -267,16 +1211,16 @@ int main() {
         
     } while (1);
     
-    fclose(datos_iter);
-    fclose(datos_tray);
+    salida_cerrar(datos_iter);
+    salida_cerrar(datos_tray);
     
     // ============================================================================
     // VALIDACION DE SOLUCION FINAL
     // ============================================================================
     printf("\nValidando solucion final...\n");
     
-    double f1_final = F1(x, y);
-    double f2_final = F2(x, y);
+    double f1_final = EVAL_F1(x, y);
+    double f2_final = EVAL_F2(x, y);
     VALIDAR(f1_final); VALIDAR(f2_final);
     
     double error_f1 = fabs(f1_final);
@@ -294,8 +1238,13 @@ int main() {
     // GENERAR GRAFICOS
     // ============================================================================
     generar_datos_curvas();
-    crear_script_gnuplot(x, y);
-    int grafico_ok = ejecutar_gnuplot();
+    int grafico_ok;
+    if (motor_grafico == MOTOR_SVG) {
+        grafico_ok = graficar_svg(x, y);
+    } else {
+        crear_script_gnuplot(x, y);
+        grafico_ok = ejecutar_gnuplot();
+    }
     
     // ============================================================================
     // RESULTADOS FINALES
@@ -312,12 +1261,15 @@ int main() {
     
     printf("\nARCHIVOS GENERADOS:\n");
     printf("-----------------------------------------------------------------\n");
-    printf("  EXITO: sistema_iteraciones.dat -> %d iteraciones\n", iteracion);
-    printf("  EXITO: sistema_trayectoria.dat -> Trayectoria completa\n");
-    printf("  EXITO: sistema_curvas.dat      -> Curvas de ecuaciones\n");
-    printf("  EXITO: sistema_plot.gp         -> Script Gnuplot\n");
+    printf("  EXITO: %s -> %d iteraciones\n", nombre_salida("sistema_iteraciones.dat", FORMATO_SALIDA), iteracion);
+    printf("  EXITO: %s -> Trayectoria completa\n", nombre_salida("sistema_trayectoria.dat", FORMATO_SALIDA));
+    printf("  EXITO: %s -> Curvas de ecuaciones\n", nombre_salida("sistema_curvas.dat", FORMATO_SALIDA));
+    if (motor_grafico == MOTOR_GNUPLOT) {
+        printf("  EXITO: sistema_plot.gp         -> Script Gnuplot\n");
+    }
     if (grafico_ok) {
-        printf("  EXITO: %s       -> Grafico final\n", NOMBRE_GRAFICO);
+        printf("  EXITO: %s       -> Grafico final\n",
+               (motor_grafico == MOTOR_SVG) ? grafico_nombre_svg(NOMBRE_GRAFICO) : NOMBRE_GRAFICO);
     }
     
     printf("\n===============================================================\n");
@@ -0,0 +1,118 @@
+// nucleo.h
+// Nucleo numerico comun: validacion de valores, apertura de archivos, paso
+// de Runge-Kutta 4 para problemas y' = f(t, y) y soporte de subcomandos
+
+#ifndef NUCLEO_H
+#define NUCLEO_H
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <errno.h>
+
+// ============================================================================
+// SUBCOMANDOS (numerico.c)
+// ============================================================================
+// Compilado con -DPROGRAMA_COMO_SUBCOMANDO un programa no termina el proceso
+// con exit(): vuelve al binario multi-comando, que registra el codigo y
+// sigue con el trabajo siguiente. Este encabezado debe ser el primero de los
+// locales para que la redireccion alcance tambien a los demas.
+// ============================================================================
+#ifdef PROGRAMA_COMO_SUBCOMANDO
+void subcomando_salir(int codigo) __attribute__((noreturn));
+#define exit(codigo) subcomando_salir(codigo)
+#endif
+
+#include "validacion.h"
+
+// ============================================================================
+// VALIDACION DE VALORES
+// ============================================================================
+#define NUCLEO_MAGNITUD_MAXIMA  1e100
+
+// 1: VALIDAR tambien rechaza |valor| > NUCLEO_MAGNITUD_MAXIMA (los programas
+// de Newton y derivadas, donde un valor asi ya es una falla)
+int validar_magnitud = 0;
+
+int es_numerico_valido(double valor) {
+    return !(isnan(valor) || isinf(valor) || fabs(valor) > NUCLEO_MAGNITUD_MAXIMA);
+}
+
+void verificar_nan_inf(const char *nombre, double valor, int linea) {
+    if (isnan(valor)) {
+        printf(" ERROR [Linea %d]: %s = NaN\n", linea, nombre);
+        printf("   Causa posible: Operacion matematica invalida\n");
+        exit(EXIT_FAILURE);
+    }
+    if (isinf(valor)) {
+        printf(" ERROR [Linea %d]: %s = Infinito\n", linea, nombre);
+        printf("   Causa posible: Overflow numerico\n");
+        exit(EXIT_FAILURE);
+    }
+    if (validar_magnitud && !es_numerico_valido(valor)) {
+        printf(" ERROR [Linea %d]: %s = %.3e fuera de rango\n", linea, nombre, valor);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Solo activo en el nivel VALIDACION_OPERACION o al repetir un lote que
+// levanto una excepcion IEEE (ver validacion.h)
+#define VALIDAR(variable) do { if (validar_operaciones) verificar_nan_inf(#variable, variable, __LINE__); } while (0)
+
+FILE* abrir_archivo(const char *nombre, const char *modo) {
+    FILE *archivo = fopen(nombre, modo);
+    if (archivo == NULL) {
+        printf(" ERROR: No se pudo abrir '%s' (modo: %s)\n", nombre, modo);
+        printf("   Error del sistema: %d\n", errno);
+        exit(EXIT_FAILURE);
+    }
+    return archivo;
+}
+
+// ============================================================================
+// PROBLEMAS DE VALOR INICIAL
+// ============================================================================
+// Un problema y' = f(t, y) de dimension n se describe con su funcion
+// derivada; una EDO de segundo orden y'' = F(t, y, y') se escribe como el
+// sistema (y, y')' = (y', F). Declarado const en el programa, el compilador
+// puede integrar la derivada dentro del paso.
+// ============================================================================
+#define EDO_MAX_DIMENSION   8
+
+typedef void (*DerivadaEDO)(double t, const double *y, double *dy);
+
+typedef struct {
+    int dimension;
+    DerivadaEDO derivada;
+} ProblemaEDO;
+
+// Un paso de RK4 clasico sobre y[0..n-1], en el orden de operaciones de los
+// pasos escritos a mano (y + h*k1/2, ..., y + h*(k1 + 2*k2 + 2*k3 + k4)/6).
+// Con validar_operaciones revisa cada etapa y el resultado.
+void rk4_paso_edo(const ProblemaEDO *p, double t, double *y, double h) {
+    int n = p->dimension;
+    double k1[EDO_MAX_DIMENSION], k2[EDO_MAX_DIMENSION], k3[EDO_MAX_DIMENSION], k4[EDO_MAX_DIMENSION];
+    double etapa[EDO_MAX_DIMENSION];
+
+    p->derivada(t, y, k1);
+    for (int i = 0; i < n; i++) VALIDAR(k1[i]);
+
+    for (int i = 0; i < n; i++) etapa[i] = y[i] + h*k1[i]/2;
+    p->derivada(t + h/2, etapa, k2);
+    for (int i = 0; i < n; i++) VALIDAR(k2[i]);
+
+    for (int i = 0; i < n; i++) etapa[i] = y[i] + h*k2[i]/2;
+    p->derivada(t + h/2, etapa, k3);
+    for (int i = 0; i < n; i++) VALIDAR(k3[i]);
+
+    for (int i = 0; i < n; i++) etapa[i] = y[i] + h*k3[i];
+    p->derivada(t + h, etapa, k4);
+    for (int i = 0; i < n; i++) VALIDAR(k4[i]);
+
+    for (int i = 0; i < n; i++) {
+        y[i] = y[i] + h*(k1[i] + 2*k2[i] + 2*k3[i] + k4[i])/6;
+        VALIDAR(y[i]);
+    }
+}
+
+#endif
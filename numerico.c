@@ -0,0 +1,327 @@
+// numerico.c
+// Binario multi-comando: ejecuta varios trabajos de los programas del
+// repositorio (Newton, Fourier, derivadas, EDOs) en un solo proceso
+//
+// Cada programa se compila como objeto con su main renombrado y solo ese
+// simbolo visible, de modo que sus globales no chocan entre si:
+//
+//   for p in newtonrhapson newtonsistemas fourier derivadas ecuacion1 ecuacion2 ecuacion3; do
+//       gcc -O2 -fopenmp -c -DPROGRAMA_COMO_SUBCOMANDO -Dmain=programa_$p $p.c -o sub_$p.o
+//       objcopy -G programa_$p sub_$p.o
+//   done
+//   gcc -O2 -fopenmp numerico.c sub_*.o -o numerico -lm
+//
+// Los programas siguen compilando solos como antes (gcc programa.c -lm).
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "benchmark.h"
+
+// ============================================================================
+// PARAMETROS CONFIGURABLES
+// ============================================================================
+#define MAX_TRABAJOS        256
+#define MAX_ASIGNACIONES    32
+#define LARGO_LINEA         4096
+// ============================================================================
+
+int programa_newtonrhapson(void);
+int programa_newtonsistemas(void);
+int programa_fourier(void);
+int programa_derivadas(void);
+int programa_ecuacion1(void);
+int programa_ecuacion2(void);
+int programa_ecuacion3(void);
+
+typedef struct {
+    const char *nombre;
+    const char *programa;       // Alias: el nombre del programa suelto
+    int (*funcion)(void);
+    const char *descripcion;
+} Subcomando;
+
+const Subcomando subcomandos[] = {
+    { "newton",         "newtonrhapson",  programa_newtonrhapson,  "Newton-Raphson en una variable" },
+    { "newton-system",  "newtonsistemas", programa_newtonsistemas, "Newton para sistemas 2x2" },
+    { "fourier",        "fourier",        programa_fourier,        "Serie de Fourier" },
+    { "derivatives",    "derivadas",      programa_derivadas,      "Derivadas numericas" },
+    { "ode1",           "ecuacion1",      programa_ecuacion1,      "EDO de primer orden (RK4, Dormand-Prince)" },
+    { "ode2",           "ecuacion2",      programa_ecuacion2,      "EDO de segundo orden (RK4, simplecticos)" },
+    { "ode-system",     "ecuacion3",      programa_ecuacion3,      "Sistema lineal 2x2 de EDOs" },
+};
+#define N_SUBCOMANDOS   ((int)(sizeof(subcomandos) / sizeof(subcomandos[0])))
+
+// Un trabajo: subcomando mas asignaciones VAR=valor que se exportan al
+// entorno solo mientras corre. DIRECTORIO=ruta cambia ademas el directorio
+// de trabajo (se crea si no existe) para que los archivos de salida de
+// trabajos distintos no se pisen.
+typedef struct {
+    const Subcomando *sub;
+    int n_asignaciones;
+    char *asignaciones[MAX_ASIGNACIONES];
+    int codigo;
+    double segundos;
+} Trabajo;
+
+Trabajo trabajos[MAX_TRABAJOS];
+int n_trabajos = 0;
+
+// ============================================================================
+// SALIDA DE LOS SUBCOMANDOS
+// ============================================================================
+// Con -DPROGRAMA_COMO_SUBCOMANDO, nucleo.h convierte cada exit() de los
+// programas en esta llamada: vuelve al setjmp del trabajo en curso.
+jmp_buf salida_trabajo;
+int codigo_salida = 0;
+int trabajo_en_curso = 0;
+
+void subcomando_salir(int codigo) {
+    fflush(stdout);
+    if (!trabajo_en_curso) exit(codigo);
+    codigo_salida = codigo;
+    longjmp(salida_trabajo, 1);
+}
+
+// ============================================================================
+// LECTURA DE TRABAJOS
+// ============================================================================
+const Subcomando* buscar_subcomando(const char *nombre) {
+    for (int i = 0; i < N_SUBCOMANDOS; i++) {
+        if (strcmp(nombre, subcomandos[i].nombre) == 0 ||
+            strcmp(nombre, subcomandos[i].programa) == 0) {
+            return &subcomandos[i];
+        }
+    }
+    return NULL;
+}
+
+// Agrega una palabra al trabajo actual o abre uno nuevo. Devuelve 0, o -1
+// con el error ya informado.
+int agregar_palabra(const char *palabra, const char *origen) {
+    const Subcomando *sub = buscar_subcomando(palabra);
+
+    if (sub != NULL) {
+        if (n_trabajos >= MAX_TRABAJOS) {
+            fprintf(stderr, "ERROR: Mas de %d trabajos\n", MAX_TRABAJOS);
+            return -1;
+        }
+        Trabajo *t = &trabajos[n_trabajos++];
+        memset(t, 0, sizeof(*t));
+        t->sub = sub;
+        return 0;
+    }
+
+    const char *igual = strchr(palabra, '=');
+    if (igual == NULL || igual == palabra) {
+        fprintf(stderr, "ERROR: '%s' no es un subcomando ni VAR=valor (%s)\n", palabra, origen);
+        return -1;
+    }
+    if (n_trabajos == 0) {
+        fprintf(stderr, "ERROR: '%s' antes del primer subcomando (%s)\n", palabra, origen);
+        return -1;
+    }
+
+    Trabajo *t = &trabajos[n_trabajos - 1];
+    if (t->n_asignaciones >= MAX_ASIGNACIONES) {
+        fprintf(stderr, "ERROR: Mas de %d asignaciones en un trabajo (%s)\n", MAX_ASIGNACIONES, origen);
+        return -1;
+    }
+    t->asignaciones[t->n_asignaciones++] = strdup(palabra);
+    return 0;
+}
+
+// Archivo de trabajos: uno por linea, palabras separadas por espacios, con
+// comillas simples o dobles para valores con espacios y '#' para comentarios:
+//   ode1 EDO_FUNCION="-2*y" SOLUCION_EXACTA="exp(-2*x)" DIRECTORIO=ode1_a
+int leer_archivo_trabajos(const char *nombre) {
+    FILE *archivo = fopen(nombre, "r");
+    if (archivo == NULL) {
+        fprintf(stderr, "ERROR: No se pudo abrir '%s' (errno %d)\n", nombre, errno);
+        return -1;
+    }
+
+    char linea[LARGO_LINEA], palabra[LARGO_LINEA], origen[64];
+    int numero = 0;
+
+    while (fgets(linea, sizeof(linea), archivo) != NULL) {
+        numero++;
+        snprintf(origen, sizeof(origen), "linea %d", numero);
+        int abiertos = n_trabajos;
+        char *c = linea;
+
+        for (;;) {
+            while (*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n') c++;
+            if (*c == '\0' || *c == '#') break;
+
+            int largo = 0;
+            char comilla = 0;
+            while (*c != '\0' && (comilla || (*c != ' ' && *c != '\t' && *c != '\r' && *c != '\n'))) {
+                if (comilla && *c == comilla) {
+                    comilla = 0;
+                } else if (!comilla && (*c == '"' || *c == '\'')) {
+                    comilla = *c;
+                } else {
+                    palabra[largo++] = *c;
+                }
+                c++;
+            }
+            palabra[largo] = '\0';
+
+            if (comilla) {
+                fprintf(stderr, "ERROR: Comilla sin cerrar (%s)\n", origen);
+                fclose(archivo);
+                return -1;
+            }
+            // Cada linea con contenido debe empezar por su subcomando
+            if (n_trabajos == abiertos && buscar_subcomando(palabra) == NULL) {
+                fprintf(stderr, "ERROR: La linea debe empezar con un subcomando (%s)\n", origen);
+                fclose(archivo);
+                return -1;
+            }
+            if (agregar_palabra(palabra, origen) != 0) {
+                fclose(archivo);
+                return -1;
+            }
+        }
+    }
+
+    fclose(archivo);
+    return 0;
+}
+
+// ============================================================================
+// EJECUCION
+// ============================================================================
+// Guarda el valor previo de cada variable del trabajo, aplica las nuevas,
+// corre el programa y restaura el entorno y el directorio.
+void ejecutar_trabajo(Trabajo *t, int indice) {
+    char *previos[MAX_ASIGNACIONES];
+    char directorio_previo[LARGO_LINEA];
+    const char *directorio = NULL;
+
+    printf("\n#############################################################\n");
+    printf("# TRABAJO %d: %s", indice + 1, t->sub->nombre);
+    for (int i = 0; i < t->n_asignaciones; i++) printf(" %s", t->asignaciones[i]);
+    printf("\n#############################################################\n");
+    fflush(stdout);
+
+    for (int i = 0; i < t->n_asignaciones; i++) {
+        char *igual = strchr(t->asignaciones[i], '=');
+        *igual = '\0';
+        const char *previo = getenv(t->asignaciones[i]);
+        previos[i] = previo ? strdup(previo) : NULL;
+        if (strcmp(t->asignaciones[i], "DIRECTORIO") == 0) {
+            directorio = igual + 1;
+        } else {
+            setenv(t->asignaciones[i], igual + 1, 1);
+        }
+        *igual = '=';
+    }
+
+    t->codigo = EXIT_SUCCESS;
+    if (directorio != NULL) {
+        if (getcwd(directorio_previo, sizeof(directorio_previo)) == NULL ||
+            (mkdir(directorio, 0755) != 0 && errno != EEXIST) || chdir(directorio) != 0) {
+            printf(" ERROR: No se pudo usar el directorio '%s' (errno %d)\n", directorio, errno);
+            t->codigo = EXIT_FAILURE;
+        }
+    }
+
+    if (t->codigo == EXIT_SUCCESS) {
+        double inicio = bench_tiempo();
+        codigo_salida = EXIT_SUCCESS;
+        trabajo_en_curso = 1;
+        if (setjmp(salida_trabajo) == 0) {
+            codigo_salida = t->sub->funcion();
+        }
+        trabajo_en_curso = 0;
+        fflush(stdout);
+        t->codigo = codigo_salida;
+        t->segundos = bench_tiempo() - inicio;
+
+        if (directorio != NULL && chdir(directorio_previo) != 0) {
+            printf(" ERROR: No se pudo volver a '%s'\n", directorio_previo);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (int i = 0; i < t->n_asignaciones; i++) {
+        char *igual = strchr(t->asignaciones[i], '=');
+        *igual = '\0';
+        if (strcmp(t->asignaciones[i], "DIRECTORIO") != 0) {
+            if (previos[i] != NULL) {
+                setenv(t->asignaciones[i], previos[i], 1);
+            } else {
+                unsetenv(t->asignaciones[i]);
+            }
+        }
+        *igual = '=';
+        free(previos[i]);
+    }
+}
+
+void imprimir_uso(const char *programa) {
+    printf("Uso: %s subcomando [VAR=valor ...] [subcomando [VAR=valor ...] ...]\n", programa);
+    printf("     %s -f archivo_de_trabajos\n\n", programa);
+    printf("Subcomandos:\n");
+    for (int i = 0; i < N_SUBCOMANDOS; i++) {
+        printf("  %-15s %-16s %s\n", subcomandos[i].nombre, subcomandos[i].programa, subcomandos[i].descripcion);
+    }
+    printf("\nVAR=valor se exporta al entorno solo durante su trabajo (FUNCION,\n");
+    printf("EDO_FUNCION, VALIDACION, GRAFICO, ...); DIRECTORIO=ruta ejecuta el\n");
+    printf("trabajo en ese directorio.\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        imprimir_uso(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        char origen[32];
+        snprintf(origen, sizeof(origen), "argumento %d", i);
+        if (strcmp(argv[i], "-f") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "ERROR: -f requiere un archivo\n");
+                return EXIT_FAILURE;
+            }
+            if (leer_archivo_trabajos(argv[++i]) != 0) return EXIT_FAILURE;
+        } else if (agregar_palabra(argv[i], origen) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (n_trabajos == 0) {
+        fprintf(stderr, "ERROR: No hay trabajos\n");
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < n_trabajos; i++) {
+        ejecutar_trabajo(&trabajos[i], i);
+    }
+
+    int fallidos = 0;
+    printf("\n=============================================================\n");
+    printf("RESUMEN DE TRABAJOS\n");
+    printf("=============================================================\n");
+    printf("%-8s %-15s %-8s %12s\n", "Trabajo", "Subcomando", "Codigo", "Tiempo [s]");
+    for (int i = 0; i < n_trabajos; i++) {
+        printf("%-8d %-15s %-8d %12.4f\n", i + 1, trabajos[i].sub->nombre, trabajos[i].codigo, trabajos[i].segundos);
+        if (trabajos[i].codigo != EXIT_SUCCESS) fallidos++;
+    }
+    printf("-------------------------------------------------------------\n");
+    printf("%d trabajos, %d con error\n", n_trabajos, fallidos);
+
+    for (int i = 0; i < n_trabajos; i++) {
+        for (int j = 0; j < trabajos[i].n_asignaciones; j++) free(trabajos[i].asignaciones[j]);
+    }
+
+    return fallidos ? EXIT_FAILURE : EXIT_SUCCESS;
+}
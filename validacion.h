@@ -0,0 +1,127 @@
+// validacion.h
+// Niveles de validacion numerica: por operacion (VALIDAR), por paso (banderas
+// de excepcion IEEE) o ninguna
+
+#ifndef VALIDACION_H
+#define VALIDACION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fenv.h>
+
+// ============================================================================
+// NIVELES
+// ============================================================================
+// VALIDACION_OPERACION: cada VALIDAR revisa su valor (comportamiento clasico,
+//   una llamada y una rama por operacion).
+// VALIDACION_PASO: los VALIDAR no hacen nada; cada paso o lote se encierra
+//   entre validacion_abrir_lote() y validacion_cerrar_lote(), que mira una
+//   sola vez las banderas IEEE (invalida, division por cero, overflow). Si se
+//   levanto alguna, el llamador repite ese paso desde su estado inicial con
+//   los VALIDAR activos para ubicar la operacion culpable.
+// VALIDACION_NINGUNA: sin comprobaciones.
+//
+// El nivel por defecto es el NIVEL_VALIDACION de cada programa; la variable
+// de entorno VALIDACION lo reemplaza sin recompilar:
+//   VALIDACION=paso ./ecuacion2
+// ============================================================================
+#define VALIDACION_NINGUNA      0
+#define VALIDACION_PASO         1
+#define VALIDACION_OPERACION    2
+
+#define VALIDACION_EXCEPCIONES  (FE_INVALID | FE_DIVBYZERO | FE_OVERFLOW)
+#define VALIDACION_MAX_AVISOS   5       // Repeticiones sin falla que se informan
+
+int nivel_validacion = VALIDACION_OPERACION;
+int validar_operaciones = 1;    // Lo consultan los VALIDAR de cada programa
+int validacion_benignas = 0;    // Repeticiones que no encontraron NaN/Inf
+
+const char* validacion_nombre(int nivel) {
+    switch (nivel) {
+        case VALIDACION_NINGUNA: return "ninguna";
+        case VALIDACION_PASO:    return "paso";
+        default:                 return "operacion";
+    }
+}
+
+void validacion_iniciar(int nivel_por_defecto) {
+    const char *texto = getenv("VALIDACION");
+    nivel_validacion = nivel_por_defecto;
+    validacion_benignas = 0;
+
+    if (texto != NULL && texto[0] != '\0') {
+        if (strcmp(texto, "ninguna") == 0 || strcmp(texto, "0") == 0) {
+            nivel_validacion = VALIDACION_NINGUNA;
+        } else if (strcmp(texto, "paso") == 0 || strcmp(texto, "1") == 0) {
+            nivel_validacion = VALIDACION_PASO;
+        } else if (strcmp(texto, "operacion") == 0 || strcmp(texto, "2") == 0) {
+            nivel_validacion = VALIDACION_OPERACION;
+        } else {
+            printf("ERROR: VALIDACION='%s' desconocida (ninguna, paso u operacion)\n", texto);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    validar_operaciones = (nivel_validacion == VALIDACION_OPERACION);
+    if (nivel_validacion != VALIDACION_OPERACION) {
+        printf("   Validacion: %s\n", validacion_nombre(nivel_validacion));
+    }
+}
+
+// ============================================================================
+// LOTES
+// ============================================================================
+// Uso tipico dentro de un lazo de pasos:
+//
+//   validacion_abrir_lote();
+//   paso(&estado);
+//   if (validacion_cerrar_lote("paso", i)) {
+//       estado = copia;                  // estado al abrir el lote
+//       paso(&estado);                   // VALIDAR activo: corta en la falla
+//       validacion_fin_repeticion();
+//   }
+// ============================================================================
+void validacion_abrir_lote() {
+    if (nivel_validacion == VALIDACION_PASO) feclearexcept(VALIDACION_EXCEPCIONES);
+}
+
+void validacion_describir(int excepciones, char *texto, size_t largo) {
+    snprintf(texto, largo, "%s%s%s",
+             (excepciones & FE_INVALID) ? " invalida" : "",
+             (excepciones & FE_DIVBYZERO) ? " division-por-cero" : "",
+             (excepciones & FE_OVERFLOW) ? " overflow" : "");
+}
+
+// 1 si hay que repetir el lote: deja VALIDAR activo hasta validacion_fin_repeticion
+int validacion_cerrar_lote(const char *lote, long indice) {
+    if (nivel_validacion != VALIDACION_PASO) return 0;
+
+    int excepciones = fetestexcept(VALIDACION_EXCEPCIONES);
+    if (excepciones == 0) return 0;
+
+    if (validacion_benignas < VALIDACION_MAX_AVISOS) {
+        char texto[64];
+        validacion_describir(excepciones, texto, sizeof(texto));
+        printf(" VALIDACION: excepcion IEEE (%s ) en %s %ld; repitiendo con validacion por operacion\n",
+               texto, lote, indice);
+    }
+    validar_operaciones = 1;
+    return 1;
+}
+
+// La repeticion termino sin que VALIDAR encontrara NaN/Inf: la excepcion
+// fue intermedia (p. ej. un overflow que el calculo absorbio)
+void validacion_fin_repeticion() {
+    validacion_benignas++;
+    if (validacion_benignas <= VALIDACION_MAX_AVISOS) {
+        printf(" VALIDACION: la repeticion no encontro valores invalidos; se continua\n");
+    }
+    if (validacion_benignas == VALIDACION_MAX_AVISOS) {
+        printf(" VALIDACION: se omiten los avisos de excepciones siguientes\n");
+    }
+    validar_operaciones = 0;
+    feclearexcept(VALIDACION_EXCEPCIONES);
+}
+
+#endif